@@ -0,0 +1,186 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "AllocationCounter.h"
+#include "HAL/MallocBase.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	thread_local uint64 NumberOfAllocations = 0;
+
+	/**
+	* Allocator proxy which counts allocations of each thread and forwards
+	* everything to the allocator it's installed over
+	*/
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			NumberOfAllocations++;
+
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count,
+			uint32 Alignment) override
+		{
+			NumberOfAllocations++;
+
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			InnerMalloc->Free(Original);
+		}
+
+		virtual bool GetAllocationSize(void* Original,
+			SIZE_T& SizeOut) override
+		{
+			return InnerMalloc->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return InnerMalloc->QuantizeSize(Count, Alignment);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			InnerMalloc->Trim(bTrimThreadCaches);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			InnerMalloc->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void UpdateStats() override
+		{
+			InnerMalloc->UpdateStats();
+		}
+
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+		{
+			InnerMalloc->GetAllocatorStats(OutStats);
+		}
+
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+		{
+			InnerMalloc->DumpAllocatorStats(Ar);
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return InnerMalloc->ValidateHeap();
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return InnerMalloc->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return TEXT("AllocationCounter");
+		}
+
+		FMalloc* InnerMalloc = nullptr;
+	};
+
+	FCriticalSection CriticalSection;
+
+	//Count of alive counters
+	int32 NumberOfCounters = 0;
+
+	//Is created on the first installation and is never destroyed
+	FCountingMalloc* CountingMalloc = nullptr;
+
+	//Whether the proxy is in the chain of `GMalloc`
+	bool bIsInstalled = false;
+}
+
+FAllocationCounter::FAllocationCounter()
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		NumberOfCounters++;
+		if (!bIsInstalled)
+		{
+			if (CountingMalloc == nullptr)
+			{
+				CountingMalloc = new FCountingMalloc();
+			}
+
+			CountingMalloc->InnerMalloc = GMalloc;
+			FPlatformMisc::MemoryBarrier();
+			GMalloc = CountingMalloc;
+			bIsInstalled = true;
+		}
+	}
+
+	InitialNumberOfAllocations = NumberOfAllocations;
+}
+
+FAllocationCounter::~FAllocationCounter()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	NumberOfCounters--;
+
+	// if something has been installed over the proxy in the meantime, it
+	// keeps forwarding to the proxy, so the proxy stays in place and keeps
+	// counting until a later counter finds it on top again
+	if (NumberOfCounters == 0 && GMalloc == CountingMalloc)
+	{
+		GMalloc = CountingMalloc->InnerMalloc;
+		bIsInstalled = false;
+	}
+}
+
+uint64 FAllocationCounter::GetNumberOfAllocations() const
+{
+	return NumberOfAllocations - InitialNumberOfAllocations;
+}
+
+uint64 FAllocationCounter::GetNumberOfThreadAllocations()
+{
+	return NumberOfAllocations;
+}
+
+bool FAllocationCounter::IsInstalled()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	return NumberOfCounters > 0;
+}
+
+FAllocationCounter::FMeasurement FAllocationCounter::Measure(
+	int32 NumberOfCalls, TFunctionRef<void()> Function)
+{
+	// warm up caches and lazy initialization
+	Function();
+
+	FAllocationCounter Counter;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfCalls; i++)
+	{
+		Function();
+	}
+	double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	FMeasurement Measurement;
+	Measurement.NanosecondsPerCall = ElapsedTime * 1e9 / NumberOfCalls;
+	Measurement.AllocationsPerCall =
+		static_cast<double>(Counter.GetNumberOfAllocations()) / NumberOfCalls;
+
+	return Measurement;
+}
@@ -0,0 +1,73 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Counts heap allocations made through `GMalloc`, is meant for benchmarks
+*
+* While at least one counter is alive, a counting proxy is installed as
+* `GMalloc` over the original allocator. The last counter to be destroyed
+* restores the original one. The proxy itself is never destroyed, so a thread
+* which has read `GMalloc` right before it's restored still calls into a
+* valid object. Installation and restoration are serialized
+*
+* Allocations are counted per thread: a counter reports the ones made by the
+* thread which has created it
+*/
+class FAllocationCounter
+{
+public:
+	//Result of `Measure()`
+	struct FMeasurement
+	{
+		double NanosecondsPerCall = 0.0;
+
+		double AllocationsPerCall = 0.0;
+	};
+
+	/**
+	* Installs the counting proxy unless it's installed already
+	*/
+	FAllocationCounter();
+
+	/**
+	* Restores the original allocator if it's the last counter
+	*/
+	~FAllocationCounter();
+
+	FAllocationCounter(const FAllocationCounter&) = delete;
+
+	FAllocationCounter& operator=(const FAllocationCounter&) = delete;
+
+	/**
+	* @return Count of allocations made by the creating thread since the
+	* counter has been created
+	*/
+	uint64 GetNumberOfAllocations() const;
+
+	/**
+	* Returns the running count of allocations made by the calling thread
+	* while the proxy has been installed. Only differences between two calls
+	* are meaningful, the count doesn't change while no counter is alive
+	*
+	* @return Count of allocations of the calling thread
+	*/
+	static uint64 GetNumberOfThreadAllocations();
+
+	/**
+	* @return `true` if a counter is alive, that is allocations are counted
+	*/
+	static bool IsInstalled();
+
+	/**
+	* Calls the function `NumberOfCalls` times, after one warm-up call, and
+	* measures the time and the allocations of a call
+	*/
+	static FMeasurement Measure(int32 NumberOfCalls,
+		TFunctionRef<void()> Function);
+
+private:
+	uint64 InitialNumberOfAllocations;
+};
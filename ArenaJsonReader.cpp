@@ -0,0 +1,662 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "ArenaJsonReader.h"
+#include "RequestLoaderLog.h"
+#include "RequestArena.h"
+#include "Utf8JsonFieldReader.h"
+#include "Dom/JsonObject.h"
+#include "JsonObjectConverter.h"
+#include "JsonObjectWrapper.h"
+
+namespace
+{
+    //Nesting deeper than that is treated as malformed, so that a hostile
+    //request can't exhaust the stack
+    constexpr int32 MaxDepth = 512;
+
+    bool IsWhitespace(uint8 Character)
+    {
+        return Character == ' ' || Character == '\t' || Character == '\n' ||
+            Character == '\r';
+    }
+
+    bool IsDigit(uint8 Character)
+    {
+        return Character >= '0' && Character <= '9';
+    }
+
+    /**
+     * Recursive descent parser of RFC 8259 JSON, strings are only checked
+     * for unescaped control characters here, their escape sequences are
+     * checked when they're decoded
+     */
+    class FParser
+    {
+    public:
+        FParser(TArrayView<const uint8> Contents, FRequestArena& Arena)
+            : Contents(Contents), Arena(Arena) {}
+
+        FArenaJsonValue* ParseDocument()
+        {
+            FArenaJsonValue* Value = ParseValue(0);
+            SkipWhitespace();
+
+            return Offset == Contents.Num() ? Value : nullptr;
+        }
+
+    private:
+        void SkipWhitespace()
+        {
+            while (Offset < Contents.Num() && IsWhitespace(Contents[Offset]))
+            {
+                Offset++;
+            }
+        }
+
+        bool Skip(uint8 Character)
+        {
+            if (Offset < Contents.Num() && Contents[Offset] == Character)
+            {
+                Offset++;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        bool SkipDigits()
+        {
+            int32 Start = Offset;
+            while (Offset < Contents.Num() && IsDigit(Contents[Offset]))
+            {
+                Offset++;
+            }
+
+            return Offset > Start;
+        }
+
+        FArenaJsonValue* ParseValue(int32 Depth)
+        {
+            SkipWhitespace();
+            if (Offset >= Contents.Num() || Depth > MaxDepth)
+            {
+                return nullptr;
+            }
+
+            FArenaJsonValue* Value = Arena.New<FArenaJsonValue>();
+            bool bIsParsed;
+            switch (Contents[Offset])
+            {
+            case '{':
+                bIsParsed = ParseContainer(*Value, EJson::Object, '}', Depth);
+                break;
+            case '[':
+                bIsParsed = ParseContainer(*Value, EJson::Array, ']', Depth);
+                break;
+            case '"':
+                Value->Type = EJson::String;
+                bIsParsed = ParseString(Value->Raw);
+                break;
+            case 't':
+                Value->Type = EJson::Boolean;
+                bIsParsed = ParseLiteral("true", Value->Raw);
+                break;
+            case 'f':
+                Value->Type = EJson::Boolean;
+                bIsParsed = ParseLiteral("false", Value->Raw);
+                break;
+            case 'n':
+                Value->Type = EJson::Null;
+                bIsParsed = ParseLiteral("null", Value->Raw);
+                break;
+            default:
+                Value->Type = EJson::Number;
+                bIsParsed = ParseNumber(Value->Raw);
+                break;
+            }
+
+            return bIsParsed ? Value : nullptr;
+        }
+
+        bool ParseContainer(FArenaJsonValue& Value, EJson Type,
+            uint8 Closing, int32 Depth)
+        {
+            Value.Type = Type;
+            Offset++;
+
+            SkipWhitespace();
+            if (Skip(Closing))
+            {
+                return true;
+            }
+
+            //Children are appended at the tail, so that they're in the
+            //order they're written
+            FArenaJsonValue** Tail = &Value.FirstChild;
+            do
+            {
+                TArrayView<const uint8> Key;
+                if (Type == EJson::Object)
+                {
+                    SkipWhitespace();
+                    if (!ParseString(Key))
+                    {
+                        return false;
+                    }
+
+                    SkipWhitespace();
+                    if (!Skip(':'))
+                    {
+                        return false;
+                    }
+                }
+
+                FArenaJsonValue* Child = ParseValue(Depth + 1);
+                if (Child == nullptr)
+                {
+                    return false;
+                }
+
+                Child->Key = Key;
+                *Tail = Child;
+                Tail = &Child->NextSibling;
+                Value.NumberOfChildren++;
+
+                SkipWhitespace();
+            }
+            while (Skip(','));
+
+            return Skip(Closing);
+        }
+
+        bool ParseString(TArrayView<const uint8>& OutRaw)
+        {
+            if (!Skip('"'))
+            {
+                return false;
+            }
+
+            int32 Start = Offset;
+            while (Offset < Contents.Num())
+            {
+                uint8 Character = Contents[Offset];
+                if (Character == '"')
+                {
+                    OutRaw = Contents.Slice(Start, Offset - Start);
+                    Offset++;
+
+                    return true;
+                }
+
+                if (Character < 0x20)
+                {
+                    return false;
+                }
+
+                //The escaped character is skipped, so that an escaped
+                //quote doesn't end the string
+                Offset += Character == '\\' ? 2 : 1;
+            }
+
+            return false;
+        }
+
+        bool ParseLiteral(const ANSICHAR* Literal,
+            TArrayView<const uint8>& OutRaw)
+        {
+            int32 Length = FCStringAnsi::Strlen(Literal);
+            if (Offset + Length > Contents.Num() ||
+                FMemory::Memcmp(Contents.GetData() + Offset, Literal,
+                    Length) != 0)
+            {
+                return false;
+            }
+
+            OutRaw = Contents.Slice(Offset, Length);
+            Offset += Length;
+
+            return true;
+        }
+
+        //`-?digits(.digits)?([eE][+-]?digits)?`
+        bool ParseNumber(TArrayView<const uint8>& OutRaw)
+        {
+            int32 Start = Offset;
+
+            Skip('-');
+            if (!SkipDigits())
+            {
+                return false;
+            }
+
+            if (Skip('.') && !SkipDigits())
+            {
+                return false;
+            }
+
+            if (Skip('e') || Skip('E'))
+            {
+                if (!Skip('+'))
+                {
+                    Skip('-');
+                }
+
+                if (!SkipDigits())
+                {
+                    return false;
+                }
+            }
+
+            OutRaw = Contents.Slice(Start, Offset - Start);
+
+            return true;
+        }
+
+        TArrayView<const uint8> Contents;
+
+        FRequestArena& Arena;
+
+        int32 Offset = 0;
+    };
+
+    /**
+     * Copies a number into a null-terminated buffer the C conversions
+     * accept, numbers are ASCII so no conversion is needed
+     */
+    using FNumberBuffer = TArray<ANSICHAR, TInlineAllocator<64>>;
+
+    void ToNumberBuffer(TArrayView<const uint8> Raw, FNumberBuffer& OutBuffer)
+    {
+        OutBuffer.SetNumUninitialized(Raw.Num() + 1);
+        FMemory::Memcpy(OutBuffer.GetData(), Raw.GetData(), Raw.Num());
+        OutBuffer[Raw.Num()] = '\0';
+    }
+
+    double ToDouble(TArrayView<const uint8> Raw)
+    {
+        FNumberBuffer Buffer;
+        ToNumberBuffer(Raw, Buffer);
+
+        return FCStringAnsi::Atod(Buffer.GetData());
+    }
+
+    /**
+     * Integers are read exactly, unlike `FJsonValue` which holds every
+     * number as a double, fractions are truncated the same way as there
+     */
+    int64 ToInteger(TArrayView<const uint8> Raw)
+    {
+        FNumberBuffer Buffer;
+        ToNumberBuffer(Raw, Buffer);
+
+        for (uint8 Character : Raw)
+        {
+            if (Character == '.' || Character == 'e' || Character == 'E')
+            {
+                return static_cast<int64>(FCStringAnsi::Atod(
+                    Buffer.GetData()));
+            }
+        }
+
+        return FCStringAnsi::Atoi64(Buffer.GetData());
+    }
+
+    bool Contains(TArrayView<const uint8> Raw, uint8 Character)
+    {
+        return FMemory::Memchr(Raw.GetData(), Character, Raw.Num()) !=
+            nullptr;
+    }
+
+    /**
+     * Makes a name of a key or of a string, without a temporary string
+     * unless there are escape sequences
+     *
+     * @return `false` if an escape sequence is malformed
+     */
+    bool ToName(TArrayView<const uint8> Raw, EFindName FindType,
+        FName& OutName)
+    {
+        if (Contains(Raw, '\\'))
+        {
+            FString String;
+            if (!FUtf8JsonFieldReader::DecodeString(Raw, String))
+            {
+                return false;
+            }
+
+            OutName = FName(*String, FindType);
+
+            return true;
+        }
+
+        FUTF8ToTCHAR Converter(
+            reinterpret_cast<const ANSICHAR*>(Raw.GetData()), Raw.Num());
+        OutName = FName(Converter.Length(), Converter.Get(), FindType);
+
+        return true;
+    }
+
+    /**
+     * Builds a DOM of the value, for the properties converted by
+     * `FJsonObjectConverter`
+     */
+    TSharedPtr<FJsonValue> ToJsonValue(const FArenaJsonValue& Value)
+    {
+        switch (Value.Type)
+        {
+        case EJson::String:
+        {
+            FString String;
+            if (!FUtf8JsonFieldReader::DecodeString(Value.Raw, String))
+            {
+                return nullptr;
+            }
+
+            return MakeShared<FJsonValueString>(MoveTemp(String));
+        }
+        case EJson::Number:
+            return MakeShared<FJsonValueNumber>(ToDouble(Value.Raw));
+        case EJson::Boolean:
+            return MakeShared<FJsonValueBoolean>(Value.Raw[0] == 't');
+        case EJson::Array:
+        {
+            TArray<TSharedPtr<FJsonValue>> Elements;
+            Elements.Reserve(Value.NumberOfChildren);
+            for (const FArenaJsonValue* Element = Value.FirstChild;
+                Element != nullptr; Element = Element->NextSibling)
+            {
+                TSharedPtr<FJsonValue> JsonElement = ToJsonValue(*Element);
+                if (!JsonElement.IsValid())
+                {
+                    return nullptr;
+                }
+
+                Elements.Add(MoveTemp(JsonElement));
+            }
+
+            return MakeShared<FJsonValueArray>(Elements);
+        }
+        case EJson::Object:
+        {
+            TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+            for (const FArenaJsonValue* Field = Value.FirstChild;
+                Field != nullptr; Field = Field->NextSibling)
+            {
+                FString Key;
+                TSharedPtr<FJsonValue> JsonField = ToJsonValue(*Field);
+                if (!FUtf8JsonFieldReader::DecodeString(Field->Key, Key) ||
+                    !JsonField.IsValid())
+                {
+                    return nullptr;
+                }
+
+                Object->SetField(Key, MoveTemp(JsonField));
+            }
+
+            return MakeShared<FJsonValueObject>(Object);
+        }
+        default:
+            return MakeShared<FJsonValueNull>();
+        }
+    }
+
+    /**
+     * Tells whether a field of an object is followed by another one of the
+     * same name, which replaces it the same way it does in `FJsonObject`.
+     * Otherwise the fields of both would be merged into a struct
+     */
+    bool IsReplacedLater(const FArenaJsonValue& Field)
+    {
+        for (const FArenaJsonValue* Later = Field.NextSibling;
+            Later != nullptr; Later = Later->NextSibling)
+        {
+            if (Later->Key.Num() != Field.Key.Num())
+            {
+                continue;
+            }
+
+            int32 i = 0;
+            while (i < Field.Key.Num() &&
+                FChar::ToLower(static_cast<TCHAR>(Later->Key[i])) ==
+                    FChar::ToLower(static_cast<TCHAR>(Field.Key[i])))
+            {
+                i++;
+            }
+
+            if (i == Field.Key.Num())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ToPropertyWithConverter(const FArenaJsonValue& Value,
+        FProperty* Property, void* OutValue)
+    {
+        TSharedPtr<FJsonValue> JsonValue = ToJsonValue(Value);
+
+        return JsonValue.IsValid() &&
+            FJsonObjectConverter::JsonValueToUProperty(JsonValue, Property,
+                OutValue, 0, 0);
+    }
+
+    bool ToProperty(const FArenaJsonValue& Value, FProperty* Property,
+        void* OutValue)
+    {
+        if (Property->ArrayDim != 1)
+        {
+            return ToPropertyWithConverter(Value, Property, OutValue);
+        }
+
+        if (FNumericProperty* NumericProperty =
+            CastField<FNumericProperty>(Property))
+        {
+            if (Value.Type != EJson::Number || NumericProperty->IsEnum())
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            if (NumericProperty->IsFloatingPoint())
+            {
+                NumericProperty->SetFloatingPointPropertyValue(OutValue,
+                    ToDouble(Value.Raw));
+            }
+            else
+            {
+                NumericProperty->SetIntPropertyValue(OutValue,
+                    ToInteger(Value.Raw));
+            }
+
+            return true;
+        }
+
+        if (FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+        {
+            if (Value.Type != EJson::Boolean)
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            BoolProperty->SetPropertyValue(OutValue, Value.Raw[0] == 't');
+
+            return true;
+        }
+
+        if (FStrProperty* StrProperty = CastField<FStrProperty>(Property))
+        {
+            if (Value.Type != EJson::String)
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            //Decoded straight into the property, it's the only allocation
+            return FUtf8JsonFieldReader::DecodeString(Value.Raw,
+                *StrProperty->GetPropertyValuePtr(OutValue));
+        }
+
+        if (FNameProperty* NameProperty = CastField<FNameProperty>(Property))
+        {
+            if (Value.Type != EJson::String)
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            return ToName(Value.Raw, FNAME_Add,
+                *NameProperty->GetPropertyValuePtr(OutValue));
+        }
+
+        if (FTextProperty* TextProperty = CastField<FTextProperty>(Property))
+        {
+            if (Value.Type != EJson::String)
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            //The text is assumed to be localized already, the same as
+            //`FJsonObjectConverter` assumes
+            FString String;
+            if (!FUtf8JsonFieldReader::DecodeString(Value.Raw, String))
+            {
+                return false;
+            }
+
+            TextProperty->SetPropertyValue(OutValue,
+                FText::FromString(MoveTemp(String)));
+
+            return true;
+        }
+
+        if (FStructProperty* StructProperty =
+            CastField<FStructProperty>(Property))
+        {
+            if (Value.Type != EJson::Object ||
+                StructProperty->Struct == FJsonObjectWrapper::StaticStruct())
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            return FArenaJsonReader::ToStruct(Value, StructProperty->Struct,
+                OutValue);
+        }
+
+        if (FArrayProperty* ArrayProperty =
+            CastField<FArrayProperty>(Property))
+        {
+            if (Value.Type != EJson::Array)
+            {
+                return ToPropertyWithConverter(Value, Property, OutValue);
+            }
+
+            //The count of the elements is known, so the array is allocated
+            //once and the elements are converted in place
+            FScriptArrayHelper Helper(ArrayProperty, OutValue);
+            Helper.EmptyAndAddValues(Value.NumberOfChildren);
+
+            int32 i = 0;
+            for (const FArenaJsonValue* Element = Value.FirstChild;
+                Element != nullptr; Element = Element->NextSibling, i++)
+            {
+                if (!ToProperty(*Element, ArrayProperty->Inner,
+                    Helper.GetRawPtr(i)))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        return ToPropertyWithConverter(Value, Property, OutValue);
+    }
+}
+
+const FArenaJsonValue* FArenaJsonReader::Parse(
+    TArrayView<const uint8> Contents, FRequestArena& Arena)
+{
+    return FParser(Contents, Arena).ParseDocument();
+}
+
+const FArenaJsonValue* FArenaJsonReader::FindField(
+    const FArenaJsonValue& Object, const TCHAR* Key)
+{
+    int32 KeyLength = FCString::Strlen(Key);
+
+    const FArenaJsonValue* Result = nullptr;
+    for (const FArenaJsonValue* Field = Object.FirstChild; Field != nullptr;
+        Field = Field->NextSibling)
+    {
+        if (Field->Key.Num() != KeyLength)
+        {
+            continue;
+        }
+
+        int32 i = 0;
+        while (i < KeyLength &&
+            FChar::ToLower(static_cast<TCHAR>(Field->Key[i])) ==
+                FChar::ToLower(Key[i]))
+        {
+            i++;
+        }
+
+        //Later fields of the same name replace the earlier ones, the same
+        //way they do in `FJsonObject`
+        if (i == KeyLength)
+        {
+            Result = Field;
+        }
+    }
+
+    return Result;
+}
+
+bool FArenaJsonReader::TryGetString(const FArenaJsonValue& Value,
+    FString& OutValue)
+{
+    return Value.Type == EJson::String &&
+        FUtf8JsonFieldReader::DecodeString(Value.Raw, OutValue);
+}
+
+bool FArenaJsonReader::ToStruct(const FArenaJsonValue& Object,
+    const UStruct* Struct, void* OutStruct)
+{
+    if (Object.Type != EJson::Object)
+    {
+        return false;
+    }
+
+    for (const FArenaJsonValue* Field = Object.FirstChild; Field != nullptr;
+        Field = Field->NextSibling)
+    {
+        //A key which isn't a name yet can't be a name of a property
+        FName Name;
+        if (!ToName(Field->Key, FNAME_Find, Name) || Name.IsNone())
+        {
+            continue;
+        }
+
+        FProperty* Property = Struct->FindPropertyByName(Name);
+        if (Property == nullptr || IsReplacedLater(*Field))
+        {
+            continue;
+        }
+
+        if (!ToProperty(*Field, Property,
+            Property->ContainerPtrToValuePtr<void>(OutStruct)))
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("The `%s` field doesn't match the `%s` property of "
+                     "`%s`"), *Name.ToString(), *Property->GetName(),
+                *Struct->GetName());
+
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,95 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+
+class FRequestArena;
+
+/**
+ * Value of a JSON document parsed into an arena
+ *
+ * Strings, numbers and keys aren't copied, they refer to the parsed bytes
+ * and are converted only when they're read
+ */
+struct FArenaJsonValue
+{
+    EJson Type = EJson::None;
+
+    //Key of a field of an object as it's written, without the quotes and
+    //with escape sequences kept, empty for elements of arrays
+    TArrayView<const uint8> Key;
+
+    //Bytes of a string without the quotes and with escape sequences kept,
+    //of a number or of a literal, empty for arrays and objects
+    TArrayView<const uint8> Raw;
+
+    //First element of an array or first field of an object
+    FArenaJsonValue* FirstChild = nullptr;
+
+    //Next element or field of the array or the object the value is in
+    FArenaJsonValue* NextSibling = nullptr;
+
+    int32 NumberOfChildren = 0;
+};
+
+/**
+ * Parses JSON into a tree of `FArenaJsonValue` allocated in an arena and
+ * converts the tree straight into structs
+ *
+ * Compared to `FJsonSerializer` with `FJsonObjectConverter` nothing of the
+ * intermediate state is allocated on the heap: there are neither shared
+ * pointers nor maps nor copies of the strings. The struct gets exactly one
+ * allocation per string and per array, since arrays are sized once from
+ * the count of their elements
+ *
+ * Properties without a direct counterpart in JSON (enums, maps, sets,
+ * objects, static arrays, structs imported from strings, ...) are handed
+ * over to `FJsonObjectConverter`, only the value of such a property gets a
+ * DOM
+ */
+class FArenaJsonReader
+{
+public:
+    /**
+     * @param Contents UTF-8 encoded JSON without BOM, must outlive the tree
+     * @param Arena Arena the tree is allocated in
+     * @return The root of the tree or `nullptr` if the contents are
+     * malformed, in which case the arena may hold a part of the tree
+     */
+    static const FArenaJsonValue* Parse(TArrayView<const uint8> Contents,
+        FRequestArena& Arena);
+
+    /**
+     * Looks for a field of an object
+     *
+     * @param Key Name of the field, must be ASCII, is matched
+     * case-insensitively
+     * @return The last field of that name or `nullptr`
+     */
+    static const FArenaJsonValue* FindField(const FArenaJsonValue& Object,
+        const TCHAR* Key);
+
+    /**
+     * @param OutValue Unescaped string, is set only on success
+     * @return `false` if the value isn't a string or is malformed
+     */
+    static bool TryGetString(const FArenaJsonValue& Value, FString& OutValue);
+
+    /**
+     * Sets the properties of a struct from the fields of an object the way
+     * `FJsonObjectConverter::JsonObjectToUStruct()` does: fields are matched
+     * with properties by name, fields without a property are ignored,
+     * properties without a field are left as they are and of fields of the
+     * same name only the last one is used
+     *
+     * @return `false` if a field doesn't match the type of its property, the
+     * struct may be partially set then
+     */
+    static bool ToStruct(const FArenaJsonValue& Object, const UStruct* Struct,
+        void* OutStruct);
+};
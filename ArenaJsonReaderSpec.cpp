@@ -0,0 +1,166 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "JsonObjectConverter.h"
+#include "ExtractionRequest.h"
+#include "ArenaJsonReader.h"
+#include "RequestArena.h"
+#include "JsonRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+#include "RequestSpecTypes.h"
+
+namespace
+{
+    TUniquePtr<FExtractionRequest> ExtractRequest(
+        TArrayView<const uint8> Contents, FRequestArena* Arena)
+    {
+        FJsonRequestDeserializer Deserializer;
+        Deserializer.SetArena(Arena);
+        Deserializer.DeserializeView(Contents);
+
+        return Deserializer.ExtractRequest();
+    }
+}
+
+/**
+ * Converts the same documents through the DOM and through the arena and
+ * expects the same structs from both, `FJsonObjectConverter` is the
+ * reference the arena path has to match
+ */
+BEGIN_DEFINE_SPEC(FArenaJsonReaderSpec,
+                  "XYZProduct.Loading.ArenaJsonReader",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+void CheckSameAsDom(const FString& What, const FString& Json)
+{
+    FRequestSpecDocument DomDocument;
+    TSharedPtr<FJsonObject> Object;
+    bool bIsDomConverted = FJsonSerializer::Deserialize(
+        TJsonReaderFactory<>::Create(Json), Object) && Object.IsValid() &&
+        FJsonObjectConverter::JsonObjectToUStruct(Object.ToSharedRef(),
+            &DomDocument);
+
+    TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(Json);
+    FRequestArena Arena;
+    FRequestSpecDocument ArenaDocument;
+    const FArenaJsonValue* Root = FArenaJsonReader::Parse(Contents, Arena);
+    bool bIsArenaConverted = Root != nullptr && FArenaJsonReader::ToStruct(
+        *Root, FRequestSpecDocument::StaticStruct(), &ArenaDocument);
+
+    TestTrue(What + TEXT(": expecting the DOM to convert the document"),
+        bIsDomConverted);
+    TestTrue(What + TEXT(": expecting the arena to convert the document"),
+        bIsArenaConverted);
+    const UStruct* Struct = FRequestSpecDocument::StaticStruct();
+    TestEqual(What + TEXT(": expecting the same document from both"),
+        FRequestSpecHelpers::Export(Struct, &ArenaDocument),
+        FRequestSpecHelpers::Export(Struct, &DomDocument));
+}
+
+END_DEFINE_SPEC(FArenaJsonReaderSpec)
+
+void FArenaJsonReaderSpec::Define()
+{
+    It("Scalars",
+        [this]()
+        {
+            CheckSameAsDom(TEXT("Scalars"), TEXT("{\"Name\": \"Crate\", "
+                "\"Category\": \"Props\", \"Description\": \"A crate\", "
+                "\"bIsEnabled\": true, \"Count\": -42, "
+                "\"Weight\": 1.25e3, \"Unknown\": [1, {\"a\": null}]}"));
+        }
+    );
+
+    It("Escape sequences",
+        [this]()
+        {
+            CheckSameAsDom(TEXT("Escape sequences"), TEXT("{\"Name\": "
+                "\"quote \\\" backslash \\\\ slash \\/ \\b\\f\\n\\r\\t "
+                "\\u00e9\\u65e5 \\ud83d\\ude00\", \"Category\": "
+                "\"Tab\\tName\", \"Description\": \"Line\\nbreak\"}"));
+        }
+    );
+
+    It("Non-ASCII text",
+        [this]()
+        {
+            //Written as universal character names, so that the source
+            //stays ASCII, the document holds them as raw UTF-8
+            CheckSameAsDom(TEXT("Non-ASCII text"), TEXT("{\"Name\": "
+                "\"Za\u017c\u00f3\u0142\u0107 g\u0119\u015bl\u0105\", "
+                "\"Category\": \"\u65e5\u672c\u8a9e\", \"Description\": "
+                "\"\U0001F600 \u00e9moji\", \"\u041a\u043b\u044e\u0447\": "
+                "\"ignored\"}"));
+        }
+    );
+
+    It("Duplicate keys",
+        [this]()
+        {
+            //The last field of a name wins, also over a struct whose
+            //fields would otherwise be merged
+            CheckSameAsDom(TEXT("Duplicate keys"), TEXT("{\"Count\": 1, "
+                "\"Main\": {\"Path\": \"/Game/A\", \"Size\": 7}, "
+                "\"Elements\": [{\"Path\": \"/Game/B\"}], "
+                "\"Main\": {\"Path\": \"/Game/C\"}, \"Elements\": [], "
+                "\"COUNT\": 3}"));
+        }
+    );
+
+    It("Enums",
+        [this]()
+        {
+            CheckSameAsDom(TEXT("Enums"), TEXT("{\"Kind\": \"Sound\", "
+                "\"Kinds\": [\"Mesh\", \"Texture\", 2], "
+                "\"Main\": {\"Kind\": \"Mesh\"}}"));
+        }
+    );
+
+    It("Nested arrays of structs",
+        [this]()
+        {
+            CheckSameAsDom(TEXT("Nested arrays of structs"), TEXT("{"
+                "\"Elements\": [{\"Path\": \"/Game/A\", \"Size\": 1, "
+                "\"Kind\": \"Mesh\", \"Tags\": [\"Wood\", \"Small\"]}, "
+                "{\"Path\": \"/Game/B\", \"Tags\": []}], "
+                "\"Groups\": [{\"Name\": \"First\", \"Elements\": ["
+                "{\"Path\": \"/Game/C\", \"Size\": 3}, "
+                "{\"Path\": \"/Game/D\", \"Kind\": \"Sound\"}]}, "
+                "{\"Name\": \"Empty\", \"Elements\": []}, {}], "
+                "\"Limits\": {\"Textures\": 10, \"Meshes\": 20}}"));
+        }
+    );
+
+    It("Request through the deserializer",
+        [this]()
+        {
+            FExtractionRequest Request;
+            FRequestSpecHelpers::ResizeArrays(Request, 3);
+            TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(
+                FRequestSpecHelpers::ToJson(Request));
+
+            FRequestArena Arena;
+            TUniquePtr<FExtractionRequest> DomRequest =
+                ExtractRequest(Contents, nullptr);
+            TUniquePtr<FExtractionRequest> ArenaRequest =
+                ExtractRequest(Contents, &Arena);
+
+            if (TestTrue(TEXT("Expecting both requests to be extracted"),
+                DomRequest.IsValid() && ArenaRequest.IsValid()))
+            {
+                TestEqual(TEXT("Expecting the same request from both"),
+                    FRequestSpecHelpers::Export(*ArenaRequest),
+                    FRequestSpecHelpers::Export(*DomRequest));
+            }
+        }
+    );
+}
@@ -0,0 +1,294 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "BinaryRequestDeserializer.h"
+#include "RequestLoaderLog.h"
+#include "JsonRequestDeserializer.h"
+#include "MappedFileRequestProvider.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    //Hashes the names and types of the properties of a struct and of the
+    //structs it contains, which is what the binary serialization depends on
+    uint32 HashLayout(const UStruct* Struct)
+    {
+        uint32 Hash = GetTypeHash(Struct->GetName());
+        for (TFieldIterator<FProperty> It(Struct); It; ++It)
+        {
+            Hash = HashCombine(Hash, GetTypeHash(It->GetName()));
+            Hash = HashCombine(Hash, GetTypeHash(It->GetCPPType()));
+
+            const FProperty* Property = *It;
+            if (const FArrayProperty* ArrayProperty =
+                CastField<FArrayProperty>(Property))
+            {
+                Property = ArrayProperty->Inner;
+            }
+
+            if (const FStructProperty* StructProperty =
+                CastField<FStructProperty>(Property))
+            {
+                Hash = HashCombine(Hash, HashLayout(StructProperty->Struct));
+            }
+        }
+
+        return Hash;
+    }
+
+    struct FHeader
+    {
+        uint32 Magic = 0;
+
+        uint32 FormatVersion = 0;
+
+        uint32 LayoutHash = 0;
+
+        FVersion Version{};
+
+        uint64 PayloadSize = 0;
+
+        uint64 Checksum = 0;
+    };
+
+    void SerializeHeader(FArchive& Archive, FHeader& Header)
+    {
+        Archive << Header.Magic << Header.FormatVersion << Header.LayoutHash
+            << Header.Version.Major << Header.Version.Minor
+            << Header.Version.Index << Header.PayloadSize << Header.Checksum;
+    }
+
+    uint64 HashPayload(TArrayView<const uint8> Payload)
+    {
+        return CityHash64(reinterpret_cast<const char*>(Payload.GetData()),
+            Payload.Num());
+    }
+
+    //Is checked before a reader is made, the view of an empty or unmapped
+    //file is null and `FLargeMemoryReader` doesn't accept that
+    bool HasHeader(TArrayView<const uint8> Contents)
+    {
+        if (Contents.Num() < FBinaryRequestDeserializer::kHeaderSize)
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("The binary request is truncated"));
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //Reads the header and checks whether the payload which follows can be
+    //deserialized
+    bool ReadHeader(FArchive& Archive, FHeader& OutHeader)
+    {
+        SerializeHeader(Archive, OutHeader);
+
+        if (OutHeader.Magic != FBinaryRequestDeserializer::kMagic)
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("The request isn't in the binary form"));
+
+            return false;
+        }
+
+        if (OutHeader.FormatVersion !=
+            FBinaryRequestDeserializer::kFormatVersion)
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("The binary request has the format version %u, %u is "
+                     "expected"),
+                OutHeader.FormatVersion,
+                FBinaryRequestDeserializer::kFormatVersion);
+
+            return false;
+        }
+
+        return true;
+    }
+}
+
+void FBinaryRequestDeserializer::Deserialize(FString Contents)
+{
+    Request.Reset();
+    Version = FVersion{};
+
+    UE_LOG(LogXYZProductRequestLoader, Error,
+        TEXT("Binary requests have to be deserialized from a view"));
+}
+
+void FBinaryRequestDeserializer::DeserializeView(
+    TArrayView<const uint8> Contents)
+{
+    Request.Reset();
+    Version = FVersion{};
+
+    if (!HasHeader(Contents))
+    {
+        return;
+    }
+
+    FLargeMemoryReader Reader(Contents.GetData(), Contents.Num());
+
+    FHeader Header;
+    if (!ReadHeader(Reader, Header))
+    {
+        return;
+    }
+
+    Version = Header.Version;
+
+    //The version is extracted even if the payload can't be read, so that
+    //the loader reports a request of a newer plugin as such
+    if (Header.LayoutHash != GetLayoutHash())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The binary request has been produced for another layout "
+                 "of `FExtractionRequest`, convert it again"));
+
+        return;
+    }
+
+    TArrayView<const uint8> Payload =
+        Contents.Slice(kHeaderSize, Contents.Num() - kHeaderSize);
+    if (Header.PayloadSize != static_cast<uint64>(Payload.Num()) ||
+        Header.Checksum != HashPayload(Payload))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The binary request is corrupt, its payload doesn't match "
+                 "the header"));
+
+        return;
+    }
+
+    Request = MakeUnique<FExtractionRequest>();
+    FExtractionRequest::StaticStruct()->SerializeBin(Reader, Request.Get());
+
+    if (Reader.IsError() || !Reader.AtEnd())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The binary request is malformed"));
+
+        Request.Reset();
+    }
+}
+
+bool FBinaryRequestDeserializer::PeekVersion(TArrayView<const uint8> Head,
+    FVersion& OutVersion)
+{
+    if (!HasHeader(Head))
+    {
+        return false;
+    }
+
+    FLargeMemoryReader Reader(Head.GetData(), Head.Num());
+
+    FHeader Header;
+    if (!ReadHeader(Reader, Header))
+    {
+        return false;
+    }
+
+    OutVersion = Header.Version;
+
+    return true;
+}
+
+FVersion FBinaryRequestDeserializer::ExtractVersion()
+{
+    return Version;
+}
+
+TUniquePtr<FExtractionRequest> FBinaryRequestDeserializer::ExtractRequest()
+{
+    return MoveTemp(Request);
+}
+
+void FBinaryRequestDeserializer::Serialize(const FVersion& Version,
+    const FExtractionRequest& Request, TArray<uint8>& OutContents)
+{
+    OutContents.Reset();
+    FMemoryWriter Writer(OutContents);
+
+    FHeader Header;
+    Header.Magic = kMagic;
+    Header.FormatVersion = kFormatVersion;
+    Header.LayoutHash = GetLayoutHash();
+    Header.Version = Version;
+    SerializeHeader(Writer, Header);
+
+    //Saving doesn't modify the request
+    FExtractionRequest::StaticStruct()->SerializeBin(Writer,
+        const_cast<FExtractionRequest*>(&Request));
+
+    //The header is written again once the payload is known
+    TArrayView<const uint8> Payload(OutContents.GetData() + kHeaderSize,
+        OutContents.Num() - kHeaderSize);
+    Header.PayloadSize = Payload.Num();
+    Header.Checksum = HashPayload(Payload);
+    Writer.Seek(0);
+    SerializeHeader(Writer, Header);
+}
+
+bool FBinaryRequestDeserializer::ConvertFromText(const FString& TextPath,
+    const FString& BinaryPath)
+{
+    FMappedFileRequestProvider Provider(TextPath);
+    FJsonRequestDeserializer Deserializer;
+
+    Deserializer.DeserializeView(Provider.RetrieveView());
+
+    //A request without a valid version isn't extracted, so it's never
+    //written with a default version which would pass every check
+    FVersion RequiredVersion = Deserializer.ExtractVersion();
+    TUniquePtr<FExtractionRequest> TextRequest =
+        Deserializer.ExtractRequest();
+    if (!TextRequest.IsValid())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to convert `%s`, it can't be deserialized"),
+            *TextPath);
+
+        return false;
+    }
+
+    TArray<uint8> Contents;
+    Serialize(RequiredVersion, *TextRequest, Contents);
+
+    if (!FFileHelper::SaveArrayToFile(Contents, *BinaryPath))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to write the binary request to `%s`"), *BinaryPath);
+
+        return false;
+    }
+
+    return true;
+}
+
+bool FBinaryRequestDeserializer::IsBinary(TArrayView<const uint8> Contents)
+{
+    uint32 Magic = 0;
+    if (Contents.Num() < static_cast<int32>(sizeof(Magic)))
+    {
+        return false;
+    }
+
+    FMemory::Memcpy(&Magic, Contents.GetData(), sizeof(Magic));
+
+    return INTEL_ORDER32(Magic) == kMagic;
+}
+
+uint32 FBinaryRequestDeserializer::GetLayoutHash()
+{
+    static const uint32 LayoutHash =
+        HashLayout(FExtractionRequest::StaticStruct());
+
+    return LayoutHash;
+}
@@ -0,0 +1,96 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewDeserializer.h"
+#include "ExtractionRequest.h"
+
+/**
+ * Deserializes requests stored in the compact binary form
+ *
+ * The contents start with a header: `kMagic`, `kFormatVersion`, a hash of
+ * the layout of `FExtractionRequest` and the required `FVersion`, each of
+ * the fields is a little-endian 32-bit integer, followed by the size of the
+ * payload and its `CityHash64()`, which are little-endian 64-bit integers.
+ * The header is followed by the payload, the binary serialization of
+ * `FExtractionRequest`, which is read straight into the request without
+ * any parsing. A payload of another size or checksum is rejected before it
+ * is read, so a corrupt array size never turns into a huge allocation
+ *
+ * The binary form is produced from the text one by `ConvertFromText()` and
+ * has to be produced again whenever `FExtractionRequest` changes, requests
+ * of a different layout are rejected
+ *
+ * Isn't able to deserialize strings, `Deserialize()` always fails
+ */
+class FBinaryRequestDeserializer : public IRequestViewDeserializer
+{
+public:
+    virtual void Deserialize(FString Contents) override;
+
+    virtual void DeserializeView(TArrayView<const uint8> Contents) override;
+
+    virtual bool PeekVersion(TArrayView<const uint8> Head,
+        FVersion& OutVersion) override;
+
+    virtual FVersion ExtractVersion() override;
+
+    virtual TUniquePtr<FExtractionRequest> ExtractRequest() override;
+
+    /**
+     * Serializes a request into the binary form
+     *
+     * @param Version Version the request requires
+     * @param Request The request
+     * @param OutContents The binary contents
+     */
+    static void Serialize(const FVersion& Version,
+        const FExtractionRequest& Request, TArray<uint8>& OutContents);
+
+    /**
+     * Converts a request file from the text form into the binary one
+     *
+     * @param TextPath Path to the text request
+     * @param BinaryPath Path to write the binary request to
+     * @return `true` on success, `false` if the text request can't be
+     * deserialized, including when it has no valid version
+     */
+    static bool ConvertFromText(const FString& TextPath,
+        const FString& BinaryPath);
+
+    /**
+     * Tells whether the contents are in the binary form
+     *
+     * @param Contents The contents or their first bytes
+     * @return `true` if the contents start with `kMagic`
+     */
+    static bool IsBinary(TArrayView<const uint8> Contents);
+
+    /**
+     * Returns the hash of the layout of `FExtractionRequest` which binary
+     * requests are checked against
+     *
+     * @return The hash
+     */
+    static uint32 GetLayoutHash();
+
+    //`XYZR` read as a little-endian integer
+    static constexpr uint32 kMagic = 0x525A5958;
+
+    //Is bumped whenever the header or the way the payload is serialized
+    //changes
+    static constexpr uint32 kFormatVersion = 2;
+
+    //Size of the header in bytes
+    static constexpr int32 kHeaderSize =
+        6 * sizeof(uint32) + 2 * sizeof(uint64);
+
+private:
+    FVersion Version{};
+
+    TUniquePtr<FExtractionRequest> Request;
+};
@@ -0,0 +1,175 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "version.h"
+#include "ExtractionRequest.h"
+#include "BinaryRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+
+BEGIN_DEFINE_SPEC(FBinaryRequestDeserializerSpec,
+                  "XYZProduct.Loading.BinaryRequestDeserializer",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FExtractionRequest Request;
+
+FVersion Version{};
+
+TArray<uint8> Contents;
+
+END_DEFINE_SPEC(FBinaryRequestDeserializerSpec)
+
+void FBinaryRequestDeserializerSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Request = FExtractionRequest();
+        FRequestSpecHelpers::ResizeArrays(Request, 3);
+        Version = FRequestSpecHelpers::MakeVersion(1, 2, 3);
+        FBinaryRequestDeserializer::Serialize(Version, Request, Contents);
+    });
+
+    It("Round trip",
+        [this]()
+        {
+            TestTrue(TEXT("Expecting the contents to be binary"),
+                FBinaryRequestDeserializer::IsBinary(Contents));
+
+            FBinaryRequestDeserializer Deserializer;
+            Deserializer.DeserializeView(Contents);
+
+            TestTrue(TEXT("Expecting the version to be kept"),
+                FRequestSpecHelpers::AreEqual(Deserializer.ExtractVersion(),
+                    Version));
+
+            TUniquePtr<FExtractionRequest> Result =
+                Deserializer.ExtractRequest();
+            if (TestTrue(TEXT("Expecting the request to be extracted"),
+                Result.IsValid()))
+            {
+                TestEqual(TEXT("Expecting the same request"),
+                    FRequestSpecHelpers::Export(*Result),
+                    FRequestSpecHelpers::Export(Request));
+            }
+        }
+    );
+
+    It("Version peek",
+        [this]()
+        {
+            FVersion PeekedVersion{};
+            bool bIsPeeked = FBinaryRequestDeserializer().PeekVersion(
+                TArrayView<const uint8>(Contents).Slice(0,
+                    FBinaryRequestDeserializer::kHeaderSize), PeekedVersion);
+
+            TestTrue(TEXT("Expecting the version to be peeked from the "
+                "header alone"), bIsPeeked &&
+                FRequestSpecHelpers::AreEqual(PeekedVersion, Version));
+        }
+    );
+
+    It("JSON isn't binary",
+        [this]()
+        {
+            TestFalse(TEXT("Expecting JSON not to be taken for binary"),
+                FBinaryRequestDeserializer::IsBinary(
+                    FRequestSpecHelpers::ToUtf8(
+                        FRequestSpecHelpers::ToJson(Request))));
+        }
+    );
+
+    It("Corrupt payload",
+        [this]()
+        {
+            AddExpectedError(TEXT("its payload doesn't match the header"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            if (!TestTrue(TEXT("Expecting a payload"),
+                Contents.Num() > FBinaryRequestDeserializer::kHeaderSize))
+            {
+                return;
+            }
+            Contents.Last() ^= 0xFF;
+
+            FBinaryRequestDeserializer Deserializer;
+            Deserializer.DeserializeView(Contents);
+
+            TestTrue(TEXT("Expecting the version to be read anyway"),
+                FRequestSpecHelpers::AreEqual(Deserializer.ExtractVersion(),
+                    Version));
+            TestFalse(TEXT("Expecting the request to be rejected"),
+                Deserializer.ExtractRequest().IsValid());
+        }
+    );
+
+    It("Truncated payload",
+        [this]()
+        {
+            AddExpectedError(TEXT("its payload doesn't match the header"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            FBinaryRequestDeserializer Deserializer;
+            Deserializer.DeserializeView(TArrayView<const uint8>(Contents)
+                .Slice(0, Contents.Num() - 1));
+
+            TestFalse(TEXT("Expecting the request to be rejected"),
+                Deserializer.ExtractRequest().IsValid());
+        }
+    );
+
+    It("Truncated header",
+        [this]()
+        {
+            AddExpectedError(TEXT("The binary request is truncated"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            FBinaryRequestDeserializer Deserializer;
+            Deserializer.DeserializeView(TArrayView<const uint8>(Contents)
+                .Slice(0, FBinaryRequestDeserializer::kHeaderSize - 1));
+
+            TestFalse(TEXT("Expecting the request to be rejected"),
+                Deserializer.ExtractRequest().IsValid());
+        }
+    );
+
+    It("Empty view",
+        [this]()
+        {
+            AddExpectedError(TEXT("The binary request is truncated"),
+                EAutomationExpectedErrorFlags::Contains, 2);
+
+            //An empty or unmapped file is handed over as a null view
+            FBinaryRequestDeserializer Deserializer;
+            FVersion PeekedVersion{};
+            TestFalse(TEXT("Expecting no version to be peeked"),
+                Deserializer.PeekVersion(TArrayView<const uint8>(),
+                    PeekedVersion));
+
+            Deserializer.DeserializeView(TArrayView<const uint8>());
+            TestFalse(TEXT("Expecting the request to be rejected"),
+                Deserializer.ExtractRequest().IsValid());
+        }
+    );
+
+    It("Another layout",
+        [this]()
+        {
+            AddExpectedError(TEXT("another layout"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            //The layout hash follows the magic and the format version
+            Contents[2 * sizeof(uint32)] ^= 0xFF;
+
+            FBinaryRequestDeserializer Deserializer;
+            Deserializer.DeserializeView(Contents);
+
+            TestFalse(TEXT("Expecting the request to be rejected"),
+                Deserializer.ExtractRequest().IsValid());
+        }
+    );
+}
@@ -0,0 +1,47 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "BuildControllerDatabaseCommandlet.h"
+#include "ControllerDatabase.h"
+#include "GamepadDetection.h"
+#include "Misc/FileHelper.h"
+
+int32 UBuildControllerDatabaseCommandlet::Main(const FString& Params)
+{
+	FString CsvPath;
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Csv="), CsvPath) ||
+		!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Usage: -run=BuildControllerDatabase -Csv=<path>"
+				 " -Output=<path>"));
+
+		return 1;
+	}
+
+	FString CsvContents;
+	if (!FFileHelper::LoadFileToString(CsvContents, *CsvPath))
+	{
+		UE_LOG(LogGamepadDetection, Error, TEXT("Unable to read `%s`"),
+			*CsvPath);
+
+		return 1;
+	}
+
+	TArray<uint8> Data;
+	int32 NumEntries = FControllerDatabase::BuildFromCsv(CsvContents, Data);
+
+	if (!FFileHelper::SaveArrayToFile(Data, *OutputPath))
+	{
+		UE_LOG(LogGamepadDetection, Error, TEXT("Unable to write `%s`"),
+			*OutputPath);
+
+		return 1;
+	}
+
+	UE_LOG(LogGamepadDetection, Display,
+		TEXT("%d controllers are written into `%s`"), NumEntries,
+		*OutputPath);
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuildControllerDatabaseCommandlet.generated.h"
+
+/**
+* Offline tool which converts a CSV export of the Steam supported controller
+* database into a binary controller database loadable by
+* `FGamepadDetector::SetControllerDatabase()`
+*
+* Usage:
+* `-run=BuildControllerDatabase -Csv=<path to CSV> -Output=<path to file>`
+*
+* @see FControllerDatabase
+*/
+UCLASS()
+class UBuildControllerDatabaseCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};
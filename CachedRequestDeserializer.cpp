@@ -0,0 +1,160 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CachedRequestDeserializer.h"
+#include "RequestLoaderLog.h"
+#include "BinaryRequestDeserializer.h"
+#include "MappedFileRequestProvider.h"
+#include "version.h"
+#include "Hash/CityHash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FCachedRequestDeserializer::FCachedRequestDeserializer(
+    TUniquePtr<IRequestViewDeserializer> Deserializer,
+    FString CacheDirectory)
+        : Deserializer(MoveTemp(Deserializer)),
+          CacheDirectory(MoveTemp(CacheDirectory))
+{
+    if (this->CacheDirectory.IsEmpty())
+    {
+        this->CacheDirectory =
+            FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RequestCache"));
+    }
+}
+
+FCachedRequestDeserializer::~FCachedRequestDeserializer() = default;
+
+void FCachedRequestDeserializer::Deserialize(FString Contents)
+{
+    uint64 Hash = CityHash64(reinterpret_cast<const char*>(*Contents),
+        Contents.Len() * sizeof(TCHAR));
+    if (!TryLoad(Hash))
+    {
+        Deserializer->Deserialize(MoveTemp(Contents));
+    }
+}
+
+void FCachedRequestDeserializer::DeserializeView(
+    TArrayView<const uint8> Contents)
+{
+    uint64 Hash = CityHash64(reinterpret_cast<const char*>(
+        Contents.GetData()), Contents.Num());
+    if (!TryLoad(Hash))
+    {
+        Deserializer->DeserializeView(Contents);
+    }
+}
+
+bool FCachedRequestDeserializer::PeekVersion(TArrayView<const uint8> Head,
+    FVersion& OutVersion)
+{
+    return Deserializer->PeekVersion(Head, OutVersion);
+}
+
+void FCachedRequestDeserializer::SetArena(FRequestArena* Arena)
+{
+    Deserializer->SetArena(Arena);
+}
+
+TUniquePtr<IRequestSections> FCachedRequestDeserializer::DeserializeViewLazily(
+    TArrayView<const uint8> Contents)
+{
+    //Sections are cheap to index and are never cached
+    bWasHit = false;
+    CachedRequest.Reset();
+    EntryPath.Reset();
+
+    return Deserializer->DeserializeViewLazily(Contents);
+}
+
+FVersion FCachedRequestDeserializer::ExtractVersion()
+{
+    return bWasHit ? CachedVersion : Deserializer->ExtractVersion();
+}
+
+TUniquePtr<FExtractionRequest> FCachedRequestDeserializer::ExtractRequest()
+{
+    if (bWasHit)
+    {
+        return MoveTemp(CachedRequest);
+    }
+
+    FVersion Version = Deserializer->ExtractVersion();
+    TUniquePtr<FExtractionRequest> Request = Deserializer->ExtractRequest();
+    if (Request.IsValid() && !EntryPath.IsEmpty())
+    {
+        Store(Version, *Request);
+    }
+
+    return Request;
+}
+
+bool FCachedRequestDeserializer::WasHit() const
+{
+    return bWasHit;
+}
+
+bool FCachedRequestDeserializer::TryLoad(uint64 Hash)
+{
+    bWasHit = false;
+    CachedRequest.Reset();
+    EntryPath = GetEntryPath(Hash);
+
+    if (!FPaths::FileExists(EntryPath))
+    {
+        return false;
+    }
+
+    //The request is copied out of the mapping, which is released at once
+    FMappedFileRequestProvider Provider(EntryPath);
+    FBinaryRequestDeserializer CachedDeserializer;
+    CachedDeserializer.DeserializeView(Provider.RetrieveView());
+
+    CachedRequest = CachedDeserializer.ExtractRequest();
+    if (!CachedRequest.IsValid())
+    {
+        //A broken entry is a miss and is overwritten
+        UE_LOG(LogXYZProductRequestLoader, Warning,
+            TEXT("The cached request `%s` is broken, ignoring it"),
+            *EntryPath);
+
+        return false;
+    }
+
+    CachedVersion = CachedDeserializer.ExtractVersion();
+    bWasHit = true;
+
+    return true;
+}
+
+void FCachedRequestDeserializer::Store(const FVersion& Version,
+    const FExtractionRequest& Request) const
+{
+    TArray<uint8> Contents;
+    FBinaryRequestDeserializer::Serialize(Version, Request, Contents);
+
+    //Readers never see a partially written entry
+    FString TemporaryPath = FString::Printf(TEXT("%s.%s.tmp"), *EntryPath,
+        *FGuid::NewGuid().ToString());
+    if (!FFileHelper::SaveArrayToFile(Contents, *TemporaryPath) ||
+        !IFileManager::Get().Move(*EntryPath, *TemporaryPath))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Warning,
+            TEXT("Failed to store the request in the cache at `%s`"),
+            *EntryPath);
+
+        IFileManager::Get().Delete(*TemporaryPath);
+    }
+}
+
+FString FCachedRequestDeserializer::GetEntryPath(uint64 Hash) const
+{
+    return FPaths::Combine(CacheDirectory, FString::Printf(
+        TEXT("%016llx-%d.%d.%d-%08x.bin"), Hash, VERSION_MAJOR,
+        VERSION_MINOR, VERSION_INDEX,
+        FBinaryRequestDeserializer::GetLayoutHash()));
+}
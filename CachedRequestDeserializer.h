@@ -0,0 +1,87 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewDeserializer.h"
+
+/**
+ * Deserializer which keeps the requests deserialized by another one in an
+ * on-disk cache, so that the same request is parsed once
+ *
+ * Entries are keyed by a hash of the raw contents, the plugin version and
+ * the layout of `FExtractionRequest`, and hold the request in the binary
+ * form of `FBinaryRequestDeserializer`. On a hit the wrapped deserializer
+ * isn't used at all. On a miss the request is stored when it's extracted
+ *
+ * Entries are never evicted, the cache directory may be deleted at any
+ * time. Concurrent writers of the same entry are safe, the entry is written
+ * to a temporary file which is then moved into place
+ */
+class FCachedRequestDeserializer : public IRequestViewDeserializer
+{
+public:
+    /**
+     * @param Deserializer Deserializer to be used on a miss
+     * @param CacheDirectory Directory to keep the entries in, the default
+     * one is `RequestCache` in the project's saved directory
+     */
+    explicit FCachedRequestDeserializer(
+        TUniquePtr<IRequestViewDeserializer> Deserializer,
+        FString CacheDirectory = FString());
+
+    virtual ~FCachedRequestDeserializer() override;
+
+    virtual void Deserialize(FString Contents) override;
+
+    virtual void DeserializeView(TArrayView<const uint8> Contents) override;
+
+    virtual bool PeekVersion(TArrayView<const uint8> Head,
+        FVersion& OutVersion) override;
+
+    virtual void SetArena(FRequestArena* Arena) override;
+
+    virtual TUniquePtr<IRequestSections> DeserializeViewLazily(
+        TArrayView<const uint8> Contents) override;
+
+    virtual FVersion ExtractVersion() override;
+
+    virtual TUniquePtr<FExtractionRequest> ExtractRequest() override;
+
+    /**
+     * @return `true` if the last deserialized request has been found in
+     * the cache
+     */
+    bool WasHit() const;
+
+private:
+    /**
+     * Looks the contents up in the cache
+     *
+     * @param Hash Hash of the contents
+     * @return `true` on a hit, the request is in `CachedRequest` then
+     */
+    bool TryLoad(uint64 Hash);
+
+    //Writes the request into the entry of the last deserialized contents
+    void Store(const FVersion& Version,
+        const FExtractionRequest& Request) const;
+
+    FString GetEntryPath(uint64 Hash) const;
+
+    TUniquePtr<IRequestViewDeserializer> Deserializer;
+
+    TUniquePtr<FExtractionRequest> CachedRequest;
+
+    FVersion CachedVersion{};
+
+    FString CacheDirectory;
+
+    //Entry of the last deserialized contents, empty if they can't be cached
+    FString EntryPath;
+
+    bool bWasHit = false;
+};
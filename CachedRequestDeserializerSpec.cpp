@@ -0,0 +1,181 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "version.h"
+#include "ExtractionRequest.h"
+#include "JsonRequestDeserializer.h"
+#include "CachedRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+
+BEGIN_DEFINE_SPEC(FCachedRequestDeserializerSpec,
+                  "XYZProduct.Loading.CachedRequestDeserializer",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FString Directory;
+
+FExtractionRequest Request;
+
+TArray<uint8> Contents;
+
+/**
+ * Deserializes the contents through a new cache over the directory, the
+ * same way a later run of the extraction does
+ *
+ * @param bOutWasHit Whether the request has been found in the cache
+ * @return The extracted request
+ */
+TUniquePtr<FExtractionRequest> Load(TArrayView<const uint8> View,
+    bool& bOutWasHit)
+{
+    FCachedRequestDeserializer Deserializer(
+        MakeUnique<FJsonRequestDeserializer>(), Directory);
+    Deserializer.DeserializeView(View);
+
+    FVersion PluginVersion = FRequestSpecHelpers::MakeVersion(VERSION_MAJOR,
+        VERSION_MINOR, VERSION_INDEX);
+    TestTrue(TEXT("Expecting the version of the request"),
+        FRequestSpecHelpers::AreEqual(Deserializer.ExtractVersion(),
+            PluginVersion));
+
+    TUniquePtr<FExtractionRequest> Result = Deserializer.ExtractRequest();
+    bOutWasHit = Deserializer.WasHit();
+
+    return Result;
+}
+
+void CheckLoaded(const FString& What, bool bShouldHit)
+{
+    bool bWasHit = false;
+    TUniquePtr<FExtractionRequest> Result = Load(Contents, bWasHit);
+
+    TestTrue(What + TEXT(": expecting a ") +
+        (bShouldHit ? TEXT("hit") : TEXT("miss")), bWasHit == bShouldHit);
+    if (TestTrue(What + TEXT(": expecting the request to be extracted"),
+        Result.IsValid()))
+    {
+        TestEqual(What + TEXT(": expecting the same request"),
+            FRequestSpecHelpers::Export(*Result),
+            FRequestSpecHelpers::Export(Request));
+    }
+}
+
+END_DEFINE_SPEC(FCachedRequestDeserializerSpec)
+
+void FCachedRequestDeserializerSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Directory = FPaths::Combine(FPaths::AutomationTransientDir(),
+            TEXT("RequestCache"));
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+        Request = FExtractionRequest();
+        FRequestSpecHelpers::ResizeArrays(Request, 3);
+        Contents = FRequestSpecHelpers::ToUtf8(
+            FRequestSpecHelpers::ToJson(Request));
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    });
+
+    It("Miss, then hit",
+        [this]()
+        {
+            CheckLoaded(TEXT("First load"), false);
+            CheckLoaded(TEXT("Second load"), true);
+        }
+    );
+
+    It("Other contents miss",
+        [this]()
+        {
+            CheckLoaded(TEXT("First load"), false);
+
+            //The same request written differently is other contents
+            Contents.Append(FRequestSpecHelpers::ToUtf8(TEXT("\n")));
+            CheckLoaded(TEXT("Other contents"), false);
+            CheckLoaded(TEXT("Other contents again"), true);
+        }
+    );
+
+    It("Broken entry",
+        [this]()
+        {
+            AddExpectedError(TEXT("The binary request is truncated"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            CheckLoaded(TEXT("First load"), false);
+
+            TArray<FString> Entries;
+            IFileManager::Get().FindFiles(Entries, *Directory, TEXT("bin"));
+            if (!TestEqual(TEXT("Expecting one entry"), Entries.Num(), 1))
+            {
+                return;
+            }
+
+            FFileHelper::SaveStringToFile(TEXT("broken"),
+                *FPaths::Combine(Directory, Entries[0]));
+
+            //A broken entry is a miss and is overwritten with a valid one
+            CheckLoaded(TEXT("Broken entry"), false);
+            CheckLoaded(TEXT("Overwritten entry"), true);
+        }
+    );
+
+    It("Empty entry",
+        [this]()
+        {
+            AddExpectedError(TEXT("The binary request is truncated"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            CheckLoaded(TEXT("First load"), false);
+
+            TArray<FString> Entries;
+            IFileManager::Get().FindFiles(Entries, *Directory, TEXT("bin"));
+            if (!TestEqual(TEXT("Expecting one entry"), Entries.Num(), 1))
+            {
+                return;
+            }
+
+            //An empty file is mapped as a null view
+            FFileHelper::SaveArrayToFile(TArray<uint8>(),
+                *FPaths::Combine(Directory, Entries[0]));
+
+            CheckLoaded(TEXT("Empty entry"), false);
+            CheckLoaded(TEXT("Overwritten entry"), true);
+        }
+    );
+
+    It("Request without a version isn't cached",
+        [this]()
+        {
+            AddExpectedError(TEXT("without a valid `version`"),
+                EAutomationExpectedErrorFlags::Contains, 2);
+            AddExpectedError(TEXT("has no `version` field"),
+                EAutomationExpectedErrorFlags::Contains, 2);
+
+            Contents = FRequestSpecHelpers::ToUtf8(TEXT("{}"));
+            for (int32 i = 0; i < 2; i++)
+            {
+                FCachedRequestDeserializer Deserializer(
+                    MakeUnique<FJsonRequestDeserializer>(), Directory);
+                Deserializer.DeserializeView(Contents);
+
+                TestFalse(TEXT("Expecting no request"),
+                    Deserializer.ExtractRequest().IsValid());
+                TestFalse(TEXT("Expecting a miss"), Deserializer.WasHit());
+            }
+        }
+    );
+}
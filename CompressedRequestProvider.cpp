@@ -0,0 +1,418 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CompressedRequestProvider.h"
+#include "RequestLoaderLog.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Templates/Atomic.h"
+#include "zlib.h"
+
+namespace
+{
+    constexpr uint8 Utf8Bom[] = { 0xEF, 0xBB, 0xBF };
+
+    constexpr uint8 GzipMagic[] = { 0x1F, 0x8B };
+
+    constexpr uint8 ZstdMagic[] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+    //Size of the header and of the trailer of a gzip member
+    constexpr int32 GzipMinimalSize = 18;
+
+    //The size a gzip trailer states is taken for a hint only up to that
+    //many times the compressed size, so a forged one can't make a huge
+    //allocation
+    constexpr int64 GzipMaxHintRatio = 16;
+
+    //Size the buffer of the gzip-compressed contents starts with if the
+    //trailer gives no usable hint
+    constexpr int32 GzipMinimalBufferSize = 64 * 1024;
+
+    template <int32 Size>
+    bool StartsWith(TArrayView<const uint8> Contents,
+        const uint8 (&Prefix)[Size])
+    {
+        return Contents.Num() >= Size &&
+            FMemory::Memcmp(Contents.GetData(), Prefix, Size) == 0;
+    }
+
+    bool StartsWithMagic(TArrayView<const uint8> Contents)
+    {
+        uint32 Magic = 0;
+        if (Contents.Num() < static_cast<int32>(sizeof(Magic)))
+        {
+            return false;
+        }
+
+        FMemory::Memcpy(&Magic, Contents.GetData(), sizeof(Magic));
+
+        return INTEL_ORDER32(Magic) == FCompressedRequestProvider::kMagic;
+    }
+
+    FName GetFormatName(uint32 Method)
+    {
+        switch (static_cast<FCompressedRequestProvider::EMethod>(Method))
+        {
+        case FCompressedRequestProvider::EMethod::Zlib:
+            return NAME_Zlib;
+        case FCompressedRequestProvider::EMethod::Oodle:
+            return NAME_Oodle;
+        default:
+            return NAME_None;
+        }
+    }
+
+    /**
+     * Header of the container, is followed by the compressed sizes of the
+     * chunks and then by the chunks
+     */
+    struct FHeader
+    {
+        uint32 Magic = 0;
+
+        uint32 FormatVersion = 0;
+
+        uint32 Method = 0;
+
+        int32 ChunkSize = 0;
+
+        int64 UncompressedSize = 0;
+
+        int32 NumberOfChunks = 0;
+    };
+
+    void SerializeHeader(FArchive& Archive, FHeader& Header)
+    {
+        Archive << Header.Magic << Header.FormatVersion << Header.Method
+            << Header.ChunkSize << Header.UncompressedSize
+            << Header.NumberOfChunks;
+    }
+}
+
+FCompressedRequestProvider::FCompressedRequestProvider(
+    TUniquePtr<IRequestViewProvider> Provider)
+        : Provider(MoveTemp(Provider)) {}
+
+FString FCompressedRequestProvider::RetrieveContents()
+{
+    TArrayView<const uint8> View = RetrieveView();
+
+    FString Result;
+    FFileHelper::BufferToString(Result, View.GetData(), View.Num());
+
+    return Result;
+}
+
+TArrayView<const uint8> FCompressedRequestProvider::RetrieveView()
+{
+    Contents.Empty();
+
+    TArrayView<const uint8> Compressed = Provider->RetrieveView();
+
+    bool bIsDecompressed;
+    if (StartsWithMagic(Compressed))
+    {
+        bIsDecompressed = DecompressContainer(Compressed);
+    }
+    else if (StartsWith(Compressed, GzipMagic))
+    {
+        bIsDecompressed = DecompressGzip(Compressed);
+    }
+    else if (StartsWith(Compressed, ZstdMagic))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request is compressed with zstd, which isn't "
+                 "supported, recompress it with `Compress()` or gzip"));
+
+        bIsDecompressed = false;
+    }
+    else
+    {
+        //Not compressed, the view of the provider is handed over as it is
+        return Compressed;
+    }
+
+    if (!bIsDecompressed)
+    {
+        Contents.Empty();
+
+        return TArrayView<const uint8>();
+    }
+
+    TArrayView<const uint8> View = Contents;
+    if (StartsWith(View, Utf8Bom))
+    {
+        View = View.Slice(UE_ARRAY_COUNT(Utf8Bom),
+            View.Num() - UE_ARRAY_COUNT(Utf8Bom));
+    }
+
+    return View;
+}
+
+bool FCompressedRequestProvider::Compress(TArrayView<const uint8> Contents,
+    EMethod Method, TArray<uint8>& OutContents, int32 ChunkSize)
+{
+    FName FormatName = GetFormatName(static_cast<uint32>(Method));
+    if (!FCompression::IsFormatValid(FormatName))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The `%s` compression isn't available"),
+            *FormatName.ToString());
+
+        return false;
+    }
+
+    check(ChunkSize > 0);
+
+    FHeader Header;
+    Header.Magic = kMagic;
+    Header.FormatVersion = kFormatVersion;
+    Header.Method = static_cast<uint32>(Method);
+    Header.ChunkSize = ChunkSize;
+    Header.UncompressedSize = Contents.Num();
+    Header.NumberOfChunks =
+        FMath::DivideAndRoundUp(Contents.Num(), ChunkSize);
+
+    TArray<TArray<uint8>> Chunks;
+    Chunks.SetNum(Header.NumberOfChunks);
+    for (int32 i = 0; i < Header.NumberOfChunks; i++)
+    {
+        int32 Offset = i * ChunkSize;
+        int32 Size = FMath::Min(ChunkSize, Contents.Num() - Offset);
+
+        int32 CompressedSize =
+            FCompression::CompressMemoryBound(FormatName, Size);
+        Chunks[i].SetNumUninitialized(CompressedSize);
+        if (!FCompression::CompressMemory(FormatName, Chunks[i].GetData(),
+            CompressedSize, Contents.GetData() + Offset, Size))
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("Failed to compress the request"));
+
+            return false;
+        }
+        Chunks[i].SetNum(CompressedSize, false);
+    }
+
+    OutContents.Reset();
+    FMemoryWriter Writer(OutContents);
+
+    SerializeHeader(Writer, Header);
+    for (TArray<uint8>& Chunk : Chunks)
+    {
+        int32 CompressedSize = Chunk.Num();
+        Writer << CompressedSize;
+    }
+
+    for (TArray<uint8>& Chunk : Chunks)
+    {
+        Writer.Serialize(Chunk.GetData(), Chunk.Num());
+    }
+
+    return true;
+}
+
+bool FCompressedRequestProvider::DecompressContainer(
+    TArrayView<const uint8> Compressed)
+{
+    FLargeMemoryReader Reader(Compressed.GetData(), Compressed.Num());
+
+    FHeader Header;
+    SerializeHeader(Reader, Header);
+
+    FName FormatName = GetFormatName(Header.Method);
+    if (Reader.IsError() || Header.FormatVersion != kFormatVersion ||
+        Header.ChunkSize <= 0 || Header.UncompressedSize < 0 ||
+        Header.UncompressedSize > MAX_int32 ||
+        Header.NumberOfChunks != FMath::DivideAndRoundUp(
+            static_cast<int32>(Header.UncompressedSize), Header.ChunkSize))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The compressed request is malformed or of an unknown "
+                 "format version"));
+
+        return false;
+    }
+
+    if (!FCompression::IsFormatValid(FormatName))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request is compressed with an unavailable method %u"),
+            Header.Method);
+
+        return false;
+    }
+
+    //The table of the chunks has to fit into what follows the header
+    //before anything is allocated for it
+    if (static_cast<int64>(Header.NumberOfChunks) * sizeof(int32) >
+        Compressed.Num() - Reader.Tell())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The compressed request is truncated"));
+
+        return false;
+    }
+
+    TArray<int32> CompressedSizes;
+    TArray<int64> Offsets;
+    CompressedSizes.SetNum(Header.NumberOfChunks);
+    Offsets.SetNum(Header.NumberOfChunks);
+    for (int32& CompressedSize : CompressedSizes)
+    {
+        Reader << CompressedSize;
+    }
+
+    int64 Offset = Reader.Tell();
+    for (int32 i = 0; i < Header.NumberOfChunks; i++)
+    {
+        if (CompressedSizes[i] < 0)
+        {
+            Offset = INDEX_NONE;
+            break;
+        }
+
+        Offsets[i] = Offset;
+        Offset += CompressedSizes[i];
+    }
+
+    if (Reader.IsError() || Offset != Compressed.Num())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The compressed request is truncated"));
+
+        return false;
+    }
+
+    Contents.SetNumUninitialized(static_cast<int32>(Header.UncompressedSize));
+
+    //The chunks are independent, each of them is decompressed straight
+    //into its place in the contents
+    TAtomic<bool> bHasFailed(false);
+    ParallelFor(Header.NumberOfChunks, [&](int32 i)
+    {
+        int32 ChunkOffset = i * Header.ChunkSize;
+        int32 Size = FMath::Min(Header.ChunkSize,
+            Contents.Num() - ChunkOffset);
+
+        if (!FCompression::UncompressMemory(FormatName,
+            Contents.GetData() + ChunkOffset, Size,
+            Compressed.GetData() + Offsets[i], CompressedSizes[i]))
+        {
+            bHasFailed = true;
+        }
+    });
+
+    if (bHasFailed)
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to decompress the request"));
+
+        return false;
+    }
+
+    return true;
+}
+
+bool FCompressedRequestProvider::DecompressGzip(
+    TArrayView<const uint8> Compressed)
+{
+    if (Compressed.Num() < GzipMinimalSize)
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The gzip-compressed request is truncated"));
+
+        return false;
+    }
+
+    //The trailer holds the size of the last member only, the contents may
+    //consist of several members, so it's just a hint for the first
+    //allocation and the contents grow as they are inflated
+    uint32 SizeHint = 0;
+    FMemory::Memcpy(&SizeHint,
+        Compressed.GetData() + Compressed.Num() - sizeof(SizeHint),
+        sizeof(SizeHint));
+    Contents.Reserve(FMath::Clamp<int64>(INTEL_ORDER32(SizeHint),
+        GzipMinimalBufferSize, FMath::Min<int64>(MAX_int32,
+            Compressed.Num() * GzipMaxHintRatio)));
+
+    z_stream Stream;
+    FMemory::Memzero(Stream);
+    if (inflateInit2(&Stream, 16 + MAX_WBITS) != Z_OK)
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to start decompressing the gzip-compressed "
+                 "request"));
+
+        return false;
+    }
+
+    Stream.next_in = const_cast<Bytef*>(Compressed.GetData());
+    Stream.avail_in = Compressed.Num();
+
+    bool bIsDecompressed = false;
+    while (true)
+    {
+        if (Contents.Num() == Contents.Max())
+        {
+            if (Contents.Max() == MAX_int32)
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("The gzip-compressed request is too big"));
+
+                break;
+            }
+
+            Contents.Reserve(static_cast<int32>(FMath::Min<int64>(
+                static_cast<int64>(Contents.Max()) * 2, MAX_int32)));
+        }
+
+        int32 Offset = Contents.Num();
+        int32 Available = Contents.Max() - Offset;
+        Contents.AddUninitialized(Available);
+        Stream.next_out = Contents.GetData() + Offset;
+        Stream.avail_out = Available;
+
+        int Result = inflate(&Stream, Z_NO_FLUSH);
+        Contents.SetNum(Offset + Available - Stream.avail_out, false);
+
+        if (Result == Z_STREAM_END)
+        {
+            if (Stream.avail_in == 0)
+            {
+                bIsDecompressed = true;
+
+                break;
+            }
+
+            //Concatenated members are one file, `gzip -d` reads them all
+            TArrayView<const uint8> Rest(Stream.next_in, Stream.avail_in);
+            if (!StartsWith(Rest, GzipMagic) || inflateReset(&Stream) != Z_OK)
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("The gzip-compressed request is followed by %d "
+                         "unknown bytes"), Rest.Num());
+
+                break;
+            }
+        }
+        else if (Result != Z_OK)
+        {
+            //`Z_BUF_ERROR` means that no progress is possible, i.e. the
+            //input ends in the middle of a member
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("Failed to decompress the gzip-compressed request"));
+
+            break;
+        }
+    }
+
+    inflateEnd(&Stream);
+
+    return bIsDecompressed;
+}
@@ -0,0 +1,79 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewProvider.h"
+
+/**
+ * Provides the request of another provider, decompressing it if it's
+ * compressed
+ *
+ * The compression is detected by the magic bytes the contents start with:
+ * - `kMagic` is the chunked container written by `Compress()`, the chunks
+ *   are compressed with zlib or Oodle and are decompressed in parallel
+ * - gzip, as produced by most artifact storages, including several
+ *   concatenated members
+ * - zstd is recognized but isn't supported by the engine's compression,
+ *   such contents are reported and aren't provided
+ * Any other contents are provided as they are, without a copy
+ */
+class FCompressedRequestProvider : public IRequestViewProvider
+{
+public:
+    /**
+     * Compression of the chunks of the container
+     */
+    enum class EMethod : uint32
+    {
+        Zlib = 1,
+
+        //Is available if the engine is built with Oodle
+        Oodle = 2
+    };
+
+    /**
+     * @param Provider Provider of the possibly compressed contents, e.g. a
+     * `FMappedFileRequestProvider`
+     */
+    explicit FCompressedRequestProvider(
+        TUniquePtr<IRequestViewProvider> Provider);
+
+    virtual FString RetrieveContents() override;
+
+    virtual TArrayView<const uint8> RetrieveView() override;
+
+    /**
+     * Compresses contents into the chunked container
+     *
+     * @param Contents UTF-8 encoded contents
+     * @param Method Compression of the chunks
+     * @param OutContents The container
+     * @param ChunkSize Size of an uncompressed chunk, bigger chunks compress
+     * better, smaller ones are decompressed by more threads
+     * @return `true` on success, `false` if the method isn't available
+     */
+    static bool Compress(TArrayView<const uint8> Contents, EMethod Method,
+        TArray<uint8>& OutContents, int32 ChunkSize = kDefaultChunkSize);
+
+    //`XYZC` read as a little-endian integer
+    static constexpr uint32 kMagic = 0x435A5958;
+
+    //Is bumped whenever the layout of the container changes
+    static constexpr uint32 kFormatVersion = 1;
+
+    static constexpr int32 kDefaultChunkSize = 1024 * 1024;
+
+private:
+    bool DecompressContainer(TArrayView<const uint8> Compressed);
+
+    bool DecompressGzip(TArrayView<const uint8> Compressed);
+
+    TUniquePtr<IRequestViewProvider> Provider;
+
+    //Decompressed contents, empty if the contents aren't compressed
+    TArray<uint8> Contents;
+};
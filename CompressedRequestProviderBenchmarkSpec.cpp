@@ -0,0 +1,148 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "CompressedRequestProvider.h"
+#include "MappedFileRequestProvider.h"
+
+namespace
+{
+    //Sizes of the synthetic requests
+    constexpr int32 RequestSizes[] =
+        { 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+
+    //Read bandwidths of the storages the load time is modelled for: slow
+    //artifact storage, a network share and a local SSD, in MB/s
+    constexpr double Bandwidths[] = { 20.0, 200.0, 2000.0 };
+
+    constexpr int32 NumberOfRepetitions = 5;
+
+    /**
+     * Builds a request of roughly the given size which compresses the way
+     * real requests do: repetitive keys and paths, varying numbers
+     */
+    TArray<uint8> MakeRequest(int32 Size)
+    {
+        FString Request = TEXT("{\"version\":\"1.0.0\",\"assets\":[");
+        for (int32 i = 0; Request.Len() < Size; i++)
+        {
+            Request += FString::Printf(TEXT("%s{\"path\":\"/Game/Content/"
+                "Props/Asset_%d\",\"size\":%d,\"hash\":\"%08x\"}"),
+                i == 0 ? TEXT("") : TEXT(","), i, (i * 7919) % 104729,
+                GetTypeHash(i));
+        }
+        Request += TEXT("]}");
+
+        FTCHARToUTF8 Utf8(*Request);
+
+        return TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()),
+            Utf8.Length());
+    }
+}
+
+/**
+ * Measures what compressing requests costs and saves for each size of a
+ * request
+ *
+ * The files are read back from the page cache, so the measured time is the
+ * CPU time of mapping and decompression. The time of reading the file from
+ * slower storages is modelled from its size and added to that
+ */
+BEGIN_DEFINE_SPEC(FCompressedRequestProviderBenchmarkSpec,
+                  "XYZProduct.Benchmark.RequestCompression",
+                  EAutomationTestFlags::PerfFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FString Directory;
+
+/**
+ * Writes the contents, reads them back through the providers and reports
+ * the times
+ */
+void Measure(const FString& Name, const TArray<uint8>& Contents,
+    int32 UncompressedSize)
+{
+    FString Path = FPaths::Combine(Directory, Name);
+    TestTrue(FString::Printf(TEXT("Expecting `%s` to be written"), *Name),
+        FFileHelper::SaveArrayToFile(Contents, *Path));
+
+    double BestTime = MAX_dbl;
+    for (int32 i = 0; i < NumberOfRepetitions; i++)
+    {
+        FCompressedRequestProvider Provider(
+            MakeUnique<FMappedFileRequestProvider>(Path));
+
+        double StartTime = FPlatformTime::Seconds();
+        TArrayView<const uint8> View = Provider.RetrieveView();
+        BestTime = FMath::Min(BestTime, FPlatformTime::Seconds() - StartTime);
+
+        TestEqual(FString::Printf(TEXT("%s: expecting the whole request"),
+            *Name), View.Num(), UncompressedSize);
+    }
+
+    FString ModelledTimes;
+    for (double Bandwidth : Bandwidths)
+    {
+        double ReadTime = Contents.Num() / (Bandwidth * 1024.0 * 1024.0);
+        ModelledTimes += FString::Printf(TEXT(", %.2f ms at %.0f MB/s"),
+            (ReadTime + BestTime) * 1000.0, Bandwidth);
+    }
+
+    AddInfo(FString::Printf(TEXT("%s: %d bytes (%.1f%%), decompressed in "
+        "%.2f ms%s"), *Name, Contents.Num(),
+        100.0 * Contents.Num() / UncompressedSize, BestTime * 1000.0,
+        *ModelledTimes));
+}
+
+END_DEFINE_SPEC(FCompressedRequestProviderBenchmarkSpec)
+
+void FCompressedRequestProviderBenchmarkSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Directory = FPaths::Combine(FPaths::AutomationTransientDir(),
+            TEXT("RequestCompression"));
+        IFileManager::Get().MakeDirectory(*Directory, true);
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    });
+
+    for (int32 Size : RequestSizes)
+    {
+        It(FString::Printf(TEXT("%d bytes"), Size), [this, Size]()
+        {
+            TArray<uint8> Request = MakeRequest(Size);
+
+            Measure(TEXT("Raw"), Request, Request.Num());
+
+            TArray<uint8> Compressed;
+            if (FCompressedRequestProvider::Compress(Request,
+                FCompressedRequestProvider::EMethod::Zlib, Compressed))
+            {
+                Measure(TEXT("Zlib"), Compressed, Request.Num());
+            }
+
+            if (FCompression::IsFormatValid(NAME_Oodle) &&
+                FCompressedRequestProvider::Compress(Request,
+                    FCompressedRequestProvider::EMethod::Oodle, Compressed))
+            {
+                Measure(TEXT("Oodle"), Compressed, Request.Num());
+            }
+            else
+            {
+                AddInfo(TEXT("Oodle isn't available in this build"));
+            }
+        });
+    }
+}
@@ -0,0 +1,167 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Compression.h"
+#include "CompressedRequestProvider.h"
+#include "RequestSpecHelpers.h"
+
+namespace
+{
+    TArray<uint8> MakeRequest(int32 NumberOfAssets)
+    {
+        FString Request = TEXT("{\"version\":\"1.0.0\",\"assets\":[");
+        for (int32 i = 0; i < NumberOfAssets; i++)
+        {
+            Request += FString::Printf(TEXT("%s{\"path\":\"/Game/Props/"
+                "Asset_%d\",\"size\":%d}"), i == 0 ? TEXT("") : TEXT(","),
+                i, (i * 7919) % 104729);
+        }
+        Request += TEXT("]}");
+
+        return FRequestSpecHelpers::ToUtf8(Request);
+    }
+
+    TArray<uint8> CompressGzip(TArrayView<const uint8> Contents)
+    {
+        int32 CompressedSize =
+            FCompression::CompressMemoryBound(NAME_Gzip, Contents.Num());
+        TArray<uint8> Compressed;
+        Compressed.SetNumUninitialized(CompressedSize);
+        if (!FCompression::CompressMemory(NAME_Gzip, Compressed.GetData(),
+            CompressedSize, Contents.GetData(), Contents.Num()))
+        {
+            return TArray<uint8>();
+        }
+        Compressed.SetNum(CompressedSize);
+
+        return Compressed;
+    }
+}
+
+BEGIN_DEFINE_SPEC(FCompressedRequestProviderSpec,
+                  "XYZProduct.Loading.CompressedRequestProvider",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+TArray<uint8> Request;
+
+/**
+ * Decompresses the contents and compares the result with the expected
+ * bytes, not only with their size
+ */
+void CheckDecompressed(const FString& What, TArray<uint8> Contents,
+    TArrayView<const uint8> Expected)
+{
+    FCompressedRequestProvider Provider(
+        MakeUnique<FMemoryRequestProvider>(MoveTemp(Contents)));
+    TArrayView<const uint8> View = Provider.RetrieveView();
+
+    TestTrue(What, View.Num() == Expected.Num() &&
+        FMemory::Memcmp(View.GetData(), Expected.GetData(),
+            Expected.Num()) == 0);
+}
+
+END_DEFINE_SPEC(FCompressedRequestProviderSpec)
+
+void FCompressedRequestProviderSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Request = MakeRequest(4096);
+    });
+
+    It("Uncompressed request",
+        [this]()
+        {
+            CheckDecompressed("Expecting the request as it is", Request,
+                Request);
+        }
+    );
+
+    It("Zlib container",
+        [this]()
+        {
+            //Small chunks make the last one partial
+            TArray<uint8> Compressed;
+            TestTrue("Expecting the request to be compressed",
+                FCompressedRequestProvider::Compress(Request,
+                    FCompressedRequestProvider::EMethod::Zlib, Compressed,
+                    1000));
+
+            CheckDecompressed("Expecting the decompressed request to match",
+                MoveTemp(Compressed), Request);
+        }
+    );
+
+    It("Gzip",
+        [this]()
+        {
+            CheckDecompressed("Expecting the decompressed request to match",
+                CompressGzip(Request), Request);
+        }
+    );
+
+    It("Gzip of several members",
+        [this]()
+        {
+            //The trailer of the last member states only its own size
+            int32 Half = Request.Num() / 2;
+            TArrayView<const uint8> View = Request;
+            TArray<uint8> Compressed = CompressGzip(View.Slice(0, Half));
+            Compressed.Append(CompressGzip(
+                View.Slice(Half, Request.Num() - Half)));
+
+            CheckDecompressed("Expecting all the members to be decompressed",
+                MoveTemp(Compressed), Request);
+        }
+    );
+
+    It("Gzip with a forged size in the trailer",
+        [this]()
+        {
+            TArray<uint8> Compressed = CompressGzip(Request);
+            FMemory::Memset(Compressed.GetData() + Compressed.Num() - 4, 0xFF,
+                4);
+
+            CheckDecompressed("Expecting the size in the trailer not to matter",
+                MoveTemp(Compressed), Request);
+        }
+    );
+
+    It("Truncated gzip",
+        [this]()
+        {
+            AddExpectedError(TEXT("Failed to decompress the gzip"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            TArray<uint8> Compressed = CompressGzip(Request);
+            Compressed.SetNum(Compressed.Num() / 2);
+
+            CheckDecompressed("Expecting nothing to be provided",
+                MoveTemp(Compressed), TArrayView<const uint8>());
+        }
+    );
+
+    It("Container with a chunk table bigger than the contents",
+        [this]()
+        {
+            AddExpectedError(TEXT("The compressed request is truncated"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            TArray<uint8> Compressed;
+            FCompressedRequestProvider::Compress(Request,
+                FCompressedRequestProvider::EMethod::Zlib, Compressed, 16);
+
+            //The header and the first chunk sizes are intact, the rest is cut
+            Compressed.SetNum(64);
+
+            CheckDecompressed("Expecting nothing to be provided",
+                MoveTemp(Compressed), TArrayView<const uint8>());
+        }
+    );
+}
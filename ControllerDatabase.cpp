@@ -0,0 +1,283 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "ControllerDatabase.h"
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GamepadDetection.h"
+
+namespace
+{
+	//Size of the fixed part of the file which precedes the keys
+	constexpr int64 kHeaderSize = sizeof(uint32) + sizeof(uint16) +
+		sizeof(uint16) + sizeof(uint32);
+
+	/**
+	* Builds a key the database is sorted by. Returns `false` if any of the
+	* IDs doesn't fit into 16 bits, such devices can't be in the database
+	*/
+	bool MakeKey(uint32 VendorID, uint32 ProductID, uint32& OutKey)
+	{
+		if (VendorID > 0xFFFFu || ProductID > 0xFFFFu)
+		{
+			return false;
+		}
+
+		OutKey = (VendorID << 16u) | ProductID;
+
+		return true;
+	}
+
+	//Converts a Steam controller type name into `EGamepadType`
+	bool ParseSteamControllerType(FString Name, EGamepadType& OutType)
+	{
+		Name.RemoveFromStart(TEXT("k_eControllerType_"));
+
+		struct FTypeName
+		{
+			const TCHAR* Name;
+			EGamepadType Type;
+		};
+
+		static const FTypeName TypeNames[] = {
+			{ TEXT("XBox360Controller"), EGamepadType::XBOX_360_GAMEPAD },
+			{ TEXT("XBoxOneController"), EGamepadType::XBOX_ONE_GAMEPAD },
+			{ TEXT("PS3Controller"), EGamepadType::PS3_GAMEPAD },
+			{ TEXT("PS4Controller"), EGamepadType::PS4_GAMEPAD },
+			{ TEXT("SwitchProController"), EGamepadType::SWITCH_GAMEPAD },
+			{ TEXT("SwitchJoyConLeft"), EGamepadType::SWITCH_GAMEPAD },
+			{ TEXT("SwitchJoyConRight"), EGamepadType::SWITCH_GAMEPAD },
+			{ TEXT("SwitchJoyConPair"), EGamepadType::SWITCH_GAMEPAD },
+			{ TEXT("SwitchInputOnlyController"),
+				EGamepadType::SWITCH_GAMEPAD }
+		};
+
+		for (const FTypeName& TypeName : TypeNames)
+		{
+			if (Name.Equals(TypeName.Name, ESearchCase::IgnoreCase))
+			{
+				OutType = TypeName.Type;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool ParseHexID(FString Value, uint32& OutID)
+	{
+		Value.TrimStartAndEndInline();
+		Value.RemoveFromStart(TEXT("0x"), ESearchCase::IgnoreCase);
+
+		if (Value.IsEmpty() || Value.Len() > 4)
+		{
+			return false;
+		}
+
+		for (TCHAR Character : Value)
+		{
+			if (!FChar::IsHexDigit(Character))
+			{
+				return false;
+			}
+		}
+
+		OutID = FParse::HexNumber(*Value);
+
+		return true;
+	}
+
+	template <typename Type>
+	void Append(TArray<uint8>& Data, Type Value)
+	{
+		// the format is little-endian
+		for (int32 i = 0; i < static_cast<int32>(sizeof(Type)); i++)
+		{
+			Data.Add(static_cast<uint8>(Value >> (8 * i)));
+		}
+	}
+}
+
+TSharedPtr<const FControllerDatabase, ESPMode::ThreadSafe>
+	FControllerDatabase::LoadFromFile(const FString& Path)
+{
+	TUniquePtr<IMappedFileHandle> Handle(
+		FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!Handle)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Unable to map controller database `%s`"), *Path);
+
+		return nullptr;
+	}
+
+	int64 FileSize = Handle->GetFileSize();
+	if (FileSize < kHeaderSize)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Controller database `%s` is truncated"), *Path);
+
+		return nullptr;
+	}
+
+	TUniquePtr<IMappedFileRegion> Region(Handle->MapRegion(0, FileSize));
+	if (!Region)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Unable to map controller database `%s`"), *Path);
+
+		return nullptr;
+	}
+
+	const uint8* Data = Region->GetMappedPtr();
+
+	uint32 Magic;
+	uint16 Version;
+	uint16 Reserved;
+	uint32 NumEntries;
+	FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	FMemory::Memcpy(&Version, Data + 4, sizeof(Version));
+	FMemory::Memcpy(&Reserved, Data + 6, sizeof(Reserved));
+	FMemory::Memcpy(&NumEntries, Data + 8, sizeof(NumEntries));
+
+	if (Magic != kMagic || Version != kVersion || Reserved != 0)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Controller database `%s` has unsupported format or version"
+				 " %d, supported one is %d"), *Path, Version, kVersion);
+
+		return nullptr;
+	}
+
+	int64 ExpectedSize = kHeaderSize +
+		static_cast<int64>(NumEntries) * (sizeof(uint32) + sizeof(uint8));
+	if (FileSize < ExpectedSize || NumEntries > MAX_int32)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Controller database `%s` is truncated"), *Path);
+
+		return nullptr;
+	}
+
+	// the header is 12 bytes long and mappings are page-aligned, so the keys
+	// are naturally aligned
+	TArrayView<const uint32> Keys(
+		reinterpret_cast<const uint32*>(Data + kHeaderSize),
+		static_cast<int32>(NumEntries));
+	const uint8* Types = Data + kHeaderSize + NumEntries * sizeof(uint32);
+
+	// the binary search relies on strictly ascending keys and the types are
+	// cast to `EGamepadType` as they are, so a corrupt file is rejected as a
+	// whole instead of producing wrong matches
+	for (int32 i = 0; i < Keys.Num(); i++)
+	{
+		if ((i > 0 && Keys[i - 1] >= Keys[i]) ||
+			Types[i] >= static_cast<uint8>(EGamepadType::UNKNOWN_GAMEPAD))
+		{
+			UE_LOG(LogGamepadDetection, Error,
+				TEXT("Controller database `%s` is corrupt at entry %d"),
+				*Path, i);
+
+			return nullptr;
+		}
+	}
+
+	TSharedPtr<FControllerDatabase, ESPMode::ThreadSafe> Database =
+		MakeShareable(new FControllerDatabase());
+	Database->Keys = Keys;
+	Database->Types = Types;
+	Database->Handle = MoveTemp(Handle);
+	Database->Region = MoveTemp(Region);
+
+	UE_LOG(LogGamepadDetection, Log,
+		TEXT("Controller database `%s` is loaded, %d controllers"), *Path,
+		Database->Num());
+
+	return Database;
+}
+
+int32 FControllerDatabase::BuildFromCsv(const FString& CsvContents,
+	TArray<uint8>& OutData)
+{
+	TArray<FString> Lines;
+	CsvContents.ParseIntoArrayLines(Lines);
+
+	TMap<uint32, EGamepadType> Entries;
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Columns;
+		Line.ParseIntoArray(Columns, TEXT(","), false);
+
+		uint32 VendorID;
+		uint32 ProductID;
+		EGamepadType Type;
+		if (Columns.Num() < 3 || !ParseHexID(Columns[0], VendorID) ||
+			!ParseHexID(Columns[1], ProductID))
+		{
+			continue;
+		}
+
+		if (!ParseSteamControllerType(Columns[2].TrimStartAndEnd(), Type))
+		{
+			UE_LOG(LogGamepadDetection, Verbose,
+				TEXT("Skipping controller %04x:%04x of unsupported type `%s`"),
+				VendorID, ProductID, *Columns[2]);
+			continue;
+		}
+
+		uint32 Key;
+		MakeKey(VendorID, ProductID, Key);
+		Entries.Add(Key, Type);
+	}
+
+	Entries.KeySort(TLess<uint32>());
+
+	OutData.Reset(kHeaderSize + Entries.Num() * 5);
+	Append<uint32>(OutData, kMagic);
+	Append<uint16>(OutData, kVersion);
+	Append<uint16>(OutData, 0);
+	Append<uint32>(OutData, Entries.Num());
+	for (const auto& Entry : Entries)
+	{
+		Append<uint32>(OutData, Entry.Key);
+	}
+	for (const auto& Entry : Entries)
+	{
+		OutData.Add(static_cast<uint8>(Entry.Value));
+	}
+
+	return Entries.Num();
+}
+
+bool FControllerDatabase::Find(uint32 VendorID, uint32 ProductID,
+	EGamepadType& OutType) const
+{
+	uint32 Key;
+	if (!MakeKey(VendorID, ProductID, Key))
+	{
+		return false;
+	}
+
+	int32 Index = Algo::BinarySearch(Keys, Key);
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutType = static_cast<EGamepadType>(Types[Index]);
+
+	return true;
+}
+
+int32 FControllerDatabase::Num() const
+{
+	return Keys.Num();
+}
+
+FControllerDatabase::~FControllerDatabase()
+{
+	// the region must be released before the handle it was mapped from
+	Region.Reset();
+	Handle.Reset();
+}
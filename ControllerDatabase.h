@@ -0,0 +1,111 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GamepadDetector.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* Read-only database of supported controllers which is stored in a compact
+* binary file and memory-mapped into the process
+*
+* The file is searched in place, nothing is copied on load. The layout of the
+* file is as follows (all values are little-endian):
+* - `uint32` magic, equals to `kMagic`
+* - `uint16` version of the format, equals to `kVersion`
+* - `uint16` reserved, must be zero
+* - `uint32` count of entries `N`
+* - `N` of `uint32` keys sorted in ascending order. The key is as follows
+* 0xVVVVPPPP, where VVVV is Vendor ID and PPPP is Product ID
+* - `N` of `uint8` values of `EGamepadType`, i-th value belongs to i-th key
+*
+* A file with keys out of order or duplicated, with a type other than a known
+* one or with a non-zero reserved field is rejected on load
+*
+* Keys and types are kept apart so that the binary search touches only the
+* keys. Use `BuildFromCsv()` (or `UBuildControllerDatabaseCommandlet`) to
+* produce a file
+*
+* Is immutable after load, thus is thread-safe
+*/
+class GAMEPADDETECTION_API FControllerDatabase
+{
+public:
+	//Magic number the file starts with, `GPDB` in ASCII
+	static constexpr uint32 kMagic = 0x42445047u;
+
+	//Version of the format which is produced and understood by this class
+	static constexpr uint16 kVersion = 1;
+
+	/**
+	* Maps a database file into memory and validates it
+	*
+	* @param Path Path to the database file
+	* @return The mapped database or `nullptr` if the file couldn't be mapped
+	* or is malformed
+	*/
+	static TSharedPtr<const FControllerDatabase, ESPMode::ThreadSafe>
+		LoadFromFile(const FString& Path);
+
+	/**
+	* Builds a database file from a CSV export of the Steam supported
+	* controller database
+	*
+	* Each line is expected to be `VendorID,ProductID,Type` where the IDs are
+	* hexadecimal (with or without `0x` prefix) and the type is a Steam
+	* controller type name (e.g. `k_eControllerType_PS4Controller` or just
+	* `PS4Controller`). Lines which can't be parsed (like the header) and
+	* controllers of types unknown to `EGamepadType` are skipped
+	*
+	* @param CsvContents Contents of the CSV file
+	* @param OutData Contents of the resulting database file
+	* @return Count of entries written into the database
+	*/
+	static int32 BuildFromCsv(const FString& CsvContents,
+		TArray<uint8>& OutData);
+
+	/**
+	* Searches the database for an entry with matching Vendor ID and
+	* Product ID
+	*
+	* @param VendorID Vendor ID of a device
+	* @param ProductID Product ID of a device
+	* @param OutType Type of the device, is set only if the entry was found
+	* @return `true` if the entry was found, `false` - otherwise
+	*/
+	bool Find(uint32 VendorID, uint32 ProductID, EGamepadType& OutType) const;
+
+	/**
+	* Returns count of controllers in the database
+	*
+	* @return Count of controllers in the database
+	*/
+	int32 Num() const;
+
+	FControllerDatabase(const FControllerDatabase&) = delete;
+
+	FControllerDatabase& operator=(const FControllerDatabase&) = delete;
+
+	/**
+	* Unmaps the file
+	*/
+	~FControllerDatabase();
+
+private:
+	FControllerDatabase() = default;
+
+	//Handle of the mapped file, must outlive `Region`
+	TUniquePtr<IMappedFileHandle> Handle;
+
+	//Mapped contents of the whole file
+	TUniquePtr<IMappedFileRegion> Region;
+
+	//Sorted keys, point into `Region`
+	TArrayView<const uint32> Keys;
+
+	//Types of the controllers, point into `Region`
+	const uint8* Types = nullptr;
+};
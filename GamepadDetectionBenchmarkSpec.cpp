@@ -0,0 +1,252 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "AllocationCounter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "GamepadDetector.h"
+#include "GamepadDetection.h"
+#include "ControllerDatabase.h"
+#include "HIDManager.h"
+
+namespace
+{
+	using FMeasurement = FAllocationCounter::FMeasurement;
+
+	/**
+	* HID manager which returns a fixed list of HIDs
+	*/
+	class FMockHIDManager : public FHIDManager
+	{
+	public:
+		explicit FMockHIDManager(int32 NumberOfHIDs)
+		{
+			// none of the devices is a controller, so the traditional
+			// algorithm always has to go through the whole list
+			for (int32 i = 0; i < NumberOfHIDs; i++)
+			{
+				FHID HID;
+				HID.HardwareID = FString::Printf(
+					TEXT("HID\\VID_FFFF&PID_%04X"), i);
+				HID.VendorID = 0xFFFF;
+				HID.ProductID = static_cast<uint32>(i);
+				HIDs.Add(MoveTemp(HID));
+			}
+		}
+
+		virtual TArray<FHID> QueryHIDs() override
+		{
+			return HIDs;
+		}
+
+	private:
+		TArray<FHID> HIDs;
+	};
+
+	/**
+	* Gamepad detector which runs against a stubbed Steam Input with one
+	* connected PS4 controller
+	*/
+	class FStubbedSteamGamepadDetector : public FGamepadDetector
+	{
+	public:
+		explicit FStubbedSteamGamepadDetector(bool bIsSteamAvailable)
+			: bIsSteamAvailable(bIsSteamAvailable) {}
+
+	protected:
+		virtual bool IsSteamInputAvailable() const override
+		{
+			return bIsSteamAvailable;
+		}
+
+		virtual bool InitSteamInput() override
+		{
+			return true;
+		}
+
+		virtual int32 GetConnectedSteamControllers(
+			ControllerHandle_t* OutHandles) override
+		{
+			OutHandles[0] = 1;
+
+			return 1;
+		}
+
+		virtual ESteamInputType GetSteamInputType(
+			ControllerHandle_t ControllerHandle) override
+		{
+			return ESteamInputType::k_ESteamInputType_PS4Controller;
+		}
+
+	private:
+		bool bIsSteamAvailable;
+	};
+
+	//Count of HIDs the mock HID manager is run with
+	const int32 kNumbersOfHIDs[] = { 0, 10, 100, 1000 };
+
+	//Count of controllers in the generated controller database, is about the
+	//size of the Steam supported controller database
+	constexpr int32 kNumberOfDatabaseControllers = 512;
+}
+
+BEGIN_DEFINE_SPEC(FGamepadDetectionBenchmarkSpec,
+	"GamepadDetection.Benchmark",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+//Verbosity of `LogGamepadDetection` to be restored after each benchmark
+ELogVerbosity::Type OriginalVerbosity;
+
+void Report(const FString& Name, const FMeasurement& Measurement)
+{
+	AddInfo(FString::Printf(TEXT("%s: %.1f ns/call, %.2f allocations/call"),
+		*Name, Measurement.NanosecondsPerCall,
+		Measurement.AllocationsPerCall));
+}
+
+//Runs the detector with each of the mock HID managers
+void BenchmarkHIDs(const FString& Name, FGamepadDetector& Detector)
+{
+	for (int32 NumberOfHIDs : kNumbersOfHIDs)
+	{
+		FMockHIDManager HIDManager(NumberOfHIDs);
+		Detector.SetHIDManager(&HIDManager);
+
+		int32 NumberOfCalls = FMath::Max(100, 100000 / (NumberOfHIDs + 1));
+		Report(FString::Printf(TEXT("%s, %d HIDs"), *Name, NumberOfHIDs),
+			FAllocationCounter::Measure(NumberOfCalls, [&Detector]()
+			{
+				Detector.UpdateGamepadType();
+			}));
+
+		TestEqual("Expecting no controller to be detected",
+			Detector.GetGamepadType(), EGamepadType::UNKNOWN_GAMEPAD);
+
+		Detector.SetHIDManager(nullptr);
+	}
+}
+
+END_DEFINE_SPEC(FGamepadDetectionBenchmarkSpec)
+
+void FGamepadDetectionBenchmarkSpec::Define()
+{
+	// the detector logs each HID, the benchmark measures the detection work
+	// only
+	BeforeEach([this]()
+	{
+		OriginalVerbosity = LogGamepadDetection.GetVerbosity();
+		LogGamepadDetection.SetVerbosity(ELogVerbosity::Fatal);
+	});
+
+	AfterEach([this]()
+	{
+		LogGamepadDetection.SetVerbosity(OriginalVerbosity);
+	});
+
+	It("NO_STEAM_STRATEGY",
+		[this]()
+		{
+			FGamepadDetector Detector;
+			Detector.SetDetectionStrategy(
+				EDetectionStrategy::NO_STEAM_STRATEGY);
+
+			BenchmarkHIDs("NO_STEAM_STRATEGY", Detector);
+		}
+	);
+
+	It("STEAM_USING_STRATEGY, Steam Input is unavailable",
+		[this]()
+		{
+			FStubbedSteamGamepadDetector Detector(false);
+
+			BenchmarkHIDs("STEAM_USING_STRATEGY (HID fallback)", Detector);
+		}
+	);
+
+	It("STEAM_USING_STRATEGY, stubbed Steam Input",
+		[this]()
+		{
+			FStubbedSteamGamepadDetector Detector(true);
+
+			Report("STEAM_USING_STRATEGY (stubbed Steam Input)",
+				FAllocationCounter::Measure(100000, [&Detector]()
+				{
+					Detector.UpdateGamepadType();
+				}));
+
+			TestEqual("Expecting a PS4 controller to be detected",
+				Detector.GetGamepadType(), EGamepadType::PS4_GAMEPAD);
+		}
+	);
+
+	It("Controller database lookup",
+		[this]()
+		{
+			FString Csv;
+			for (int32 i = 0; i < kNumberOfDatabaseControllers; i++)
+			{
+				Csv += FString::Printf(TEXT("0x%04x,0x%04x,PS4Controller\n"),
+					0x0100 + i % 16, i);
+			}
+
+			TArray<uint8> Data;
+			FControllerDatabase::BuildFromCsv(Csv, Data);
+
+			FString Path = FPaths::CreateTempFilename(
+				*FPaths::AutomationTransientDir(), TEXT("Controllers"),
+				TEXT(".bin"));
+			if (!TestTrue("Expecting the database to be written",
+				FFileHelper::SaveArrayToFile(Data, *Path)))
+			{
+				return;
+			}
+
+			{
+				auto Database = FControllerDatabase::LoadFromFile(Path);
+				if (TestTrue("Expecting the database to be loaded",
+					Database.IsValid()))
+				{
+					TestEqual("Expecting all controllers to be loaded",
+						Database->Num(), kNumberOfDatabaseControllers);
+
+					int32 Index = 0;
+					int32 NumberOfFound = 0;
+					Report(FString::Printf(
+						TEXT("Database lookup, %d controllers"),
+						Database->Num()),
+						FAllocationCounter::Measure(1000000, [&]()
+						{
+							EGamepadType Type;
+							int32 i = Index++ % kNumberOfDatabaseControllers;
+							NumberOfFound += Database->Find(0x0100 + i % 16,
+								i, Type);
+						}));
+
+					TestEqual("Expecting all lookups to succeed",
+						NumberOfFound, Index);
+
+					// none of the HIDs is a controller, so each of them is
+					// looked up in the database
+					FGamepadDetector Detector;
+					Detector.SetDetectionStrategy(
+						EDetectionStrategy::NO_STEAM_STRATEGY);
+					Detector.SetControllerDatabase(Database);
+
+					FMockHIDManager HIDManager(100);
+					Detector.SetHIDManager(&HIDManager);
+					Report("NO_STEAM_STRATEGY with database, 100 HIDs",
+						FAllocationCounter::Measure(1000, [&Detector]()
+						{
+							Detector.UpdateGamepadType();
+						}));
+				}
+			}
+
+			IFileManager::Get().Delete(*Path);
+		}
+	);
+}
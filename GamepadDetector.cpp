@@ -6,9 +6,37 @@
 #include "GenericPlatform/GenericPlatformAtomics.h"
 #include "HIDManager.h"
 #include "GamepadDetection.h"
+#include "ControllerDatabase.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Algo/BinarySearch.h"
 #include "steam/isteaminput.h"
 #include "steam/isteamcontroller.h"
 
+UE_TRACE_CHANNEL_DEFINE(GamepadDetectionChannel)
+
+namespace
+{
+	/**
+	* Adds the time spent in the scope to a counter
+	*/
+	class FScopedCycleAccumulator
+	{
+	public:
+		explicit FScopedCycleAccumulator(uint64& Counter)
+			: Counter(Counter), StartCycles(FPlatformTime::Cycles64()) {}
+
+		~FScopedCycleAccumulator()
+		{
+			Counter += FPlatformTime::Cycles64() - StartCycles;
+		}
+
+	private:
+		uint64& Counter;
+
+		uint64 StartCycles;
+	};
+}
+
 FGamepadDetector::FGamepadDetector()
 {
 	FamilyMap.Add(EGamepadType::PS3_GAMEPAD,
@@ -51,6 +79,18 @@ FGamepadDetector::FGamepadDetector()
 
 void FGamepadDetector::UpdateGamepadType()
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+		FGamepadDetector_UpdateGamepadType, GamepadDetectionChannel);
+
+	if (DetectionStrategy == EDetectionStrategy::STEAM_USING_STRATEGY)
+	{
+		Stats.NumberOfSteamStrategyCalls++;
+	}
+	else
+	{
+		Stats.NumberOfNoSteamStrategyCalls++;
+	}
+
 	UpdateGamepadTypeSteamBased();
 }
 
@@ -60,11 +100,16 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 	// unavailable - use HID based approach
 	if (DetectionStrategy == EDetectionStrategy::STEAM_USING_STRATEGY)
 	{
-		if (SteamInput() != nullptr)
+		if (IsSteamInputAvailable())
 		{
 			if (!bIsSteamInputInitialized)
 			{
-				bIsSteamInputInitialized = SteamInput()->Init();
+				TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+					FGamepadDetector_InitSteamInput, GamepadDetectionChannel);
+				FScopedCycleAccumulator Accumulator(
+					Stats.SteamInputInitCycles);
+
+				bIsSteamInputInitialized = InitSteamInput();
 			}
 
 			if (bIsSteamInputInitialized)
@@ -72,13 +117,22 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 				bool bWasDetected = false;
 
 				ControllerHandle_t ControllerHandles[STEAM_CONTROLLER_MAX_COUNT];
-				int32 NumControllers = static_cast<int32>(
-					SteamInput()->GetConnectedControllers(ControllerHandles));
+				int32 NumControllers;
+				{
+					TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+						FGamepadDetector_GetConnectedControllers,
+						GamepadDetectionChannel);
+					FScopedCycleAccumulator Accumulator(
+						Stats.GetConnectedControllersCycles);
+
+					NumControllers =
+						GetConnectedSteamControllers(ControllerHandles);
+				}
 				for (int32 i = 0; i < NumControllers; i++)
 				{
 					ControllerHandle_t ControllerHandle = ControllerHandles[i];
 					ESteamInputType InputType =
-						SteamInput()->GetInputTypeForHandle(ControllerHandle);
+						GetSteamInputType(ControllerHandle);
 
 					UE_LOG(LogGamepadDetection, Log, TEXT("Input Type: %d"),
 						static_cast<uint32>(InputType));
@@ -99,6 +153,8 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 
 				if (!bWasDetected)
 				{
+					Stats.NumberOfDetectionFailures++;
+
 					UE_LOG(LogGamepadDetection, Warning,
 						TEXT("The detection failed. No controller was detected"
 							 " using Steam"));
@@ -106,6 +162,8 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 			}
 			else
 			{
+				Stats.NumberOfDetectionFailures++;
+
 				UE_LOG(LogGamepadDetection, Error,
 					TEXT("Unable to initialize"" Steam Input"));
 			}
@@ -118,6 +176,7 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 			UE_LOG(LogGamepadDetection, Log,
 				TEXT("Proceeding to the traditional algorithm"));
 
+			Stats.NumberOfSteamToHIDFallbacks++;
 			UpdateGamepadTypeHIDBased();
 		}
 	}
@@ -127,11 +186,41 @@ void FGamepadDetector::UpdateGamepadTypeSteamBased()
 	}
 }
 
+bool FGamepadDetector::IsSteamInputAvailable() const
+{
+	return SteamInput() != nullptr;
+}
+
+bool FGamepadDetector::InitSteamInput()
+{
+	return SteamInput()->Init();
+}
+
+int32 FGamepadDetector::GetConnectedSteamControllers(
+	ControllerHandle_t* OutHandles)
+{
+	return static_cast<int32>(
+		SteamInput()->GetConnectedControllers(OutHandles));
+}
+
+ESteamInputType FGamepadDetector::GetSteamInputType(
+	ControllerHandle_t ControllerHandle)
+{
+	return SteamInput()->GetInputTypeForHandle(ControllerHandle);
+}
+
 void FGamepadDetector::UpdateGamepadTypeHIDBased()
 {
 	if (HIDManager)
 	{
-		TArray<FHID> HIDs = HIDManager->QueryHIDs();
+		TArray<FHID> HIDs;
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+				FGamepadDetector_QueryHIDs, GamepadDetectionChannel);
+			FScopedCycleAccumulator Accumulator(Stats.QueryHIDsCycles);
+
+			HIDs = HIDManager->QueryHIDs();
+		}
 
 		for (const auto& HID : HIDs)
 		{
@@ -139,12 +228,25 @@ void FGamepadDetector::UpdateGamepadTypeHIDBased()
 				TEXT("The device's description strings: Hardware ID: %s,"
 					 " Vendor ID: %04x, Product ID: %04x"),
 				*HID.HardwareID, HID.VendorID, HID.ProductID);
+		}
 
-			bool WasSet = FindAndSetGamepad(HID.VendorID,
-				HID.ProductID);
-			if (WasSet)
+		// each layer goes through all of the HIDs before a less precise one
+		// is tried, so an exact match of any device beats a range or vendor
+		// match of another one (e.g. of a keyboard or a dongle of the same
+		// vendor which happens to be listed first)
+		for (EMatchPrecision Precision : { EMatchPrecision::EXACT,
+			EMatchPrecision::PRODUCT_RANGE, EMatchPrecision::VENDOR })
+		{
+			for (const auto& HID : HIDs)
 			{
-				return;
+				EGamepadType Type;
+				if (FindGamepadType(HID.VendorID, HID.ProductID, Precision,
+					Type))
+				{
+					SetGamepadType(Type);
+
+					return;
+				}
 			}
 		}
 
@@ -152,6 +254,8 @@ void FGamepadDetector::UpdateGamepadTypeHIDBased()
 	}
 	else
 	{
+		Stats.NumberOfDetectionFailures++;
+
 		UE_LOG(LogGamepadDetection, Error,
 			TEXT("HID manager is not set. Call `SetHIDManager()` first"));
 	}
@@ -159,6 +263,8 @@ void FGamepadDetector::UpdateGamepadTypeHIDBased()
 
 void FGamepadDetector::OnDetectionFailed(int NumberOfHIDs)
 {
+	Stats.NumberOfDetectionFailures++;
+
 	SetGamepadType(EGamepadType::UNKNOWN_GAMEPAD);
 
 	UE_LOG(LogGamepadDetection, Warning,
@@ -168,23 +274,114 @@ void FGamepadDetector::OnDetectionFailed(int NumberOfHIDs)
 			 " of connected HIDs"), NumberOfHIDs);
 }
 
-bool FGamepadDetector::FindAndSetGamepad(uint32 VendorID, uint32 ProductID)
+bool FGamepadDetector::FindGamepadType(uint32 VendorID, uint32 ProductID,
+	EMatchPrecision Precision, EGamepadType& OutType) const
 {
-	uint64 Key = 0;
+	switch (Precision)
+	{
+	case EMatchPrecision::EXACT:
+	{
+		uint64 Key = 0;
 
-	Key |= VendorID;
-	Key <<= 32u;
-	Key |= ProductID;
+		Key |= VendorID;
+		Key <<= 32u;
+		Key |= ProductID;
 
-	EGamepadType* Type = ControllersMap.Find(Key);
-	if (Type)
+		const EGamepadType* Type = ControllersMap.Find(Key);
+		if (Type)
+		{
+			OutType = *Type;
+
+			return true;
+		}
+
+		return ControllerDatabase.IsValid() &&
+			ControllerDatabase->Find(VendorID, ProductID, OutType);
+	}
+	case EMatchPrecision::PRODUCT_RANGE:
 	{
-		SetGamepadType(*Type);
+		// USB ids are 16-bit, anything wider can't be in the ranges
+		if (VendorID > 0xFFFFu || ProductID > 0xFFFFu ||
+			ControllerRanges.Num() == 0)
+		{
+			return false;
+		}
+
+		uint32 RangeKey = (VendorID << 16u) | ProductID;
+
+		// the last range which starts at or before the key is the only one
+		// which may contain it
+		int32 Index = Algo::UpperBoundBy(ControllerRanges, RangeKey,
+			&FControllerRange::FirstKey) - 1;
+		if (Index >= 0 && RangeKey <= ControllerRanges[Index].LastKey)
+		{
+			OutType = ControllerRanges[Index].Type;
+
+			return true;
+		}
 
-		return true;
+		return false;
 	}
+	case EMatchPrecision::VENDOR:
+	{
+		const EGamepadType* Type = VendorDefaultsMap.Find(VendorID);
+		if (Type)
+		{
+			OutType = *Type;
+
+			return true;
+		}
 
-	return false;
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+void FGamepadDetector::AddControllerRangeSupport(uint32 VendorID,
+	uint32 FirstProductID, uint32 LastProductID, EGamepadType Type)
+{
+	if (VendorID > 0xFFFFu || FirstProductID > LastProductID ||
+		LastProductID > 0xFFFFu)
+	{
+		UE_LOG(LogGamepadDetection, Error,
+			TEXT("Invalid range of controllers: Vendor ID: %04x, Product IDs:"
+				 " %04x-%04x"), VendorID, FirstProductID, LastProductID);
+
+		return;
+	}
+
+	FControllerRange Range;
+	Range.FirstKey = (VendorID << 16u) | FirstProductID;
+	Range.LastKey = (VendorID << 16u) | LastProductID;
+	Range.Type = Type;
+
+	// ranges are added rarely and looked up on each detection, so they are
+	// kept sorted on insertion
+	int32 Index = Algo::LowerBoundBy(ControllerRanges, Range.FirstKey,
+		&FControllerRange::FirstKey);
+
+	// the vendor is a part of the keys, so only the ranges of the same
+	// vendor can overlap and the neighbours are the only candidates
+	bool bOverlapsPrevious = Index > 0 &&
+		ControllerRanges[Index - 1].LastKey >= Range.FirstKey;
+	bool bOverlapsNext = Index < ControllerRanges.Num() &&
+		ControllerRanges[Index].FirstKey <= Range.LastKey;
+	if (!ensureMsgf(!bOverlapsPrevious && !bOverlapsNext,
+		TEXT("The range of controllers overlaps an added one: Vendor ID:"
+			 " %04x, Product IDs: %04x-%04x"), VendorID, FirstProductID,
+		LastProductID))
+	{
+		return;
+	}
+
+	ControllerRanges.Insert(Range, Index);
+}
+
+void FGamepadDetector::AddVendorSupport(uint32 VendorID, EGamepadType Type)
+{
+	VendorDefaultsMap.Add(VendorID, Type);
 }
 
 void FGamepadDetector::SetHIDManager(FHIDManager* NewHIDManager)
@@ -192,8 +389,25 @@ void FGamepadDetector::SetHIDManager(FHIDManager* NewHIDManager)
 	HIDManager = NewHIDManager;
 }
 
+void FGamepadDetector::SetControllerDatabase(
+	TSharedPtr<const FControllerDatabase, ESPMode::ThreadSafe>
+		NewControllerDatabase)
+{
+	ControllerDatabase = MoveTemp(NewControllerDatabase);
+}
+
 void FGamepadDetector::SetGamepadType(EGamepadType NewGamepadType)
 {
+	if (NewGamepadType != GamepadType)
+	{
+		Stats.NumberOfTypeChanges++;
+
+		UE_LOG(LogGamepadDetection, Verbose,
+			TEXT("Gamepad type has changed: %d -> %d"),
+			static_cast<uint32>(GamepadType),
+			static_cast<uint32>(NewGamepadType));
+	}
+
 	GamepadType = NewGamepadType;
 
 	EGamepadFamily* NewGamepadFamily = FamilyMap.Find(NewGamepadType);
@@ -209,6 +423,16 @@ void FGamepadDetector::SetGamepadType(EGamepadType NewGamepadType)
 	}
 }
 
+const FGamepadDetectionStats& FGamepadDetector::GetStats() const
+{
+	return Stats;
+}
+
+void FGamepadDetector::ResetStats()
+{
+	Stats = FGamepadDetectionStats();
+}
+
 int32 FGamepadDetector::GetNumberOfSupportedControllers() const
 {
 	return ControllersMap.Num();
@@ -8,8 +8,16 @@
 #include <regex>
 #include "HIDManager.h"
 #include "steam/isteaminput.h"
+#include "Trace/Trace.h"
 #include "GamepadDetector.generated.h"
 
+class FControllerDatabase;
+
+//Trace channel the detection work is reported through, is off by default.
+//Enable it with `-trace=cpu,GamepadDetection` to see the detection scopes
+//alongside the input-related ones
+UE_TRACE_CHANNEL_EXTERN(GamepadDetectionChannel, GAMEPADDETECTION_API)
+
 /**
 * Enum which describes what kind of gamepad the player is using.
 * Is a blueprint type
@@ -64,6 +72,45 @@ enum class EDetectionStrategy : uint8
 	NO_STEAM_STRATEGY
 };
 
+/**
+* Counters of the work done by `FGamepadDetector`
+*
+* Times are measured in CPU cycles, use `FPlatformTime::ToSeconds64()` to
+* convert them
+*
+* @see FGamepadDetector::GetStats()
+*/
+struct GAMEPADDETECTION_API FGamepadDetectionStats
+{
+	//Count of `UpdateGamepadType()` calls with
+	//`EDetectionStrategy::STEAM_USING_STRATEGY` set
+	uint64 NumberOfSteamStrategyCalls = 0;
+
+	//Count of `UpdateGamepadType()` calls with
+	//`EDetectionStrategy::NO_STEAM_STRATEGY` set
+	uint64 NumberOfNoSteamStrategyCalls = 0;
+
+	//Count of times Steam Input was unavailable and the traditional
+	//algorithm was used instead
+	uint64 NumberOfSteamToHIDFallbacks = 0;
+
+	//Count of `UpdateGamepadType()` calls which haven't detected any
+	//controller, including the ones when Steam Input failed to initialize
+	uint64 NumberOfDetectionFailures = 0;
+
+	//Count of times the current type of gamepad has changed
+	uint64 NumberOfTypeChanges = 0;
+
+	//Total time spent in `SteamInput()->Init()`
+	uint64 SteamInputInitCycles = 0;
+
+	//Total time spent in `SteamInput()->GetConnectedControllers()`
+	uint64 GetConnectedControllersCycles = 0;
+
+	//Total time spent in `FHIDManager::QueryHIDs()`
+	uint64 QueryHIDsCycles = 0;
+};
+
 /**
 * Class which provides means to determine the type and the family of gamepad
 * the player is currently using
@@ -90,7 +137,8 @@ public:
 	* The traditional algorithm does not run if the HID manager is not set.
 	* 
 	* The traditional algorithm is based on list of connected HID devices
-	* (which is retrieved from hid.dll) which. During the execution of the
+	* (which is retrieved from hid.dll on Windows and from hidraw on Linux,
+	* see `FLinuxHIDManager`) which. During the execution of the
 	* algorithm the method retrieves list of connected HIDs and tries to find
 	* each of connected HIDs in the list of supported controllers (which is a
 	* precise copy of this database
@@ -171,6 +219,35 @@ public:
 		ControllersMap.Add(Key, Type);
 	}
 
+	/**
+	* Adds support of a range of controllers of one vendor through manual
+	* mapping of VID and range of PIDs to the type
+	* 
+	* The ranges are looked up only if no connected device has an exact
+	* VID/PID match. The ranges of one vendor must not overlap, a range which
+	* overlaps an added one fails an `ensure` and isn't added
+	* 
+	* @param VendorID Vendor id of the devices
+	* @param FirstProductID The first product id of the range
+	* @param LastProductID The last product id of the range, inclusive
+	* @param Type Type of the devices
+	*/
+	void AddControllerRangeSupport(uint32 VendorID, uint32 FirstProductID,
+		uint32 LastProductID, EGamepadType Type);
+
+	/**
+	* Adds support of all controllers of a vendor through manual mapping of
+	* VID to the type
+	* 
+	* The vendor default is used only if no connected device has either an
+	* exact VID/PID match or a matching range. Is meant for vendors who
+	* release new product ids for the same kind of controller
+	* 
+	* @param VendorID Vendor id of the devices
+	* @param Type Type of the devices
+	*/
+	void AddVendorSupport(uint32 VendorID, EGamepadType Type);
+
 	/**
 	* Returns count of controllers which were added through
 	* `AddControllerSupport()`
@@ -193,11 +270,79 @@ public:
 	*/
 	void SetHIDManager(FHIDManager* NewHIDManager);
 
+	/**
+	* Returns counters of the detection work done since the construction or
+	* the last `ResetStats()` call
+	* 
+	* @return Counters of the detection work
+	* @see FGamepadDetectionStats
+	*/
+	const FGamepadDetectionStats& GetStats() const;
+
+	/**
+	* Resets all the detection counters to zero
+	*/
+	void ResetStats();
+
+	/**
+	* Sets the database of supported controllers which is searched by the
+	* traditional algorithm after the controllers added through
+	* `AddControllerSupport()`
+	* 
+	* The database is used in place, nothing is copied into the detector, so
+	* it may be hot-swapped at any moment between `UpdateGamepadType()` calls.
+	* The previous database stays mapped until the last reference to it is
+	* released
+	* 
+	* @param NewControllerDatabase The database to use, `nullptr` to use only
+	* the controllers added through `AddControllerSupport()`
+	* @see FControllerDatabase
+	*/
+	void SetControllerDatabase(TSharedPtr<const FControllerDatabase,
+		ESPMode::ThreadSafe> NewControllerDatabase);
+
 	/**
 	* Default destructor
 	*/
 	virtual ~FGamepadDetector() = default;
 
+protected:
+	/**
+	* Checks whether Steam Input interface is available
+	* 
+	* The Steam Input-related methods exist so that the Steam-based algorithm
+	* can be run against a stubbed Steam Input (e.g. in benchmarks)
+	* 
+	* @return `true` if Steam Input is available, `false` - otherwise
+	*/
+	virtual bool IsSteamInputAvailable() const;
+
+	/**
+	* Initializes Steam Input
+	* 
+	* @return `true` if Steam Input was initialized, `false` - otherwise
+	*/
+	virtual bool InitSteamInput();
+
+	/**
+	* Retrieves handles of the controllers connected through Steam Input
+	* 
+	* @param OutHandles Array of at least `STEAM_CONTROLLER_MAX_COUNT`
+	* elements to be filled with the handles
+	* @return Count of connected controllers
+	*/
+	virtual int32 GetConnectedSteamControllers(
+		ControllerHandle_t* OutHandles);
+
+	/**
+	* Returns Steam type of a controller connected through Steam Input
+	* 
+	* @param ControllerHandle Handle of the controller
+	* @return Type of the controller in terms of Steam Input
+	*/
+	virtual ESteamInputType GetSteamInputType(
+		ControllerHandle_t ControllerHandle);
+
 private:
 	/**
 	* Sets the current type of gamepad. Automatically sets the current family
@@ -209,18 +354,36 @@ private:
 	void SetGamepadType(EGamepadType NewGamepadType);
 
 	/**
-	* Searches `ControllersMap` for an entry with matching Vendor ID and
-	* Product ID and if succeeds sets according type and family
-	* 
-	* If `ControllersMap` contains an entry with specified Product ID and
-	* Vendor ID sets the type from that entry and the according to that type
-	* family as current gamepad type and family values
-	* 
+	* Layers of the lookup of a controller, from the most precise one
+	*/
+	enum class EMatchPrecision : uint8
+	{
+		//Exact VID/PID match in `ControllersMap` or `ControllerDatabase`
+		EXACT,
+
+		//VID match with PID in one of `ControllerRanges`
+		PRODUCT_RANGE,
+
+		//VID match in `VendorDefaultsMap`
+		VENDOR
+	};
+
+	/**
+	* Searches one layer of the lookup for a controller with matching Vendor
+	* ID and Product ID
+	*
+	* The HID-based algorithm tries all of the HIDs against a layer before
+	* going to the next one, so a less precise match of one device never
+	* beats a more precise match of another one
+	*
 	* @param VendorID Vendor ID of a device
 	* @param ProductID Product ID of a device
+	* @param Precision The layer to search
+	* @param OutType Type of the device, is set only if the entry was found
 	* @return `true` if the entry was found, `false` - otherwise
 	*/
-	bool FindAndSetGamepad(uint32 VendorID, uint32 ProductID);
+	bool FindGamepadType(uint32 VendorID, uint32 ProductID,
+		EMatchPrecision Precision, EGamepadType& OutType) const;
 
 	/**
 	* Executes the traditional HID-based algorithm of the gamepad detection
@@ -267,6 +430,30 @@ private:
 	*/
 	TMap<uint64, EGamepadType> ControllersMap;
 
+	/**
+	* Range of product ids of one vendor mapped to a type. Is stored with
+	* the same key layout as `FControllerDatabase` uses - 0xVVVVPPPP, so a
+	* range of one vendor is a contiguous interval of keys
+	*/
+	struct FControllerRange
+	{
+		uint32 FirstKey;
+
+		uint32 LastKey;
+
+		EGamepadType Type;
+	};
+
+	//Ranges of supported controllers sorted by `FirstKey`
+	TArray<FControllerRange> ControllerRanges;
+
+	//Is used to map Vendor IDs to a type when nothing more precise matches
+	TMap<uint32, EGamepadType> VendorDefaultsMap;
+
+	//Memory-mapped database of supported controllers, may be not set
+	TSharedPtr<const FControllerDatabase, ESPMode::ThreadSafe>
+		ControllerDatabase;
+
 	//Is used to define the relation between gamepad types and gamepad families
 	TMap<EGamepadType, EGamepadFamily> FamilyMap;
 
@@ -275,10 +462,13 @@ private:
 	TMap<ESteamInputType, EGamepadType> SteamGamepadTypeToGamepadTypeMap;
 	
 	//Contains family of gamepad the player is using
-	EGamepadFamily GamepadFamily;
+	EGamepadFamily GamepadFamily = EGamepadFamily::UNKNOWN_FAMILY;
 
 	//Contains type of gamepad the player is using
-	EGamepadType GamepadType;
+	EGamepadType GamepadType = EGamepadType::UNKNOWN_GAMEPAD;
+
+	//Counters of the detection work
+	FGamepadDetectionStats Stats;
 
 	//Manager of HIDs
 	FHIDManager* HIDManager;
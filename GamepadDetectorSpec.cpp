@@ -0,0 +1,139 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "GamepadDetector.h"
+#include "GamepadDetection.h"
+#include "HIDManager.h"
+
+namespace
+{
+	//Vendor the test controllers are registered for, isn't used by any real
+	//controller known to the detector
+	constexpr uint32 kVendorID = 0xF00D;
+
+	/**
+	* HID manager which returns the given HIDs in the given order
+	*/
+	class FListHIDManager : public FHIDManager
+	{
+	public:
+		explicit FListHIDManager(
+			TArray<TPair<uint32, uint32>> VendorAndProductIDs)
+		{
+			for (const auto& IDs : VendorAndProductIDs)
+			{
+				FHID HID;
+				HID.HardwareID = FString::Printf(
+					TEXT("HID\\VID_%04X&PID_%04X"), IDs.Key, IDs.Value);
+				HID.VendorID = IDs.Key;
+				HID.ProductID = IDs.Value;
+				HIDs.Add(MoveTemp(HID));
+			}
+		}
+
+		virtual TArray<FHID> QueryHIDs() override
+		{
+			return HIDs;
+		}
+
+	private:
+		TArray<FHID> HIDs;
+	};
+}
+
+BEGIN_DEFINE_SPEC(FGamepadDetectorSpec,
+	"GamepadDetection.Detector",
+	EAutomationTestFlags::ProductFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+/**
+* Runs the HID-based detection over the HIDs with a PS4 controller as the
+* exact match, a range of Xbox One controllers and a Switch vendor default
+*/
+EGamepadType Detect(TArray<TPair<uint32, uint32>> VendorAndProductIDs)
+{
+	FGamepadDetector Detector;
+	Detector.SetDetectionStrategy(EDetectionStrategy::NO_STEAM_STRATEGY);
+	Detector.AddControllerSupport(kVendorID, 0x0001,
+		EGamepadType::PS4_GAMEPAD);
+	Detector.AddControllerRangeSupport(kVendorID, 0x0100, 0x01FF,
+		EGamepadType::XBOX_ONE_GAMEPAD);
+	Detector.AddVendorSupport(kVendorID, EGamepadType::SWITCH_GAMEPAD);
+
+	FListHIDManager HIDManager(MoveTemp(VendorAndProductIDs));
+	Detector.SetHIDManager(&HIDManager);
+	Detector.UpdateGamepadType();
+	Detector.SetHIDManager(nullptr);
+
+	return Detector.GetGamepadType();
+}
+
+END_DEFINE_SPEC(FGamepadDetectorSpec)
+
+void FGamepadDetectorSpec::Define()
+{
+	It("Exact match",
+		[this]()
+		{
+			TestEqual("Expecting the exact match to be used",
+				Detect({ { kVendorID, 0x0001 } }),
+				EGamepadType::PS4_GAMEPAD);
+		}
+	);
+
+	It("Range match",
+		[this]()
+		{
+			TestEqual("Expecting the range to be used",
+				Detect({ { kVendorID, 0x0142 } }),
+				EGamepadType::XBOX_ONE_GAMEPAD);
+		}
+	);
+
+	It("Vendor default match",
+		[this]()
+		{
+			TestEqual("Expecting the vendor default to be used",
+				Detect({ { kVendorID, 0x0F00 } }),
+				EGamepadType::SWITCH_GAMEPAD);
+		}
+	);
+
+	It("No match",
+		[this]()
+		{
+			TestEqual("Expecting no controller to be detected",
+				Detect({ { 0xFFFF, 0x0001 } }),
+				EGamepadType::UNKNOWN_GAMEPAD);
+		}
+	);
+
+	It("Range match of an earlier HID, exact match of a later one",
+		[this]()
+		{
+			TestEqual("Expecting the exact match to win",
+				Detect({ { kVendorID, 0x0142 }, { kVendorID, 0x0001 } }),
+				EGamepadType::PS4_GAMEPAD);
+		}
+	);
+
+	It("Vendor default match of an earlier HID, exact match of a later one",
+		[this]()
+		{
+			TestEqual("Expecting the exact match to win",
+				Detect({ { kVendorID, 0x0F00 }, { kVendorID, 0x0001 } }),
+				EGamepadType::PS4_GAMEPAD);
+		}
+	);
+
+	It("Vendor default match of an earlier HID, range match of a later one",
+		[this]()
+		{
+			TestEqual("Expecting the range match to win",
+				Detect({ { kVendorID, 0x0F00 }, { kVendorID, 0x0142 } }),
+				EGamepadType::XBOX_ONE_GAMEPAD);
+		}
+	);
+}
@@ -1,6 +1,7 @@
 //Flying Wild Hog. All rights reserved
 
 #include "GoogleDesktopOAuth.h"
+#include "GoogleDesktopOAuthLog.h"
 #include "HttpModule.h"
 #include "Misc/StringBuilder.h"
 #include "Interfaces/IHttpResponse.h"
@@ -10,12 +11,54 @@
 #include "HttpUtils.h"
 #include "GenericPlatform/GenericPlatformProcess.h"
 #include "Misc/MessageDialog.h"
-#include "HttpServerModule.h"
 #include "IHttpRouter.h"
 #include "HttpServerResponse.h"
+#include "Misc/Base64.h"
+#include "RSA.h"
+#include "Algo/Reverse.h"
+#include "PlatformCryptoTypes.h"
+#include "IPlatformCrypto.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Atomic.h"
+#include "GoogleTokenStore.h"
+#include "Utf8JsonFieldReader.h"
 
-//Default values are All, All
-DEFINE_LOG_CATEGORY_STATIC(LogGoogleDesktopOAuth, All, All);
+DEFINE_LOG_CATEGORY(LogGoogleDesktopOAuth)
+
+namespace
+{
+	//DER-encoded `DigestInfo` prefix of a PKCS#1 v1.5 SHA-256 signature
+	const uint8 kSha256DigestInfoPrefix[] = {
+		0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65,
+		0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+	};
+
+	//Decodes base64url without padding (as used by JWT and JWK)
+	bool DecodeBase64Url(FString Source, TArray<uint8>& OutData)
+	{
+		Source.ReplaceCharInline(TEXT('-'), TEXT('+'));
+		Source.ReplaceCharInline(TEXT('_'), TEXT('/'));
+		while (Source.Len() % 4 != 0)
+		{
+			Source.AppendChar(TEXT('='));
+		}
+
+		return FBase64::Decode(Source, OutData);
+	}
+
+	//JWK numbers are big-endian, `FRSA` takes numbers in the native
+	//little-endian order
+	TArray<uint8> ToLittleEndian(TArray<uint8> Number)
+	{
+		Algo::Reverse(Number);
+
+		return Number;
+	}
+}
+
+FGoogleDesktopOAuth::FGoogleDesktopOAuth(FEndpoints Endpoints)
+	: Endpoints(MoveTemp(Endpoints)) {}
 
 void FGoogleDesktopOAuth::RefreshAuthToken(
 	RefreshCallbackType Callback, FString ClientId,
@@ -34,12 +77,12 @@ void FGoogleDesktopOAuth::RefreshAuthToken(
 			bool bWasSuccessful) {
 		HandleResultOfRequest(Request, Response, bWasSuccessful,
 			[Callback, this]
-			(TSharedPtr<FJsonObject> Data, Status Code)
+			(const FUtf8JsonFieldReader& Data, Status Code)
 			{
 				//try to retrieve `access_token` and `expires_in`
 				FString AccessToken;
 				int64 ExpiresIn;
-				bool bIsPresented = Data->TryGetStringField(
+				bool bIsPresented = Data.TryGetStringField(
 						kGoogleRefreshTokenResponseAccessTokenField,
 					AccessToken);
 
@@ -48,13 +91,13 @@ void FGoogleDesktopOAuth::RefreshAuthToken(
 					UE_LOG(LogGoogleDesktopOAuth, Error,
 						TEXT("Unable to extract `%s` field from the response,"
 							 " aborting"),
-						*kGoogleRefreshTokenResponseAccessTokenField);
+						kGoogleRefreshTokenResponseAccessTokenField);
 
 					Callback("", 0, Status::kInvalidResponseFormatCode);
 					return;
 				}
 
-				ExpiresIn = Data->GetIntegerField(
+				ExpiresIn = Data.GetIntegerField(
 					kGoogleRefreshTokenResponseExpiresInField);
 
 				UE_LOG(LogGoogleDesktopOAuth, Log,
@@ -62,6 +105,7 @@ void FGoogleDesktopOAuth::RefreshAuthToken(
 				//set absolute expiration datetime
 				int64 ExpiresOn = FDateTime::Now().ToUnixTimestamp() +
 					ExpiresIn;
+				RememberAccessToken(AccessToken, ExpiresOn);
 				Callback(MoveTemp(AccessToken), ExpiresOn,
 					Status::kSuccessCode);
 			},
@@ -77,15 +121,20 @@ void FGoogleDesktopOAuth::RefreshAuthToken(
 		kGoogleRefreshTokenGrantTypeValue, MoveTemp(RefreshToken));
 }
 
+void FGoogleDesktopOAuth::SetRetryPolicy(const FRetryPolicy& Policy)
+{
+	HttpSession.SetRetryPolicy(Policy);
+}
+
 void FGoogleDesktopOAuth::RefreshAuthTokenImpl(HttpRequestCallbackType Callback,
 	FString ClientID, FString ClientSecret, FString GrantType,
 	FString RefreshToken) const
 {
 	auto Request =
-		FHttpModule::Get().CreateRequest();
+		HttpSession.CreateRequest();
 	Request->SetVerb(kPostMethod);
 	Request->SetHeader(kContentTypeHeader, kUrlencodedContentType);
-	Request->SetURL(kGoogleRefreshTokenUrl);
+	Request->SetURL(Endpoints.RefreshTokenUrl);
 
 	//for the parameters meaning refer to google oauth docs
 	TMap<FString, FString> Params;
@@ -96,8 +145,7 @@ void FGoogleDesktopOAuth::RefreshAuthTokenImpl(HttpRequestCallbackType Callback,
 
 	FString Content = FHttpUtils::BuildUrlEncodedPayload(Params);
 	Request->SetContentAsString(Content);
-	Request->OnProcessRequestComplete().BindLambda(Callback);
-	Request->ProcessRequest();
+	HttpSession.ProcessRequest(Request, MoveTemp(Callback));
 }
 
 void FGoogleDesktopOAuth::HandleResultOfRequest(FHttpRequestPtr Request,
@@ -122,11 +170,9 @@ void FGoogleDesktopOAuth::HandleResultOfRequest(FHttpRequestPtr Request,
 
 		if (ResponseContentType == kJsonContentType)
 		{
-			TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-			TSharedRef<TJsonReader<TCHAR>> JsonReader =
-				TJsonReaderFactory<TCHAR>::Create(
-					Response->GetContentAsString());
-			FJsonSerializer::Deserialize(JsonReader, JsonObject);
+			// the fields are read straight from the UTF-8 body, the
+			// responses are small and only a couple of fields are needed
+			FUtf8JsonFieldReader Data(Response->GetContent());
 
 			//todo(artsiom.drapun@fuerogames.pl): move codes to consts?
 			if (ResponseCode >= 200 && ResponseCode < 300)
@@ -135,7 +181,7 @@ void FGoogleDesktopOAuth::HandleResultOfRequest(FHttpRequestPtr Request,
 					TEXT("The auth-related request has been successfully"
 						 " completed"));
 
-				SuccessfulRequestCallback(JsonObject, Status::kSuccessCode);
+				SuccessfulRequestCallback(Data, Status::kSuccessCode);
 			}
 			else
 			{
@@ -143,9 +189,9 @@ void FGoogleDesktopOAuth::HandleResultOfRequest(FHttpRequestPtr Request,
 				FString ErrorCode;
 				FString Error;
 
-				JsonObject->TryGetStringField(
+				Data.TryGetStringField(
 					kGoogleRefreshTokenResponseErrorCodeField, ErrorCode);
-				JsonObject->TryGetStringField(
+				Data.TryGetStringField(
 					kGoogleRefreshTokenResponseErrorField, Error);
 
 				if (ErrorCode == kInvalidGrantErrorCode)
@@ -170,7 +216,7 @@ void FGoogleDesktopOAuth::HandleResultOfRequest(FHttpRequestPtr Request,
 		{
 			UE_LOG(LogGoogleDesktopOAuth, Error,
 				TEXT("Unsupported response content type - `%s`, supported one"
-					 " is `%s`"), *ResponseContentType, *kJsonContentType);
+					 " is `%s`"), *ResponseContentType, kJsonContentType);
 
 			FailedRequestCallback(Status::kUnsupportedResponseContentTypeCode);
 		}
@@ -191,71 +237,39 @@ void FGoogleDesktopOAuth::AuthenticateManually(
 {
 	if (Method == AuthenticationMethod::LoopbackIp)
 	{
-		//for the parameters meaning refer to google oauth docs
-		TMap<FString, FString> UrlPayloadData;
-		UrlPayloadData.Add(kManualAuthenticationScopeField, Scopes);
-		UrlPayloadData.Add(kManualAuthenticationResponseTypeField,
-			kManualAuthenticationResponseTypeValue);
-
-		FString RedirectUri = kLoopbackAddressBase +
-			FString::FromInt(LoopbackPort) + kLoopbackAddressPath;
-		UrlPayloadData.Add(kManualAuthenticationRedirectUriField,
-			RedirectUri);
-		UrlPayloadData.Add(kManualAuthenticationClientIdField,
-			ClientId);
-
-		FString UrlPayload = FHttpUtils::BuildUrlEncodedPayload(UrlPayloadData);
-		FPlatformProcess::LaunchURL(
-			*(kManualAuthenticationUrlBase + UrlPayload), nullptr,
-			nullptr);
-
-		if (!FHttpServerModule::IsAvailable())
+		// the idea is the following: own server instance on localhost serves
+		// as a loopback ip. the only endpoint on this instance is
+		// kLoopbackAddressPath and the same loopback url is passed into the
+		// auth request, so when the auth request returns it'll "call"
+		// loopback url. the listener has to be up before the browser is
+		// opened, otherwise the redirect may find nothing on the port
+		uint32 Port =
+			LoopbackListener.Start(static_cast<uint32>(LoopbackPort));
+		if (Port == 0)
 		{
-			FModuleManager::LoadModuleChecked<FHttpServerModule>("HTTPServer");
+			UE_LOG(LogGoogleDesktopOAuth, Error,
+				TEXT("The loopback listener cannot be started. Unable to"
+					 " perform manual authentication"));
+			Callback("", 0, "", Status::kUnknownErrorCode);
+			return;
 		}
 
-		if (FHttpServerModule::IsAvailable())
+		// the browser is sent to the port only once the probe has reached
+		// the route, a port taken by another process would get the code
+		LoopbackListener.WhenRouteConfirmed([this, Callback, Scopes, ClientId,
+			ClientSecret, Port](bool bIsConfirmed)
 		{
-			// the idea is the following: start own server instance on localhost
-			// which will serve as a loopback ip. the only endpoint on this
-			// instance will be kLoopbackAddressPath and the same loopback url
-			// will be passed into the auth request, so when the auth request
-			// returns it'll "call" loopback url
-			FHttpServerModule& HttpServer = FHttpServerModule::Get();
-			TSharedPtr<IHttpRouter> Router =
-				HttpServer.GetHttpRouter(LoopbackPort);
-
-			// the endpoint handler
-			FHttpRequestHandler Handler = [this, Callback = MoveTemp(Callback),
-				RedirectUri = MoveTemp(RedirectUri),
-				ClientId = MoveTemp(ClientId),
-				ClientSecret = MoveTemp(ClientSecret)]
-			(const FHttpServerRequest& Request,
-			 const FHttpResultCallback& OnComplete) -> bool
-			{
-				HandleTheResultOfLoopbackAuthentication(Callback, OnComplete,
-					RedirectUri, ClientId, ClientSecret, Request);
-
-				return true;
-			};
-
-			// in case if it'sn not the first time we start the server instance
-			if (RouterHandle.IsValid())
+			if (!bIsConfirmed)
 			{
-				Router->UnbindRoute(RouterHandle);
+				UE_LOG(LogGoogleDesktopOAuth, Error,
+					TEXT("The loopback listener cannot be reached. Unable to"
+						 " perform manual authentication"));
+				Callback("", 0, "", Status::kUnknownErrorCode);
+				return;
 			}
-			RouterHandle = Router->BindRoute(FHttpPath(kLoopbackAddressPath),
-				EHttpServerRequestVerbs::VERB_GET |
-				EHttpServerRequestVerbs::VERB_POST, MoveTemp(Handler));
-			HttpServer.StartAllListeners();
-		}
-		else
-		{
-			UE_LOG(LogGoogleDesktopOAuth, Error,
-				TEXT("The HTTP server module cannot be loaded. Unable to"
-					 " perform manual authentication"));
-			Callback("", 0, "", Status::kUnknownErrorCode);
-		}
+
+			LaunchConsentPage(Callback, Scopes, ClientId, ClientSecret, Port);
+		});
 	}
 	else
 	{
@@ -267,6 +281,48 @@ void FGoogleDesktopOAuth::AuthenticateManually(
 	}
 }
 
+void FGoogleDesktopOAuth::LaunchConsentPage(
+	ManualAuthenticationCallbackType Callback, FString Scopes,
+	FString ClientId, FString ClientSecret, uint32 Port)
+{
+	FString RedirectUri = kLoopbackAddressBase + FString::FromInt(Port) +
+		kLoopbackAddressPath;
+
+	// the endpoint handler
+	FGoogleLoopbackListener::RequestHandlerType Handler = [this, Callback,
+		RedirectUri, ClientId, ClientSecret]
+	(const FHttpServerRequest& Request,
+	 const FHttpResultCallback& OnComplete)
+	{
+		HandleTheResultOfLoopbackAuthentication(Callback, OnComplete,
+			RedirectUri, ClientId, ClientSecret, Request);
+	};
+
+	FString State = LoopbackListener.AddAttempt(MoveTemp(Handler),
+		[Callback]()
+		{
+			UE_LOG(LogGoogleDesktopOAuth, Error,
+				TEXT("The authentication hasn't been finished in the"
+					 " browser in time"));
+
+			Callback("", 0, "", Status::kTimeoutCode);
+		}, kManualAuthenticationTimeoutSeconds);
+
+	//for the parameters meaning refer to google oauth docs
+	TMap<FString, FString> UrlPayloadData;
+	UrlPayloadData.Add(kManualAuthenticationScopeField, Scopes);
+	UrlPayloadData.Add(kManualAuthenticationResponseTypeField,
+		kManualAuthenticationResponseTypeValue);
+	UrlPayloadData.Add(kManualAuthenticationRedirectUriField, RedirectUri);
+	UrlPayloadData.Add(kManualAuthenticationClientIdField, ClientId);
+	UrlPayloadData.Add(FGoogleLoopbackListener::kStateField, State);
+
+	FString UrlPayload = FHttpUtils::BuildUrlEncodedPayload(UrlPayloadData);
+	FPlatformProcess::LaunchURL(
+		*(Endpoints.ManualAuthenticationUrlBase + UrlPayload), nullptr,
+		nullptr);
+}
+
 void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 	ManualAuthenticationCallbackType Callback, 
 	const FHttpResultCallback& OnComplete, FString RedirectUri,
@@ -285,11 +341,11 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 			" please.");
 
 		auto HttpRequest =
-			FHttpModule::Get().CreateRequest();
+			HttpSession.CreateRequest();
 		HttpRequest->SetVerb(kPostMethod);
 		HttpRequest->SetHeader(kContentTypeHeader,
 			kUrlencodedContentType);
-		HttpRequest->SetURL(kCodeExchangeUrlBase);
+		HttpRequest->SetURL(Endpoints.CodeExchangeUrl);
 
 		//check google oauth docs for the meaning of each parameter
 		TMap<FString, FString> Params;
@@ -314,16 +370,16 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 		{
 			HandleResultOfRequest(Request, Response, bWasSuccessful,
 				[Callback, this]
-				(TSharedPtr<FJsonObject> Data, Status Code)
+				(const FUtf8JsonFieldReader& Data, Status Code)
 				{
 					//try to retrieve `access_token`, `refresh_token` and
 					//`expires_in`
 					FString AccessToken;
 					FString RefreshToken;
 					int64 ExpiresIn;
-					bool bIsPresented = Data->TryGetStringField(
+					bool bIsPresented = Data.TryGetStringField(
 						kCodeExchangeResponseAccessTokenField, AccessToken);
-					bIsPresented &= Data->TryGetStringField(
+					bIsPresented &= Data.TryGetStringField(
 							kCodeExchangeResponseRefreshTokenField,
 							RefreshToken);
 
@@ -332,14 +388,14 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 						UE_LOG(LogGoogleDesktopOAuth, Error,
 							TEXT("Unable to extract from the response one of"
 								 " the following fields: `%s`, `%s`, aborting"),
-							*kCodeExchangeResponseAccessTokenField,
-							*kCodeExchangeResponseRefreshTokenField);
+							kCodeExchangeResponseAccessTokenField,
+							kCodeExchangeResponseRefreshTokenField);
 
 						Callback("", 0, "", Status::kInvalidResponseFormatCode);
 						return;
 					}
 
-					ExpiresIn = Data->GetIntegerField(
+					ExpiresIn = Data.GetIntegerField(
 						kCodeExchangeResponseExpiresInField);
 
 					UE_LOG(LogGoogleDesktopOAuth, Log,
@@ -347,6 +403,7 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 					//set absolute expiration datetime
 					int64 ExpiresOn = FDateTime::Now().ToUnixTimestamp() +
 						ExpiresIn;
+					RememberAccessToken(AccessToken, ExpiresOn);
 					Callback(MoveTemp(AccessToken), ExpiresOn,
 						MoveTemp(RefreshToken), Status::kSuccessCode);
 				},
@@ -359,8 +416,7 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 				}
 			);
 		};
-		HttpRequest->OnProcessRequestComplete().BindLambda(Handler);
-		HttpRequest->ProcessRequest();
+		HttpSession.ProcessRequest(HttpRequest, MoveTemp(Handler));
 	}
 	else
 	{
@@ -371,7 +427,8 @@ void FGoogleDesktopOAuth::HandleTheResultOfLoopbackAuthentication(
 		FString* Error = Request.QueryParams.Find(
 			kManualAuthenticationResponseErrorField);
 		UE_LOG(LogGoogleDesktopOAuth, Error,
-			TEXT("Unable to authenticate: `%s`"), **Error);
+			TEXT("Unable to authenticate: `%s`"),
+			Error ? **Error : TEXT("unknown error"));
 
 		Callback("", 0, "", Status::kInvalidGrantErrorCode);
 	}
@@ -391,28 +448,46 @@ void FGoogleDesktopOAuth::Answer(const FHttpResultCallback& OnComplete,
 }
 
 void FGoogleDesktopOAuth::CheckAccessToken(
-	AccessTokenCheckCallbackType Callback, FString AccessToken)
+	AccessTokenCheckCallbackType Callback, FString AccessToken,
+	TokenValidationMode Mode)
 {
+	if (Mode == TokenValidationMode::LocalFirst)
+	{
+		LocalVerdict Verdict = CheckAccessTokenLocally(AccessToken);
+		if (Verdict != LocalVerdict::Uncertain)
+		{
+			UE_LOG(LogGoogleDesktopOAuth, Log,
+				TEXT("The access token has been checked locally and the token"
+					 " is %s"),
+				Verdict == LocalVerdict::Valid ? TEXT("fine") :
+					TEXT("expired"));
+
+			Callback(Verdict == LocalVerdict::Valid ? Status::kSuccessCode :
+				Status::kInvalidTokenCode);
+			return;
+		}
+	}
+
 	//just send a "ping" request with this token to user info endpoint
 	// if the request succeeds then token is valid
 	auto Request =
-		FHttpModule::Get().CreateRequest();
+		HttpSession.CreateRequest();
 	Request->SetVerb(kGetMethod);
 	Request->SetHeader(kContentTypeHeader,
 		kUrlencodedContentType);
-	FString Url = kUserInfoUrlBase;
+	FString Url = Endpoints.UserInfoUrlBase;
 	Url += AccessToken;
 
 	Request->SetURL(Url);
 
-	Request->OnProcessRequestComplete().BindLambda(
+	HttpSession.ProcessRequest(Request,
 		[this, Callback = MoveTemp(Callback)]
 		(FHttpRequestPtr Request, FHttpResponsePtr Response,
 			bool bWasSuccessful)
 		{
 			HandleResultOfRequest(Request, Response, bWasSuccessful,
 				[Callback, this]
-				(TSharedPtr<FJsonObject> Data, Status Code)
+				(const FUtf8JsonFieldReader& Data, Status Code)
 				{
 					UE_LOG(LogGoogleDesktopOAuth, Log,
 						TEXT("The access token has been checked and the token"
@@ -430,5 +505,677 @@ void FGoogleDesktopOAuth::CheckAccessToken(
 			);
 		}
 	);
-	Request->ProcessRequest();
+}
+
+struct FGoogleDesktopOAuth::FBatchCheck
+{
+	AccessTokenBatchCheckCallbackType Callback;
+
+	TArray<FString> AccessTokens;
+
+	FAccessTokenBatchCheckResult Result;
+
+	//Indices of the tokens which have to be checked remotely
+	TArray<int32> RemoteIndices;
+
+	//Position in `RemoteIndices` the next remote check takes
+	TAtomic<int32> NextRemoteIndex{ 0 };
+
+	TAtomic<int32> NumberOfPendingChecks{ 0 };
+};
+
+void FGoogleDesktopOAuth::CheckAccessTokens(
+	AccessTokenBatchCheckCallbackType Callback, TArray<FString> AccessTokens,
+	TokenValidationMode Mode, int32 MaxRequestsInFlight)
+{
+	// one state is shared by the whole batch instead of a callback per token
+	TSharedRef<FBatchCheck, ESPMode::ThreadSafe> Batch =
+		MakeShared<FBatchCheck, ESPMode::ThreadSafe>();
+	Batch->Callback = MoveTemp(Callback);
+	Batch->Result.Codes.Init(Status::kUnknownErrorCode, AccessTokens.Num());
+
+	for (int32 i = 0; i < AccessTokens.Num(); i++)
+	{
+		LocalVerdict Verdict = Mode == TokenValidationMode::LocalFirst ?
+			CheckAccessTokenLocally(AccessTokens[i]) :
+			LocalVerdict::Uncertain;
+		if (Verdict == LocalVerdict::Uncertain)
+		{
+			Batch->RemoteIndices.Add(i);
+			continue;
+		}
+
+		Batch->Result.Codes[i] = Verdict == LocalVerdict::Valid ?
+			Status::kSuccessCode : Status::kInvalidTokenCode;
+		Batch->Result.NumberOfLocalChecks++;
+	}
+	Batch->AccessTokens = MoveTemp(AccessTokens);
+
+	UE_LOG(LogGoogleDesktopOAuth, Log,
+		TEXT("%d of %d access tokens have been checked locally"),
+		Batch->Result.NumberOfLocalChecks, Batch->AccessTokens.Num());
+
+	if (Batch->RemoteIndices.Num() == 0)
+	{
+		FinishBatchCheck(*Batch);
+		return;
+	}
+
+	Batch->NumberOfPendingChecks = Batch->RemoteIndices.Num();
+
+	// each of the chains takes the next token when its check returns
+	int32 NumberOfChains = FMath::Clamp(MaxRequestsInFlight, 1,
+		Batch->RemoteIndices.Num());
+	for (int32 i = 0; i < NumberOfChains; i++)
+	{
+		ContinueBatchCheck(Batch);
+	}
+}
+
+void FGoogleDesktopOAuth::ContinueBatchCheck(
+	TSharedRef<FBatchCheck, ESPMode::ThreadSafe> Batch)
+{
+	int32 Position = Batch->NextRemoteIndex++;
+	if (Position >= Batch->RemoteIndices.Num())
+	{
+		return;
+	}
+
+	int32 Index = Batch->RemoteIndices[Position];
+	CheckAccessToken([this, Batch, Index](Status Code)
+		{
+			Batch->Result.Codes[Index] = Code;
+
+			if (--Batch->NumberOfPendingChecks == 0)
+			{
+				FinishBatchCheck(*Batch);
+				return;
+			}
+
+			ContinueBatchCheck(Batch);
+		}, Batch->AccessTokens[Index], TokenValidationMode::Remote);
+}
+
+void FGoogleDesktopOAuth::FinishBatchCheck(FBatchCheck& Batch) const
+{
+	for (Status Code : Batch.Result.Codes)
+	{
+		if (Code == Status::kSuccessCode)
+		{
+			Batch.Result.NumberOfValidTokens++;
+		}
+	}
+
+	UE_LOG(LogGoogleDesktopOAuth, Log,
+		TEXT("%d of %d access tokens are fine"),
+		Batch.Result.NumberOfValidTokens, Batch.Result.Codes.Num());
+
+	Batch.Callback(Batch.Result);
+}
+
+void FGoogleDesktopOAuth::RememberAccessToken(const FString& AccessToken,
+	int64 ExpiresOn)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (AccessTokenExpirations.Num() >= kMaxRememberedAccessTokens)
+	{
+		// forget expired tokens first, and everything if that's not enough
+		int64 Now = FDateTime::Now().ToUnixTimestamp();
+		for (auto It = AccessTokenExpirations.CreateIterator(); It; ++It)
+		{
+			if (It.Value() <= Now)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		if (AccessTokenExpirations.Num() >= kMaxRememberedAccessTokens)
+		{
+			AccessTokenExpirations.Reset();
+		}
+	}
+
+	AccessTokenExpirations.Add(AccessToken, ExpiresOn);
+}
+
+FGoogleDesktopOAuth::LocalVerdict FGoogleDesktopOAuth::CheckAccessTokenLocally(
+	const FString& AccessToken) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const int64* ExpiresOn = AccessTokenExpirations.Find(AccessToken);
+	if (!ExpiresOn)
+	{
+		return LocalVerdict::Uncertain;
+	}
+
+	return *ExpiresOn - kTokenExpirationSkewSeconds >
+		FDateTime::Now().ToUnixTimestamp() ? LocalVerdict::Valid :
+			LocalVerdict::Invalid;
+}
+
+void FGoogleDesktopOAuth::CheckIdToken(AccessTokenCheckCallbackType Callback,
+	FString IdToken, FString ClientId)
+{
+	LocalVerdict Verdict = CheckIdTokenLocally(IdToken, ClientId);
+	if (Verdict != LocalVerdict::Uncertain)
+	{
+		Callback(Verdict == LocalVerdict::Valid ? Status::kSuccessCode :
+			Status::kInvalidTokenCode);
+		return;
+	}
+
+	// the key the token is signed with is unknown, the keys might have been
+	// rotated since they were cached
+	FetchJsonWebKeys(
+		[this, Callback = MoveTemp(Callback), IdToken = MoveTemp(IdToken),
+			ClientId = MoveTemp(ClientId)](Status Code)
+		{
+			if (Code != Status::kSuccessCode)
+			{
+				Callback(Code);
+				return;
+			}
+
+			// still uncertain means that the key doesn't exist at all
+			Callback(CheckIdTokenLocally(IdToken, ClientId) ==
+				LocalVerdict::Valid ? Status::kSuccessCode :
+					Status::kInvalidTokenCode);
+		});
+}
+
+FGoogleDesktopOAuth::LocalVerdict FGoogleDesktopOAuth::CheckIdTokenLocally(
+	const FString& IdToken, const FString& ClientId) const
+{
+	// the token is `header.payload.signature`, each part is base64url
+	TArray<FString> Segments;
+	IdToken.ParseIntoArray(Segments, TEXT("."), false);
+	if (Segments.Num() != 3)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error, TEXT("The ID token is malformed"));
+
+		return LocalVerdict::Invalid;
+	}
+
+	// the decoded header and payload are UTF-8 JSON objects
+	TArray<uint8> HeaderData;
+	TArray<uint8> PayloadData;
+	TArray<uint8> Signature;
+	if (!DecodeBase64Url(Segments[0], HeaderData) ||
+		!DecodeBase64Url(Segments[1], PayloadData) ||
+		!DecodeBase64Url(Segments[2], Signature))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error, TEXT("The ID token is malformed"));
+
+		return LocalVerdict::Invalid;
+	}
+
+	FUtf8JsonFieldReader Header(HeaderData);
+	FUtf8JsonFieldReader Payload(PayloadData);
+
+	FString Algorithm;
+	FString KeyId;
+	Header.TryGetStringField(kIdTokenAlgorithmField, Algorithm);
+	Header.TryGetStringField(kJwksKeyIdField, KeyId);
+	if (Algorithm != kIdTokenAlgorithmValue)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The ID token is signed with unsupported algorithm `%s`"),
+			*Algorithm);
+
+		return LocalVerdict::Invalid;
+	}
+
+	// the key is copied so that the lock isn't held during the verification
+	FJsonWebKey Key;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const FJsonWebKey* CachedKey = JsonWebKeys.Find(KeyId);
+		if (!CachedKey ||
+			JsonWebKeysExpiresOn <= FDateTime::Now().ToUnixTimestamp())
+		{
+			return LocalVerdict::Uncertain;
+		}
+
+		Key = *CachedKey;
+	}
+
+	// the signature is PKCS#1 v1.5 over SHA-256 of `header.payload`
+	FTCHARToUTF8 SigningInput(*(Segments[0] + TEXT(".") + Segments[1]));
+	FSHA256Signature Hash;
+	TUniquePtr<FEncryptionContext> EncryptionContext =
+		IPlatformCrypto::Get().CreateContext();
+	if (!EncryptionContext->CalcSHA256(TArrayView<const uint8>(
+		reinterpret_cast<const uint8*>(SigningInput.Get()),
+		SigningInput.Length()), Hash))
+	{
+		return LocalVerdict::Uncertain;
+	}
+
+	TArray<uint8> DigestInfo;
+	FRSA::TKeyPtr PublicKey = FRSA::CreateKey(ToLittleEndian(Key.Exponent),
+		TArray<uint8>(), ToLittleEndian(Key.Modulus));
+	if (!PublicKey)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("The key `%s` the ID token is signed with is unusable"),
+			*KeyId);
+
+		return LocalVerdict::Uncertain;
+	}
+
+	int32 DigestInfoSize = FRSA::DecryptPublic(Signature, DigestInfo,
+		PublicKey);
+	FRSA::FreeKey(PublicKey);
+
+	constexpr int32 kPrefixSize = sizeof(kSha256DigestInfoPrefix);
+	constexpr int32 kHashSize = sizeof(Hash.Signature);
+	if (DigestInfoSize != kPrefixSize + kHashSize ||
+		FMemory::Memcmp(DigestInfo.GetData(), kSha256DigestInfoPrefix,
+			kPrefixSize) != 0 ||
+		FMemory::Memcmp(DigestInfo.GetData() + kPrefixSize, Hash.Signature,
+			kHashSize) != 0)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The signature of the ID token doesn't match"));
+
+		return LocalVerdict::Invalid;
+	}
+
+	int64 ExpiresOn = 0;
+	FString Audience;
+	FString Issuer;
+	Payload.TryGetNumberField(kIdTokenExpirationField, ExpiresOn);
+	Payload.TryGetStringField(kIdTokenAudienceField, Audience);
+	Payload.TryGetStringField(kIdTokenIssuerField, Issuer);
+
+	// `exp` is UTC
+	if (ExpiresOn - kTokenExpirationSkewSeconds <=
+		FDateTime::UtcNow().ToUnixTimestamp())
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Log, TEXT("The ID token has expired"));
+
+		return LocalVerdict::Invalid;
+	}
+
+	if (Audience != ClientId ||
+		(Issuer != kIdTokenIssuer && Issuer != kIdTokenIssuerWithoutScheme))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The ID token is issued by `%s` for `%s`"), *Issuer,
+			*Audience);
+
+		return LocalVerdict::Invalid;
+	}
+
+	return LocalVerdict::Valid;
+}
+
+void FGoogleDesktopOAuth::FetchJsonWebKeys(
+	AccessTokenCheckCallbackType Callback)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		JsonWebKeysCallbacks.Add(MoveTemp(Callback));
+		if (JsonWebKeysCallbacks.Num() > 1)
+		{
+			return;
+		}
+	}
+
+	auto Request =
+		HttpSession.CreateRequest();
+	Request->SetVerb(kGetMethod);
+	Request->SetURL(Endpoints.JwksUrl);
+
+	HttpSession.ProcessRequest(Request,
+		[this](FHttpRequestPtr Request, FHttpResponsePtr Response,
+			bool bWasSuccessful)
+		{
+			auto NotifyAll = [this](Status Code)
+			{
+				TArray<AccessTokenCheckCallbackType> Callbacks;
+				{
+					FScopeLock Lock(&CriticalSection);
+
+					Callbacks = MoveTemp(JsonWebKeysCallbacks);
+				}
+				for (auto& Callback : Callbacks)
+				{
+					Callback(Code);
+				}
+			};
+
+			HandleResultOfRequest(Request, Response, bWasSuccessful,
+				[this, Response, NotifyAll]
+				(const FUtf8JsonFieldReader& Data, Status Code)
+				{
+					// the keys are nested, so the whole DOM is needed here
+					TSharedPtr<FJsonObject> JsonObject = Data.ToJsonObject();
+					const TArray<TSharedPtr<FJsonValue>>* KeysValues;
+					if (!JsonObject.IsValid() ||
+						!JsonObject->TryGetArrayField(kJwksKeysField,
+							KeysValues))
+					{
+						UE_LOG(LogGoogleDesktopOAuth, Error,
+							TEXT("Unable to extract `%s` field from the"
+								 " response, aborting"), kJwksKeysField);
+
+						NotifyAll(Status::kInvalidResponseFormatCode);
+						return;
+					}
+
+					TMap<FString, FJsonWebKey> Keys;
+					for (const auto& KeyValue : *KeysValues)
+					{
+						const TSharedPtr<FJsonObject>* KeyObject;
+						FString KeyId;
+						FString Modulus;
+						FString Exponent;
+						FJsonWebKey Key;
+						if (KeyValue->TryGetObject(KeyObject) &&
+							(*KeyObject)->TryGetStringField(kJwksKeyIdField,
+								KeyId) &&
+							(*KeyObject)->TryGetStringField(kJwksModulusField,
+								Modulus) &&
+							(*KeyObject)->TryGetStringField(kJwksExponentField,
+								Exponent) &&
+							DecodeBase64Url(Modulus, Key.Modulus) &&
+							DecodeBase64Url(Exponent, Key.Exponent))
+						{
+							Keys.Add(KeyId, MoveTemp(Key));
+						}
+					}
+
+					// the keys are rotated, the endpoint tells for how long
+					// the current ones may be cached
+					int64 Lifetime = kDefaultJwksLifetimeSeconds;
+					FString CacheControl =
+						Response->GetHeader(kCacheControlHeader);
+					int32 MaxAgeIndex =
+						CacheControl.Find(kCacheControlMaxAgeDirective);
+					if (MaxAgeIndex != INDEX_NONE)
+					{
+						Lifetime = FCString::Atoi64(*CacheControl +
+							MaxAgeIndex +
+							FCString::Strlen(kCacheControlMaxAgeDirective));
+					}
+
+					UE_LOG(LogGoogleDesktopOAuth, Log,
+						TEXT("%d public keys have been retrieved"),
+						Keys.Num());
+
+					{
+						FScopeLock Lock(&CriticalSection);
+
+						JsonWebKeys = MoveTemp(Keys);
+						JsonWebKeysExpiresOn =
+							FDateTime::Now().ToUnixTimestamp() + Lifetime;
+					}
+
+					NotifyAll(Status::kSuccessCode);
+				},
+				[NotifyAll](Status Code)
+				{
+					UE_LOG(LogGoogleDesktopOAuth, Log,
+						TEXT("Unable to retrieve the public keys"));
+
+					NotifyAll(Code);
+				}
+			);
+		}
+	);
+}
+
+void FGoogleDesktopOAuth::LoadCachedTokens(
+	ManualAuthenticationCallbackType Callback, FString ClientId,
+	FString Scopes)
+{
+	// the file is tiny, but the disk may be slow or busy at startup
+	Async(EAsyncExecution::ThreadPool,
+		[this, Callback = MoveTemp(Callback), ClientId = MoveTemp(ClientId),
+			Scopes = MoveTemp(Scopes)]() mutable
+		{
+			FGoogleTokenStore::FTokens Tokens;
+			bool bIsLoaded = FGoogleTokenStore::Load(ClientId, Scopes, Tokens);
+
+			AsyncTask(ENamedThreads::GameThread,
+				[this, Callback = MoveTemp(Callback),
+					Tokens = MoveTemp(Tokens), bIsLoaded]() mutable
+				{
+					if (!bIsLoaded)
+					{
+						UE_LOG(LogGoogleDesktopOAuth, Log,
+							TEXT("There are no cached tokens"));
+
+						Callback("", 0, "", Status::kNoCachedTokensCode);
+						return;
+					}
+
+					UE_LOG(LogGoogleDesktopOAuth, Log,
+						TEXT("The cached tokens have been loaded"));
+
+					RememberAccessToken(Tokens.AccessToken,
+						Tokens.ExpiresOn);
+					Callback(MoveTemp(Tokens.AccessToken), Tokens.ExpiresOn,
+						MoveTemp(Tokens.RefreshToken), Status::kSuccessCode);
+				});
+		});
+}
+
+void FGoogleDesktopOAuth::StoreCachedTokens(FString ClientId, FString Scopes,
+	FString AccessToken, int64 ExpiresOn, FString RefreshToken) const
+{
+	FGoogleTokenStore::FTokens Tokens;
+	Tokens.AccessToken = MoveTemp(AccessToken);
+	Tokens.ExpiresOn = ExpiresOn;
+	Tokens.RefreshToken = MoveTemp(RefreshToken);
+
+	Async(EAsyncExecution::ThreadPool,
+		[ClientId = MoveTemp(ClientId), Scopes = MoveTemp(Scopes),
+			Tokens = MoveTemp(Tokens)]()
+		{
+			FGoogleTokenStore::Save(ClientId, Scopes, Tokens);
+		});
+}
+
+void FGoogleDesktopOAuth::ClearCachedTokens(const FString& ClientId,
+	const FString& Scopes) const
+{
+	FGoogleTokenStore::Delete(ClientId, Scopes);
+}
+
+FGoogleDesktopOAuth::FAccountHandle FGoogleDesktopOAuth::AddAccount(
+	FString ClientId, FString ClientSecret, FString RefreshToken)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	// there are usually few apps and many accounts, so the apps are looked
+	// up linearly
+	int32 ClientIndex = INDEX_NONE;
+	for (auto It = Clients.CreateIterator(); It; ++It)
+	{
+		if (It->ClientId == ClientId && It->ClientSecret == ClientSecret)
+		{
+			ClientIndex = It.GetIndex();
+			break;
+		}
+	}
+
+	if (ClientIndex == INDEX_NONE)
+	{
+		FClient Client;
+		Client.ClientId = MoveTemp(ClientId);
+		Client.ClientSecret = MoveTemp(ClientSecret);
+		ClientIndex = Clients.Add(MoveTemp(Client));
+	}
+	Clients[ClientIndex].NumberOfAccounts++;
+
+	FAccount Account;
+	Account.Serial = NextAccountSerial++;
+	Account.ClientIndex = ClientIndex;
+	Account.RefreshToken = MoveTemp(RefreshToken);
+
+	FAccountHandle Handle;
+	Handle.Serial = Account.Serial;
+	Handle.Index = Accounts.Add(MoveTemp(Account));
+
+	return Handle;
+}
+
+void FGoogleDesktopOAuth::RemoveAccount(FAccountHandle Account)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FAccount* AccountState = FindAccount(Account);
+	if (!AccountState)
+	{
+		return;
+	}
+
+	FClient& Client = Clients[AccountState->ClientIndex];
+	if (--Client.NumberOfAccounts == 0)
+	{
+		Clients.RemoveAt(AccountState->ClientIndex);
+	}
+
+	Accounts.RemoveAt(Account.Index);
+}
+
+void FGoogleDesktopOAuth::GetAccountToken(RefreshCallbackType Callback,
+	FAccountHandle Account)
+{
+	FString Token;
+	int64 ExpiresOn = 0;
+	FString ClientId;
+	FString ClientSecret;
+	FString RefreshToken;
+	TArray<RefreshCallbackType> FailedCallbacks;
+	bool bIsRegistered = true;
+	bool bIsFresh = false;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		FAccount* AccountState = FindAccount(Account);
+		if (!AccountState)
+		{
+			bIsRegistered = false;
+		}
+		else if (AccountState->ExpiresOn - kAccountTokenRefreshMarginSeconds >
+			FDateTime::Now().ToUnixTimestamp())
+		{
+			Token = AccountState->AccessToken;
+			ExpiresOn = AccountState->ExpiresOn;
+			bIsFresh = true;
+		}
+		else
+		{
+			AccountState->PendingCallbacks.Add(MoveTemp(Callback));
+			if (AccountState->bIsRefreshInFlight)
+			{
+				return;
+			}
+
+			if (AccountState->RefreshToken.IsEmpty())
+			{
+				// nothing to refresh with, so everyone waiting fails now
+				// instead of waiting for a refresh which never starts
+				FailedCallbacks = MoveTemp(AccountState->PendingCallbacks);
+			}
+			else
+			{
+				AccountState->bIsRefreshInFlight = true;
+
+				const FClient& Client = Clients[AccountState->ClientIndex];
+				ClientId = Client.ClientId;
+				ClientSecret = Client.ClientSecret;
+				RefreshToken = AccountState->RefreshToken;
+			}
+		}
+	}
+
+	// callbacks are called without the lock, they may call back into this
+	if (!bIsRegistered)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The account %d is not registered"), Account.Index);
+
+		Callback("", 0, Status::kUnknownErrorCode);
+	}
+	else if (bIsFresh)
+	{
+		Callback(MoveTemp(Token), ExpiresOn, Status::kSuccessCode);
+	}
+	else if (!RefreshToken.IsEmpty())
+	{
+		RefreshAuthToken(
+			[this, Account](FString Token, int64 ExpiresOn, Status Code)
+			{
+				HandleAccountRefreshResult(Account, MoveTemp(Token), ExpiresOn,
+					Code);
+			}, MoveTemp(ClientId), MoveTemp(ClientSecret),
+			MoveTemp(RefreshToken));
+	}
+	else
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The account %d has no refresh token"), Account.Index);
+
+		for (RefreshCallbackType& FailedCallback : FailedCallbacks)
+		{
+			FailedCallback("", 0, Status::kInvalidGrantErrorCode);
+		}
+	}
+}
+
+void FGoogleDesktopOAuth::HandleAccountRefreshResult(FAccountHandle Account,
+	FString Token, int64 ExpiresOn, Status Code)
+{
+	TArray<RefreshCallbackType> Callbacks;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		// the account might have been removed while the refresh was in flight
+		FAccount* AccountState = FindAccount(Account);
+		if (!AccountState)
+		{
+			return;
+		}
+
+		if (Code == Status::kSuccessCode)
+		{
+			AccountState->AccessToken = Token;
+			AccountState->ExpiresOn = ExpiresOn;
+		}
+
+		AccountState->bIsRefreshInFlight = false;
+		Callbacks = MoveTemp(AccountState->PendingCallbacks);
+	}
+
+	for (RefreshCallbackType& Callback : Callbacks)
+	{
+		Callback(Token, ExpiresOn, Code);
+	}
+}
+
+int32 FGoogleDesktopOAuth::GetNumberOfAccounts() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	return Accounts.Num();
+}
+
+FGoogleDesktopOAuth::FAccount* FGoogleDesktopOAuth::FindAccount(
+	FAccountHandle Account)
+{
+	if (!Account.IsValid() || !Accounts.IsValidIndex(Account.Index) ||
+		Accounts[Account.Index].Serial != Account.Serial)
+	{
+		return nullptr;
+	}
+
+	return &Accounts[Account.Index];
 }
\ No newline at end of file
@@ -5,12 +5,20 @@
 #include "CoreMinimal.h"
 #include "HttpModule.h"
 #include "IHttpRouter.h"
+#include "GoogleLoopbackListener.h"
+#include "GoogleOAuthHttpSession.h"
+
+class FUtf8JsonFieldReader;
 
 /**
 * A service which allows to interact with different parts of Google OAuth
 * subsystem using Desktop OAuth Workflow
 * 
-* Isn't thread-safe
+* Is thread-safe, except `AuthenticateManually()` which must be called on the
+* game thread as it launches the browser and manages the HTTP server routes.
+* Callbacks are called on the game thread unless stated otherwise. Many
+* accounts may be served concurrently through one instance, see
+* `AddAccount()`
 * 
 * Uses `LogGoogleDesktopOAuth` log category
 */
@@ -44,9 +52,46 @@ public:
 		* Is used if the refresh request could not be completed due to invalid
 		* refresh token
 		* 
-		* Used only with @see RefreshAuthToken
+		* Used only with @see RefreshAuthToken and @see GetAccountToken
+		*/
+		kInvalidGrantErrorCode = 5,
+
+		/**
+		* Is used if a token was found invalid without asking Google: it has
+		* expired, its signature doesn't match or its claims are wrong
+		* 
+		* Used only with @see CheckAccessToken and @see CheckIdToken
+		*/
+		kInvalidTokenCode = 6,
+
+		/**
+		* Is used if there are no cached tokens for the client ID and scope
+		* set or they couldn't be read
+		* 
+		* Used only with @see LoadCachedTokens
 		*/
-		kInvalidGrantErrorCode = 5
+		kNoCachedTokensCode = 7,
+
+		/**
+		* Is used if the user didn't finish the authentication in the browser
+		* in time
+		* 
+		* Used only with @see AuthenticateManually
+		*/
+		kTimeoutCode = 8
+	};
+
+	/**
+	* How `CheckAccessToken()` decides whether a token is valid
+	*/
+	enum class TokenValidationMode
+	{
+		//Always ask the userinfo endpoint
+		Remote,
+
+		//Answer from the expiration of the token remembered when it was
+		//issued, ask the userinfo endpoint only if the token is unknown
+		LocalFirst
 	};
 
 	/**
@@ -57,6 +102,59 @@ public:
 		LoopbackIp
 	};
 
+	/**
+	* Handle of an account registered through `AddAccount()`
+	*/
+	struct FAccountHandle
+	{
+		//Index of the account in the table of accounts
+		int32 Index = INDEX_NONE;
+
+		//Tells apart accounts which occupied the same index at different
+		//times
+		uint32 Serial = 0;
+
+		bool IsValid() const
+		{
+			return Index != INDEX_NONE;
+		}
+	};
+
+	/**
+	* URLs of the Google OAuth endpoints the requests are sent to
+	* 
+	* Default to the real Google endpoints. Are replaced to talk to a local
+	* stand-in, e.g. @see FGoogleOAuthMockServer
+	*/
+	struct FEndpoints
+	{
+		//Token endpoint refresh requests are sent to
+		FString RefreshTokenUrl = kGoogleRefreshTokenUrl;
+
+		//Token endpoint authorization codes are exchanged at
+		FString CodeExchangeUrl = kCodeExchangeUrlBase;
+
+		//Userinfo endpoint, the access token is appended to it
+		FString UserInfoUrlBase = kUserInfoUrlBase;
+
+		//Endpoint Google's public keys for ID tokens are retrieved from
+		FString JwksUrl = kJwksUrl;
+
+		//Consent page the browser is sent to, the query is appended to it
+		FString ManualAuthenticationUrlBase = kManualAuthenticationUrlBase;
+	};
+
+	FGoogleDesktopOAuth() = default;
+
+	/**
+	* @param Endpoints URLs the requests are sent to instead of the Google
+	* ones
+	*/
+	explicit FGoogleDesktopOAuth(FEndpoints Endpoints);
+
+	//How transient failures of the requests are retried
+	using FRetryPolicy = FGoogleOAuthHttpSession::FRetryPolicy;
+
 	//Type of callback function used when refreshing a token
 	using RefreshCallbackType = TFunction<void(FString Token,
 		int64 ExpiresOn, Status Code)>;
@@ -67,6 +165,34 @@ public:
 
 	using AccessTokenCheckCallbackType = TFunction<void(Status Code)>;
 
+	/**
+	* Aggregated result of `CheckAccessTokens()`
+	*/
+	struct FAccessTokenBatchCheckResult
+	{
+		//Results of the checks by the indices of the checked tokens
+		TArray<Status> Codes;
+
+		int32 NumberOfValidTokens = 0;
+
+		//How many tokens were checked without a request
+		int32 NumberOfLocalChecks = 0;
+
+		bool AreAllValid() const
+		{
+			return NumberOfValidTokens == Codes.Num();
+		}
+	};
+
+	//Type of callback function used when checking several access tokens
+	using AccessTokenBatchCheckCallbackType =
+		TFunction<void(const FAccessTokenBatchCheckResult& Result)>;
+
+	//How many requests `CheckAccessTokens()` keeps in flight by default,
+	//more would only wait in the queue of the HTTP session
+	static constexpr int32 kDefaultBatchCheckFanOut =
+		FGoogleOAuthHttpSession::kDefaultMaxConnections;
+
 	/**
 	* Refreshes OAuth token issued for an user authenticating into a Google App
 	* 
@@ -97,16 +223,218 @@ public:
 	void RefreshAuthToken(RefreshCallbackType Callback, FString ClientId,
 		FString ClientSecret, FString RefreshToken);
 
+	/**
+	* Replaces the policy transient failures of all the requests are retried
+	* with. Connection errors, `5xx` and `429` responses are retried by
+	* default, `Status::kConnectionErrorCode` and `Status::kUnknownErrorCode`
+	* are reported for them only when the retries are exhausted.
+	* `invalid_grant` is never retried
+	* 
+	* @param Policy The policy, `MaxRetries` of `0` disables the retries
+	* @see FRetryPolicy
+	*/
+	void SetRetryPolicy(const FRetryPolicy& Policy);
+
+	/**
+	* Registers an account whose access tokens are refreshed through this
+	* instance
+	* 
+	* Accounts of the same Google App share the client ID and secret, so
+	* those are stored once per app
+	* 
+	* @param ClientId Client ID of the Google App authentication happens for
+	* @param ClientSecret Client secret of the Google App authentication
+	* happens for
+	* @param RefreshToken Refresh token which is owned by the account
+	* @return Handle of the account
+	*/
+	FAccountHandle AddAccount(FString ClientId, FString ClientSecret,
+		FString RefreshToken);
+
+	/**
+	* Unregisters an account. Callbacks waiting for an in-flight refresh of
+	* the account aren't called
+	* 
+	* @param Account Handle of the account
+	*/
+	void RemoveAccount(FAccountHandle Account);
+
+	/**
+	* Returns a valid access token of an account
+	* 
+	* The token is cached per account. If the cached token is valid for at
+	* least `kAccountTokenRefreshMarginSeconds` more the callback is called
+	* immediately on the calling thread, otherwise it's called when the
+	* refresh completes. Concurrent requests for a token of one account are
+	* coalesced into one refresh request, requests for different accounts
+	* don't wait for each other.
+	* 
+	* Callback is called with the same codes as `RefreshAuthToken()` reports,
+	* with `Status::kInvalidGrantErrorCode` if the token has to be refreshed
+	* but the account has no refresh token or with
+	* `Status::kUnknownErrorCode` if the account isn't registered
+	* 
+	* @param Callback Callback to be called with the token
+	* @param Account Handle of the account
+	*/
+	void GetAccountToken(RefreshCallbackType Callback, FAccountHandle Account);
+
+	/**
+	* Returns count of the registered accounts
+	* 
+	* @return Count of the registered accounts
+	*/
+	int32 GetNumberOfAccounts() const;
+
+	/**
+	* Authenticates the user through the browser
+	* 
+	* The consent page redirects the browser to a loopback listener which is
+	* started once and reused by the following calls, see
+	* `FGoogleLoopbackListener`. The browser is opened only once the probe
+	* request has reached the listener's route, if it can't the callback is
+	* called with `Status::kUnknownErrorCode` and the browser isn't opened.
+	* If the user doesn't finish the authentication within
+	* `kManualAuthenticationTimeoutSeconds` the callback is called with
+	* `Status::kTimeoutCode`
+	* 
+	* Must be called on the game thread
+	* 
+	* @param Callback Callback to be called with the issued tokens
+	* @param Method Authentication method
+	* @param Scopes Space-separated scopes to request
+	* @param ClientId Client ID of the Google App authentication happens for
+	* @param ClientSecret Client secret of the Google App authentication
+	* happens for
+	* @param LoopbackPort Port the listener listens on, `0` picks a free one
+	*/
 	void AuthenticateManually(ManualAuthenticationCallbackType Callback,
 		AuthenticationMethod Method, FString Scopes, FString ClientId,
-		FString ClientSecret, int64 LoopbackPort);
+		FString ClientSecret, int64 LoopbackPort = 0);
 	
+	/**
+	* Checks whether an access token is valid
+	* 
+	* In `TokenValidationMode::Remote` mode a request to the userinfo
+	* endpoint is sent every time. In `TokenValidationMode::LocalFirst` mode
+	* tokens issued through this instance (or passed to
+	* `RememberAccessToken()`) are checked against their expiration time
+	* without any request: `Status::kSuccessCode` is reported if the token
+	* is valid for at least `kTokenExpirationSkewSeconds` more and
+	* `Status::kInvalidTokenCode` if it's not. Unknown tokens are checked
+	* remotely.
+	* A locally valid token may still have been revoked, use
+	* `TokenValidationMode::Remote` where it matters
+	* 
+	* @param Callback Callback to be called with the result of the check
+	* @param AccessToken The token to check
+	* @param Mode How the token is checked
+	*/
 	void CheckAccessToken(AccessTokenCheckCallbackType Callback,
-		FString AccessToken);
+		FString AccessToken,
+		TokenValidationMode Mode = TokenValidationMode::Remote);
+
+	/**
+	* Checks many access tokens at once
+	* 
+	* In `TokenValidationMode::LocalFirst` mode the tokens whose expiration
+	* is known are answered from it without any request, as
+	* `CheckAccessToken()` does. The rest are checked against the userinfo
+	* endpoint with at most `MaxRequestsInFlight` requests in flight. The
+	* callback is called once, when all the tokens have been checked; it's
+	* called on the calling thread if no request was needed
+	* 
+	* @param Callback Callback to be called with the results of the checks
+	* @param AccessTokens The tokens to check
+	* @param Mode How the tokens are checked
+	* @param MaxRequestsInFlight How many tokens are checked remotely at once
+	*/
+	void CheckAccessTokens(AccessTokenBatchCheckCallbackType Callback,
+		TArray<FString> AccessTokens,
+		TokenValidationMode Mode = TokenValidationMode::LocalFirst,
+		int32 MaxRequestsInFlight = kDefaultBatchCheckFanOut);
+
+	/**
+	* Remembers the expiration of an access token obtained elsewhere so that
+	* `CheckAccessToken()` is able to check it locally
+	* 
+	* @param AccessToken The token
+	* @param ExpiresOn Unix timestamp the token expires on
+	*/
+	void RememberAccessToken(const FString& AccessToken, int64 ExpiresOn);
+
+	/**
+	* Checks whether an OpenID Connect ID token issued by Google is valid
+	* 
+	* The RS256 signature of the token is verified against Google's public
+	* keys, which are cached for as long as the key endpoint allows. Then
+	* `exp`, `aud` and `iss` claims are checked. The keys are requested only
+	* if they aren't cached yet, have expired or don't contain the key the
+	* token was signed with.
+	* 
+	* Callback is called with one of the following values:
+	* - `Status::kSuccessCode` - if the token is valid
+	* - `Status::kInvalidTokenCode` - if the token is malformed, expired,
+	* issued for another client or its signature doesn't match
+	* - any code `RefreshAuthToken()` may report - if the keys couldn't be
+	* retrieved
+	* 
+	* @param Callback Callback to be called with the result of the check
+	* @param IdToken The token to check
+	* @param ClientId Client ID of the Google App the token must be issued
+	* for
+	*/
+	void CheckIdToken(AccessTokenCheckCallbackType Callback, FString IdToken,
+		FString ClientId);
+
+	/**
+	* Loads tokens cached on disk by `StoreCachedTokens()` without blocking
+	* the calling thread
+	* 
+	* The file is read and decrypted on a worker thread, the callback is
+	* called on the game thread. On success the access token is remembered
+	* for `TokenValidationMode::LocalFirst` checks. Note that the access token
+	* may have already expired, check `ExpiresOn` and refresh it through
+	* `RefreshAuthToken()` using the loaded refresh token if so.
+	* 
+	* Callback is called with `Status::kSuccessCode` if the tokens were
+	* loaded or with `Status::kNoCachedTokensCode` otherwise
+	* 
+	* @param Callback Callback to be called with the cached tokens
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Scopes the tokens are issued for, the same as passed to
+	* `AuthenticateManually()`
+	* @see FGoogleTokenStore
+	*/
+	void LoadCachedTokens(ManualAuthenticationCallbackType Callback,
+		FString ClientId, FString Scopes);
+
+	/**
+	* Encrypts and caches tokens on disk on a worker thread
+	* 
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Scopes the tokens are issued for
+	* @param AccessToken Access token to cache
+	* @param ExpiresOn Unix timestamp the access token expires on
+	* @param RefreshToken Refresh token to cache
+	* @see FGoogleTokenStore
+	*/
+	void StoreCachedTokens(FString ClientId, FString Scopes,
+		FString AccessToken, int64 ExpiresOn, FString RefreshToken) const;
+
+	/**
+	* Deletes the tokens cached on disk, e.g. after the refresh token has
+	* been revoked
+	* 
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Scopes the tokens are issued for
+	*/
+	void ClearCachedTokens(const FString& ClientId,
+		const FString& Scopes) const;
 
 private:
 	using SuccessfulRequestCallbackType =
-		TFunction<void(TSharedPtr<FJsonObject> Data, Status Code)>;
+		TFunction<void(const FUtf8JsonFieldReader& Data, Status Code)>;
 
 	using FailedRequestCallbackType = TFunction<void(Status Code)>;
 
@@ -133,6 +461,11 @@ private:
 		FString ClientID, FString ClientSecret, FString GrantType,
 		FString RefreshToken) const;
 
+	// registers an attempt on the confirmed loopback route and opens the
+	// consent page in the browser
+	void LaunchConsentPage(ManualAuthenticationCallbackType Callback,
+		FString Scopes, FString ClientId, FString ClientSecret, uint32 Port);
+
 	// more on loopback auth
 	// https://developers.google.com/identity/protocols/oauth2/native-app
 	void HandleTheResultOfLoopbackAuthentication(
@@ -149,110 +482,299 @@ private:
 	void Answer(const FHttpResultCallback& OnComplete, FString Title,
 		FString Message) const;
 
+	//Result of a check which is done without asking Google
+	enum class LocalVerdict
+	{
+		Valid,
+		Invalid,
+		//Nothing is known locally, Google has to be asked
+		Uncertain
+	};
+
+	//Public RSA key Google signs ID tokens with
+	struct FJsonWebKey
+	{
+		TArray<uint8> Modulus;
+
+		TArray<uint8> Exponent;
+	};
+
+	LocalVerdict CheckAccessTokenLocally(const FString& AccessToken) const;
+
+	//State of one `CheckAccessTokens()` call
+	struct FBatchCheck;
+
+	//Checks the next token of the batch which has to be checked remotely
+	void ContinueBatchCheck(TSharedRef<FBatchCheck, ESPMode::ThreadSafe> Batch);
+
+	void FinishBatchCheck(FBatchCheck& Batch) const;
+
+	LocalVerdict CheckIdTokenLocally(const FString& IdToken,
+		const FString& ClientId) const;
+
+	//Client ID and secret of a Google App, shared by its accounts
+	struct FClient
+	{
+		FString ClientId;
+
+		FString ClientSecret;
+
+		int32 NumberOfAccounts = 0;
+	};
+
+	//Per-account state, see `AddAccount()`
+	struct FAccount
+	{
+		uint32 Serial = 0;
+
+		//Index of the Google App in `Clients`
+		int32 ClientIndex = INDEX_NONE;
+
+		FString RefreshToken;
+
+		FString AccessToken;
+
+		//Unix timestamp `AccessToken` expires on, `0` if there is no token
+		int64 ExpiresOn = 0;
+
+		bool bIsRefreshInFlight = false;
+
+		//Callbacks waiting for the in-flight refresh
+		TArray<RefreshCallbackType> PendingCallbacks;
+	};
+
+	//Must be called with `CriticalSection` locked
+	FAccount* FindAccount(FAccountHandle Account);
+
+	void HandleAccountRefreshResult(FAccountHandle Account, FString Token,
+		int64 ExpiresOn, Status Code);
+
+	/**
+	* Requests Google's public keys and replaces the cached ones. Requests
+	* made while another one is in flight are coalesced
+	* 
+	* @param Callback Callback to be called when the keys are retrieved or
+	* the request fails
+	*/
+	void FetchJsonWebKeys(AccessTokenCheckCallbackType Callback);
+
 	//Token refresh section
 
 	//Base part of URL token refresh is accessible through
-	const FString kGoogleRefreshTokenUrl =
-		"https://oauth2.googleapis.com/token";
+	static constexpr const TCHAR* kGoogleRefreshTokenUrl =
+		TEXT("https://oauth2.googleapis.com/token");
 
-	const FString kGoogleRefreshTokenClientIdField = "client_id";
+	static constexpr const TCHAR* kGoogleRefreshTokenClientIdField =
+		TEXT("client_id");
 
-	const FString kGoogleRefreshTokenClientSecretField = "client_secret";
+	static constexpr const TCHAR* kGoogleRefreshTokenClientSecretField =
+		TEXT("client_secret");
 
-	const FString kGoogleRefreshTokenRefreshTokenField = "refresh_token";
+	static constexpr const TCHAR* kGoogleRefreshTokenRefreshTokenField =
+		TEXT("refresh_token");
 
-	const FString kGoogleRefreshTokenGrantTypeField = "grant_type";
+	static constexpr const TCHAR* kGoogleRefreshTokenGrantTypeField =
+		TEXT("grant_type");
 
-	const FString kGoogleRefreshTokenGrantTypeValue = "refresh_token";
+	static constexpr const TCHAR* kGoogleRefreshTokenGrantTypeValue =
+		TEXT("refresh_token");
 
 	//JSON field which contains refreshed access token. Applicable to successful
 	//responses from token refresh endpoint only.
-	const FString kGoogleRefreshTokenResponseAccessTokenField = "access_token";
+	static constexpr const TCHAR* kGoogleRefreshTokenResponseAccessTokenField =
+		TEXT("access_token");
 
 	//JSON field which contains "expires in" value. Applicable to successful
 	//responses from token refresh endpoint only.
-	const FString kGoogleRefreshTokenResponseExpiresInField = "expires_in";
+	static constexpr const TCHAR* kGoogleRefreshTokenResponseExpiresInField =
+		TEXT("expires_in");
 
 	//Manual authentication section
 
-	const FString kManualAuthenticationUrlBase =
-		"https://accounts.google.com/o/oauth2/v2/auth?";
+	static constexpr const TCHAR* kManualAuthenticationUrlBase =
+		TEXT("https://accounts.google.com/o/oauth2/v2/auth?");
 
-	const FString kManualAuthenticationScopeField = "scope";
+	static constexpr const TCHAR* kManualAuthenticationScopeField =
+		TEXT("scope");
 
-	const FString kManualAuthenticationResponseTypeField = "response_type";
+	static constexpr const TCHAR* kManualAuthenticationResponseTypeField =
+		TEXT("response_type");
 
-	const FString kManualAuthenticationResponseTypeValue = "code";
+	static constexpr const TCHAR* kManualAuthenticationResponseTypeValue =
+		TEXT("code");
 
-	const FString kManualAuthenticationRedirectUriField = "redirect_uri";
+	static constexpr const TCHAR* kManualAuthenticationRedirectUriField =
+		TEXT("redirect_uri");
 
-	const FString kManualAuthenticationClientIdField = "client_id";
+	static constexpr const TCHAR* kManualAuthenticationClientIdField =
+		TEXT("client_id");
 
-	const FString kLoopbackAddressBase = "http://127.0.0.1:";
+	static constexpr const TCHAR* kLoopbackAddressBase =
+		TEXT("http://127.0.0.1:");
 
-	const FString kLoopbackAddressPath = "/google_oauth";
+	static constexpr const TCHAR* kLoopbackAddressPath = TEXT("/google_oauth");
 
-	const FString kManualAuthenticationResponseCodeField = "code";
+	static constexpr const TCHAR* kManualAuthenticationResponseCodeField =
+		TEXT("code");
 
-	const FString kManualAuthenticationResponseErrorField = "error";
+	static constexpr const TCHAR* kManualAuthenticationResponseErrorField =
+		TEXT("error");
 
 	//Code exchange section
 
-	const FString kCodeExchangeUrlBase = "https://oauth2.googleapis.com/token";
+	static constexpr const TCHAR* kCodeExchangeUrlBase =
+		TEXT("https://oauth2.googleapis.com/token");
 
-	const FString kCodeExchangeCodeField = "code";
+	static constexpr const TCHAR* kCodeExchangeCodeField = TEXT("code");
 
-	const FString kCodeExchangeClientIdField = "client_id";
+	static constexpr const TCHAR* kCodeExchangeClientIdField =
+		TEXT("client_id");
 
-	const FString kCodeExchangeClientSecretField = "client_secret";
+	static constexpr const TCHAR* kCodeExchangeClientSecretField =
+		TEXT("client_secret");
 
-	const FString kCodeExchangeRedirectUriField = "redirect_uri";
+	static constexpr const TCHAR* kCodeExchangeRedirectUriField =
+		TEXT("redirect_uri");
 
-	const FString kCodeExchangeGrantTypeField = "grant_type";
+	static constexpr const TCHAR* kCodeExchangeGrantTypeField =
+		TEXT("grant_type");
 
-	const FString kCodeExchangeGrantTypeValue = "authorization_code";
+	static constexpr const TCHAR* kCodeExchangeGrantTypeValue =
+		TEXT("authorization_code");
 
-	const FString kCodeExchangeResponseAccessTokenField = "access_token";
+	static constexpr const TCHAR* kCodeExchangeResponseAccessTokenField =
+		TEXT("access_token");
 
-	const FString kCodeExchangeResponseExpiresInField = "expires_in";
+	static constexpr const TCHAR* kCodeExchangeResponseExpiresInField =
+		TEXT("expires_in");
 
-	const FString kCodeExchangeResponseRefreshTokenField = "refresh_token";
+	static constexpr const TCHAR* kCodeExchangeResponseRefreshTokenField =
+		TEXT("refresh_token");
 
 	//Miscellaneous section
 
-	const FString kInvalidGrantErrorCode = "invalid_grant";
+	static constexpr const TCHAR* kInvalidGrantErrorCode =
+		TEXT("invalid_grant");
 
 	//`Content-Type` for JSON
-	const FString kJsonContentType = "application/json";
+	static constexpr const TCHAR* kJsonContentType = TEXT("application/json");
 
 	//`Content-Type` for HTML
-	const FString kHtmlContentType = "text/html";
+	static constexpr const TCHAR* kHtmlContentType = TEXT("text/html");
 
 	//`Content-Type` for url encoded data
-	const FString kUrlencodedContentType = "application/x-www-form-urlencoded";
+	static constexpr const TCHAR* kUrlencodedContentType =
+		TEXT("application/x-www-form-urlencoded");
 
 	//Name of `Content-Type` HTTP header
-	const FString kContentTypeHeader = "Content-Type";
+	static constexpr const TCHAR* kContentTypeHeader = TEXT("Content-Type");
 
 	//HTTP POST method name
-	const FString kPostMethod = "POST";
+	static constexpr const TCHAR* kPostMethod = TEXT("POST");
 
 	//HTTP GET method name
-	const FString kGetMethod = "GET";
+	static constexpr const TCHAR* kGetMethod = TEXT("GET");
 	
 	//JSON field which contains a string with error code
-	const FString kGoogleRefreshTokenResponseErrorCodeField = "error";
+	static constexpr const TCHAR* kGoogleRefreshTokenResponseErrorCodeField =
+		TEXT("error");
 
 	//JSON field which contains a string with error description
-	const FString kGoogleRefreshTokenResponseErrorField = "error_description";
+	static constexpr const TCHAR* kGoogleRefreshTokenResponseErrorField =
+		TEXT("error_description");
+
+	static constexpr const TCHAR* kUserInfoUrlBase =
+		TEXT("https://openidconnect.googleapis.com/v1/userinfo?access_token=");
+
+	//Local token validation section
+
+	//Endpoint Google's public keys for ID tokens are retrieved from
+	static constexpr const TCHAR* kJwksUrl =
+		TEXT("https://www.googleapis.com/oauth2/v3/certs");
+
+	static constexpr const TCHAR* kJwksKeysField = TEXT("keys");
+
+	static constexpr const TCHAR* kJwksKeyIdField = TEXT("kid");
+
+	static constexpr const TCHAR* kJwksModulusField = TEXT("n");
+
+	static constexpr const TCHAR* kJwksExponentField = TEXT("e");
+
+	static constexpr const TCHAR* kIdTokenAlgorithmField = TEXT("alg");
+
+	static constexpr const TCHAR* kIdTokenAlgorithmValue = TEXT("RS256");
+
+	static constexpr const TCHAR* kIdTokenExpirationField = TEXT("exp");
+
+	static constexpr const TCHAR* kIdTokenAudienceField = TEXT("aud");
+
+	static constexpr const TCHAR* kIdTokenIssuerField = TEXT("iss");
+
+	//Google issues ID tokens with either of these `iss` values
+	static constexpr const TCHAR* kIdTokenIssuer =
+		TEXT("https://accounts.google.com");
+
+	static constexpr const TCHAR* kIdTokenIssuerWithoutScheme =
+		TEXT("accounts.google.com");
+
+	//Name of `Cache-Control` HTTP header
+	static constexpr const TCHAR* kCacheControlHeader = TEXT("Cache-Control");
+
+	static constexpr const TCHAR* kCacheControlMaxAgeDirective =
+		TEXT("max-age=");
+
+	//Tokens which expire sooner than this are considered expired, so that
+	//a token which is fine now doesn't expire on its way to a Google API
+	static constexpr int64 kTokenExpirationSkewSeconds = 30;
+
+	//How long keys are cached if the key endpoint says nothing about it
+	static constexpr int64 kDefaultJwksLifetimeSeconds = 3600;
+
+	//How many access tokens are remembered for the local validation
+	static constexpr int32 kMaxRememberedAccessTokens = 256;
+
+	//How long the user has to finish the authentication in the browser
+	static constexpr float kManualAuthenticationTimeoutSeconds = 300.0f;
+
+	//How long before the expiration an account's token is refreshed
+	static constexpr int64 kAccountTokenRefreshMarginSeconds = 60;
+
+	//URLs the requests are sent to, don't change after construction
+	FEndpoints Endpoints;
+
+	//Session all the requests go through, is thread-safe on its own
+	mutable FGoogleOAuthHttpSession HttpSession;
+
+	//Guards all the mutable state below
+	mutable FCriticalSection CriticalSection;
+
+	//Google Apps of the registered accounts
+	TSparseArray<FClient> Clients;
+
+	//Registered accounts, are indexed by `FAccountHandle::Index`
+	TSparseArray<FAccount> Accounts;
+
+	//Serial the next registered account gets
+	uint32 NextAccountSerial = 1;
+
+	//Expirations of the access tokens issued through this instance or
+	//passed to `RememberAccessToken()`
+	TMap<FString, int64> AccessTokenExpirations;
+
+	//Cached Google's public keys by their IDs
+	TMap<FString, FJsonWebKey> JsonWebKeys;
+
+	//Unix timestamp `JsonWebKeys` expire on
+	int64 JsonWebKeysExpiresOn = 0;
 
-	const FString kUserInfoUrlBase =
-		"https://openidconnect.googleapis.com/v1/userinfo?access_token=";
+	//Callbacks waiting for the in-flight keys request, the request is in
+	//flight if the array isn't empty
+	TArray<AccessTokenCheckCallbackType> JsonWebKeysCallbacks;
 	
 	/**
-	* Keeps the last set by `AuthenticateManually()` UE4's HTTP Server router
-	* handle for the address Google OAuth endpoint is going to refer to when
-	* executing Google OAuth desktop loopback IP flow
+	* Listener Google OAuth endpoint redirects the browser to when executing
+	* Google OAuth desktop loopback IP flow, is shared by all the calls of
+	* `AuthenticateManually()`
 	*/
-	FHttpRouteHandle RouterHandle;
+	FGoogleLoopbackListener LoopbackListener{ kLoopbackAddressPath };
 };
\ No newline at end of file
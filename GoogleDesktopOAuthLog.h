@@ -0,0 +1,9 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Log category shared by `FGoogleDesktopOAuth` and its helpers, is defined
+//in GoogleDesktopOAuth.cpp
+DECLARE_LOG_CATEGORY_EXTERN(LogGoogleDesktopOAuth, All, All)
@@ -0,0 +1,311 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Base64.h"
+#include "GoogleDesktopOAuth.h"
+#include "GoogleOAuthMockServer.h"
+
+namespace
+{
+	using Status = FGoogleDesktopOAuth::Status;
+
+	//Loopback port the mock server listens on, differs from the one of the
+	//benchmarks so that the specs may run in one session
+	constexpr uint32 kMockServerPort = 18464;
+
+	const TCHAR* const kClientId = TEXT("client-id");
+
+	const TCHAR* const kRefreshToken = TEXT("1//refresh-token");
+}
+
+BEGIN_DEFINE_SPEC(FGoogleDesktopOAuthSpec,
+	"GoogleOAuth.DesktopOAuth",
+	EAutomationTestFlags::ProductFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FGoogleOAuthMockServer> Server;
+
+TUniquePtr<FGoogleDesktopOAuth> OAuth;
+
+/**
+* Checks the ID token through the mock server and compares the result with
+* the expected one
+*/
+void CheckIdToken(const FString& What, const FString& IdToken,
+	Status ExpectedCode, const FDoneDelegate& Done)
+{
+	OAuth->CheckIdToken([this, What, ExpectedCode, Done](Status Code)
+		{
+			TestTrue(What, Code == ExpectedCode);
+
+			Done.Execute();
+		}, IdToken, kClientId);
+}
+
+/**
+* Refreshes `kRefreshToken` through the mock server and compares the result
+* and the number of requests the server has got with the expected ones
+*/
+void Refresh(const FString& What, Status ExpectedCode,
+	int32 ExpectedNumberOfRequests, const FDoneDelegate& Done)
+{
+	OAuth->RefreshAuthToken(
+		[this, What, ExpectedCode, ExpectedNumberOfRequests, Done](
+			FString Token, int64 ExpiresOn, Status Code)
+		{
+			TestTrue(What, Code == ExpectedCode);
+			TestEqual("Expecting the number of requests to match",
+				Server->GetNumberOfRequests(), ExpectedNumberOfRequests);
+
+			Done.Execute();
+		}, kClientId, TEXT("client-secret"), kRefreshToken);
+}
+
+END_DEFINE_SPEC(FGoogleDesktopOAuthSpec)
+
+void FGoogleDesktopOAuthSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Server = MakeUnique<FGoogleOAuthMockServer>(kMockServerPort);
+		TestTrue("Expecting the mock server to start", Server->Start());
+
+		OAuth = MakeUnique<FGoogleDesktopOAuth>(Server->GetEndpoints());
+	});
+
+	AfterEach([this]()
+	{
+		OAuth.Reset();
+		Server.Reset();
+	});
+
+	Describe("ID token", [this]()
+	{
+		LatentIt("Signed by the published key",
+			[this](const FDoneDelegate& Done)
+			{
+				FString IdToken = Server->IssueIdToken(kClientId);
+				TestFalse("Expecting the token to be signed",
+					IdToken.IsEmpty());
+
+				CheckIdToken("Expecting the token to be valid", IdToken,
+					Status::kSuccessCode, Done);
+			});
+
+		LatentIt("Checked again with the cached key",
+			[this](const FDoneDelegate& Done)
+			{
+				FString IdToken = Server->IssueIdToken(kClientId);
+				OAuth->CheckIdToken([this, IdToken, Done](Status Code)
+					{
+						int32 NumberOfRequests =
+							Server->GetNumberOfRequests();
+
+						// the key is cached, so the second check doesn't
+						// send anything
+						OAuth->CheckIdToken(
+							[this, NumberOfRequests, Done](Status Code)
+							{
+								TestTrue("Expecting the token to be valid",
+									Code == Status::kSuccessCode);
+								TestEqual("Expecting no request to be sent",
+									Server->GetNumberOfRequests(),
+									NumberOfRequests);
+
+								Done.Execute();
+							}, IdToken, kClientId);
+					}, IdToken, kClientId);
+			});
+
+		LatentIt("With a tampered payload",
+			[this](const FDoneDelegate& Done)
+			{
+				// the payload of a token for another client is put under
+				// the signature of a token for this one
+				TArray<FString> Segments;
+				Server->IssueIdToken(kClientId).ParseIntoArray(Segments,
+					TEXT("."));
+				TArray<FString> OtherSegments;
+				Server->IssueIdToken(TEXT("other-client-id")).ParseIntoArray(
+					OtherSegments, TEXT("."));
+
+				FString IdToken = Segments[0] + TEXT(".") +
+					OtherSegments[1] + TEXT(".") + Segments[2];
+				AddExpectedError(TEXT("signature of the ID token doesn't"
+					" match"), EAutomationExpectedErrorFlags::Contains, 1);
+				CheckIdToken("Expecting the signature not to match",
+					IdToken, Status::kInvalidTokenCode, Done);
+			});
+
+		LatentIt("Issued for another client",
+			[this](const FDoneDelegate& Done)
+			{
+				AddExpectedError(TEXT("The ID token is issued by"),
+					EAutomationExpectedErrorFlags::Contains, 1);
+				CheckIdToken("Expecting the audience not to match",
+					Server->IssueIdToken(TEXT("other-client-id")),
+					Status::kInvalidTokenCode, Done);
+			});
+
+		LatentIt("Expired",
+			[this](const FDoneDelegate& Done)
+			{
+				CheckIdToken("Expecting the token to be expired",
+					Server->IssueIdToken(kClientId, -3600),
+					Status::kInvalidTokenCode, Done);
+			});
+
+		LatentIt("Signed by an unknown key",
+			[this](const FDoneDelegate& Done)
+			{
+				// the header names a key the server doesn't publish
+				TArray<FString> Segments;
+				Server->IssueIdToken(kClientId).ParseIntoArray(Segments,
+					TEXT("."));
+				FString Header = FBase64::Encode(FString(
+					TEXT("{\"alg\": \"RS256\", \"kid\": \"unknown\"}")));
+				Header.ReplaceInline(TEXT("="), TEXT(""));
+
+				CheckIdToken("Expecting the key not to be found",
+					Header + TEXT(".") + Segments[1] + TEXT(".") +
+						Segments[2], Status::kInvalidTokenCode, Done);
+			});
+	});
+
+	Describe("Account token", [this]()
+	{
+		It("Fails every request without a refresh token",
+			[this]()
+			{
+				AddExpectedError(TEXT("has no refresh token"),
+					EAutomationExpectedErrorFlags::Contains, 2);
+
+				FGoogleDesktopOAuth::FAccountHandle Account =
+					OAuth->AddAccount(kClientId, TEXT("client-secret"),
+						TEXT(""));
+
+				// the second request must not wait for the first one
+				int32 NumberOfFailures = 0;
+				for (int32 i = 0; i < 2; i++)
+				{
+					OAuth->GetAccountToken(
+						[&NumberOfFailures](FString Token, int64 ExpiresOn,
+							Status Code)
+						{
+							if (Code == Status::kInvalidGrantErrorCode)
+							{
+								NumberOfFailures++;
+							}
+						}, Account);
+				}
+
+				TestEqual("Expecting both requests to fail immediately",
+					NumberOfFailures, 2);
+			});
+
+		It("Fails for an unregistered account",
+			[this]()
+			{
+				AddExpectedError(TEXT("is not registered"),
+					EAutomationExpectedErrorFlags::Contains, 1);
+
+				FGoogleDesktopOAuth::FAccountHandle Account =
+					OAuth->AddAccount(kClientId, TEXT("client-secret"),
+						TEXT("refresh-token"));
+				OAuth->RemoveAccount(Account);
+
+				bool bIsFailed = false;
+				OAuth->GetAccountToken(
+					[&bIsFailed](FString Token, int64 ExpiresOn, Status Code)
+					{
+						bIsFailed = Code == Status::kUnknownErrorCode;
+					}, Account);
+
+				TestTrue("Expecting the request to fail immediately",
+					bIsFailed);
+			});
+	});
+
+	Describe("Retry policy", [this]()
+	{
+		BeforeEach([this]()
+		{
+			// short delays keep the specs fast, the backoff is the same
+			FGoogleDesktopOAuth::FRetryPolicy Policy;
+			Policy.MaxRetries = 2;
+			Policy.InitialDelaySeconds = 0.01f;
+			Policy.MaxDelaySeconds = 0.05f;
+			Policy.MaxRetryAfterSeconds = 5.0f;
+			OAuth->SetRetryPolicy(Policy);
+
+			Server->AddRefreshToken(kRefreshToken);
+		});
+
+		LatentIt("Retries 5xx responses",
+			[this](const FDoneDelegate& Done)
+			{
+				Server->FailTokenRequests(2,
+					EHttpServerResponseCodes::ServiceUnavail);
+
+				Refresh("Expecting the refresh to succeed after the retries",
+					Status::kSuccessCode, 3, Done);
+			});
+
+		LatentIt("Waits for Retry-After of a 429 response",
+			[this](const FDoneDelegate& Done)
+			{
+				Server->FailTokenRequests(1,
+					EHttpServerResponseCodes::TooManyRequests, TEXT("1"));
+
+				double StartTime = FPlatformTime::Seconds();
+				OAuth->RefreshAuthToken(
+					[this, StartTime, Done](FString Token, int64 ExpiresOn,
+						Status Code)
+					{
+						TestTrue("Expecting the refresh to succeed",
+							Code == Status::kSuccessCode);
+						TestTrue("Expecting the retry to wait for Retry-After",
+							FPlatformTime::Seconds() - StartTime >= 1.0);
+
+						Done.Execute();
+					}, kClientId, TEXT("client-secret"), kRefreshToken);
+			});
+
+		LatentIt("Gives up if Retry-After exceeds the cap",
+			[this](const FDoneDelegate& Done)
+			{
+				AddExpectedError(TEXT("An error happened when performing"),
+					EAutomationExpectedErrorFlags::Contains, 1);
+				Server->FailTokenRequests(1,
+					EHttpServerResponseCodes::TooManyRequests, TEXT("120"));
+
+				Refresh("Expecting the failure to be reported at once",
+					Status::kUnknownErrorCode, 1, Done);
+			});
+
+		LatentIt("Reports the failure once the retries are exhausted",
+			[this](const FDoneDelegate& Done)
+			{
+				AddExpectedError(TEXT("An error happened when performing"),
+					EAutomationExpectedErrorFlags::Contains, 1);
+				Server->FailTokenRequests(5,
+					EHttpServerResponseCodes::ServiceUnavail);
+
+				Refresh("Expecting the failure to be reported",
+					Status::kUnknownErrorCode, 3, Done);
+			});
+
+		LatentIt("Never retries invalid_grant",
+			[this](const FDoneDelegate& Done)
+			{
+				AddExpectedError(TEXT("Invalid grant error happened"),
+					EAutomationExpectedErrorFlags::Contains, 1);
+				Server->RevokeRefreshToken(kRefreshToken);
+
+				Refresh("Expecting invalid_grant to be reported",
+					Status::kInvalidGrantErrorCode, 1, Done);
+			});
+	});
+}
@@ -0,0 +1,360 @@
+//Flying Wild Hog. All rights reserved
+
+#include "GoogleLoopbackListener.h"
+#include "GoogleDesktopOAuthLog.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+FGoogleLoopbackListener::FGoogleLoopbackListener(FString Path)
+	: Path(MoveTemp(Path)) {}
+
+FGoogleLoopbackListener::~FGoogleLoopbackListener()
+{
+	Attempts.Reset();
+	RouteConfirmationHandlers.Reset();
+	Shutdown();
+}
+
+uint32 FGoogleLoopbackListener::Start(uint32 RequestedPort)
+{
+	if (IsListening() && (RequestedPort == 0 || RequestedPort == Port))
+	{
+		return Port;
+	}
+
+	// the caller wants another port, the attempts in flight are redirected
+	// to the current one, so they are lost anyway
+	Shutdown();
+
+	if (!FHttpServerModule::IsAvailable())
+	{
+		FModuleManager::LoadModuleChecked<FHttpServerModule>("HTTPServer");
+	}
+
+	if (!FHttpServerModule::IsAvailable())
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The HTTP server module cannot be loaded. Unable to start"
+				 " the loopback listener"));
+
+		return 0;
+	}
+
+	// the listener of the previous start can't be stopped, so its port is
+	// reused instead of starting one more listener
+	if (ReservedPort != 0 &&
+		(RequestedPort == 0 || RequestedPort == ReservedPort) &&
+		TryStart(ReservedPort))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Log,
+			TEXT("The loopback listener is up again on port %u"), Port);
+
+		return Port;
+	}
+
+	// a picked port may be taken by another process before it's bound, so
+	// a few are tried. A requested port is tried once
+	int32 NumberOfAttempts = RequestedPort != 0 ? 1 : kMaxPortAttempts;
+	for (int32 i = 0; i < NumberOfAttempts; i++)
+	{
+		uint32 Candidate = RequestedPort != 0 ? RequestedPort :
+			FindFreePort();
+		if (Candidate != 0 && TryStart(Candidate))
+		{
+			UE_LOG(LogGoogleDesktopOAuth, Log,
+				TEXT("The loopback listener is up on port %u"), Port);
+
+			return Port;
+		}
+	}
+
+	UE_LOG(LogGoogleDesktopOAuth, Error,
+		TEXT("Unable to start the loopback listener"));
+
+	return 0;
+}
+
+FString FGoogleLoopbackListener::AddAttempt(RequestHandlerType OnRequest,
+	TimeoutHandlerType OnTimeout, float TimeoutSeconds)
+{
+	check(IsListening());
+
+	FString State = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+
+	FAttempt Attempt;
+	Attempt.OnRequest = MoveTemp(OnRequest);
+	Attempt.OnTimeout = MoveTemp(OnTimeout);
+	Attempt.ExpiresOn = FPlatformTime::Seconds() + TimeoutSeconds;
+	Attempts.Add(State, MoveTemp(Attempt));
+
+	return State;
+}
+
+void FGoogleLoopbackListener::WhenRouteConfirmed(
+	RouteConfirmationHandlerType OnConfirmation)
+{
+	check(IsListening());
+
+	if (bIsRouteConfirmed && !ProbeRequest.IsValid())
+	{
+		OnConfirmation(true);
+
+		return;
+	}
+
+	RouteConfirmationHandlers.Add(MoveTemp(OnConfirmation));
+}
+
+void FGoogleLoopbackListener::Shutdown()
+{
+	if (ProbeRequest.IsValid())
+	{
+		ProbeRequest->OnProcessRequestComplete().Unbind();
+		ProbeRequest->CancelRequest();
+		ProbeRequest.Reset();
+	}
+	bIsRouteConfirmed = false;
+
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	if (Router.IsValid())
+	{
+		Router->UnbindRoute(RouteHandle);
+	}
+	Router.Reset();
+	RouteHandle.Reset();
+	Port = 0;
+
+	TMap<FString, FAttempt> TimedOutAttempts = MoveTemp(Attempts);
+	for (auto& Attempt : TimedOutAttempts)
+	{
+		Attempt.Value.OnTimeout();
+	}
+
+	TArray<RouteConfirmationHandlerType> Handlers =
+		MoveTemp(RouteConfirmationHandlers);
+	for (RouteConfirmationHandlerType& OnConfirmation : Handlers)
+	{
+		OnConfirmation(false);
+	}
+}
+
+bool FGoogleLoopbackListener::IsListening() const
+{
+	return Router.IsValid();
+}
+
+bool FGoogleLoopbackListener::IsRouteConfirmed() const
+{
+	return bIsRouteConfirmed;
+}
+
+uint32 FGoogleLoopbackListener::GetPort() const
+{
+	return Port;
+}
+
+bool FGoogleLoopbackListener::HandleRequest(
+	const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	// anything can knock on a loopback port, only redirects which carry
+	// the state of a pending attempt are handled
+	const FString* State = Request.QueryParams.Find(kStateField);
+	if (State && !ProbeState.IsEmpty() && *State == ProbeState)
+	{
+		bIsRouteConfirmed = true;
+
+		OnComplete(FHttpServerResponse::Create(FString(),
+			TEXT("text/plain")));
+
+		return true;
+	}
+
+	FAttempt Attempt;
+	if (!State || !Attempts.RemoveAndCopyValue(*State, Attempt))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("The loopback listener has got a request which doesn't"
+				 " belong to any authentication attempt"));
+
+		OnComplete(FHttpServerResponse::Error(
+			EHttpServerResponseCodes::BadRequest));
+
+		return true;
+	}
+
+	if (Attempts.Num() == 0)
+	{
+		IdleSince = FPlatformTime::Seconds();
+	}
+
+	Attempt.OnRequest(Request, OnComplete);
+
+	return true;
+}
+
+bool FGoogleLoopbackListener::Tick(float DeltaTime)
+{
+	double Now = FPlatformTime::Seconds();
+
+	TArray<TimeoutHandlerType> TimeoutHandlers;
+	for (auto It = Attempts.CreateIterator(); It; ++It)
+	{
+		if (It.Value().ExpiresOn <= Now)
+		{
+			TimeoutHandlers.Add(MoveTemp(It.Value().OnTimeout));
+			It.RemoveCurrent();
+
+			if (Attempts.Num() == 0)
+			{
+				IdleSince = Now;
+			}
+		}
+	}
+
+	// the handlers may start new attempts
+	for (TimeoutHandlerType& OnTimeout : TimeoutHandlers)
+	{
+		OnTimeout();
+	}
+
+	if (Attempts.Num() == 0 && Now - IdleSince >= kIdleTimeoutSeconds)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Log,
+			TEXT("The loopback listener has been idle for %.0f seconds,"
+				 " shutting it down"), kIdleTimeoutSeconds);
+
+		// the ticker is removed by returning `false`
+		TickerHandle.Reset();
+		Shutdown();
+
+		return false;
+	}
+
+	return true;
+}
+
+bool FGoogleLoopbackListener::TryStart(uint32 Candidate)
+{
+	FHttpServerModule& HttpServer = FHttpServerModule::Get();
+	TSharedPtr<IHttpRouter> CandidateRouter =
+		HttpServer.GetHttpRouter(Candidate);
+	if (!CandidateRouter.IsValid())
+	{
+		return false;
+	}
+
+	FHttpRouteHandle CandidateRouteHandle = CandidateRouter->BindRoute(
+		FHttpPath(Path), EHttpServerRequestVerbs::VERB_GET |
+		EHttpServerRequestVerbs::VERB_POST,
+		[this](const FHttpServerRequest& Request,
+			const FHttpResultCallback& OnComplete)
+		{
+			return HandleRequest(Request, OnComplete);
+		});
+	if (!CandidateRouteHandle.IsValid())
+	{
+		// another route is bound on the path, e.g. by another instance
+		return false;
+	}
+
+	HttpServer.StartAllListeners();
+
+	Port = Candidate;
+	ReservedPort = Candidate;
+	Router = MoveTemp(CandidateRouter);
+	RouteHandle = MoveTemp(CandidateRouteHandle);
+	IdleSince = FPlatformTime::Seconds();
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FGoogleLoopbackListener::Tick),
+		kTickIntervalSeconds);
+
+	ProbeRoute();
+
+	return true;
+}
+
+void FGoogleLoopbackListener::ProbeRoute()
+{
+	// something answering on the port isn't enough, another process might
+	// have taken it before the listener, so the probe has to reach the route
+	ProbeState = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+	bIsRouteConfirmed = false;
+
+	ProbeRequest = FHttpModule::Get().CreateRequest();
+	ProbeRequest->SetVerb(TEXT("GET"));
+	ProbeRequest->SetURL(FString::Printf(TEXT("http://127.0.0.1:%u%s?%s=%s"),
+		Port, *Path, kStateField, *ProbeState));
+	ProbeRequest->OnProcessRequestComplete().BindRaw(this,
+		&FGoogleLoopbackListener::HandleProbeResponse);
+	ProbeRequest->ProcessRequest();
+}
+
+void FGoogleLoopbackListener::HandleProbeResponse(FHttpRequestPtr Request,
+	FHttpResponsePtr Response, bool bIsSuccessful)
+{
+	ProbeRequest.Reset();
+
+	if (bIsSuccessful && Response.IsValid() &&
+		EHttpResponseCodes::IsOk(Response->GetResponseCode()) &&
+		bIsRouteConfirmed)
+	{
+		// the handlers may start attempts or shut the listener down
+		TArray<RouteConfirmationHandlerType> Handlers =
+			MoveTemp(RouteConfirmationHandlers);
+		for (RouteConfirmationHandlerType& OnConfirmation : Handlers)
+		{
+			OnConfirmation(true);
+		}
+
+		return;
+	}
+
+	UE_LOG(LogGoogleDesktopOAuth, Warning,
+		TEXT("The loopback route on port %u can't be reached, shutting the"
+			 " listener down"), Port);
+
+	// the port isn't the listener's one, the next start picks another
+	ReservedPort = 0;
+	Shutdown();
+}
+
+uint32 FGoogleLoopbackListener::FindFreePort()
+{
+	// binding to port 0 makes the OS pick a free ephemeral port, the socket
+	// is closed right away to give the port to the HTTP server
+	ISocketSubsystem* SocketSubsystem =
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Socket = SocketSubsystem->CreateSocket(NAME_Stream,
+		TEXT("GoogleLoopbackPortProbe"), false);
+	if (!Socket)
+	{
+		return 0;
+	}
+
+	TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	Address->SetLoopbackAddress();
+	Address->SetPort(0);
+
+	uint32 FreePort = 0;
+	if (Socket->Bind(*Address))
+	{
+		FreePort = static_cast<uint32>(Socket->GetPortNo());
+	}
+
+	Socket->Close();
+	SocketSubsystem->DestroySocket(Socket);
+
+	return FreePort;
+}
@@ -0,0 +1,194 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+#include "Interfaces/IHttpRequest.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+/**
+* Loopback HTTP listener Google redirects the browser to at the end of the
+* Desktop OAuth loopback IP flow
+*
+* Is started once and reused by the following authentication attempts, so
+* a repeated login doesn't pay for the listener setup. A free ephemeral port
+* is picked automatically. Right after the route is bound a probe request is
+* sent to it, if the probe isn't answered by the route (e.g. another process
+* has taken the port first) the listener is shut down and the pending
+* attempts time out. Use `WhenRouteConfirmed()` to wait for the probe before
+* sending the browser to the route. Attempts are told apart by the OAuth `state`
+* parameter, so several of them may be in flight. The route is unbound after
+* `kIdleTimeoutSeconds` without attempts
+*
+* Note that UE4's HTTP Server module doesn't allow to stop a single
+* listener, so the socket itself is closed only when the module stops all of
+* its listeners. The port stays reserved for this listener until then and
+* the route is bound on it again by the next `Start()`, so idle shutdowns
+* don't leave a listener behind each. Only requesting another port
+* explicitly starts another listener
+*
+* Must be used on the game thread only
+*
+* Uses `LogGoogleDesktopOAuth` log category
+*/
+class FGoogleLoopbackListener
+{
+public:
+	//Type of callback function called with the redirect of an attempt
+	using RequestHandlerType = TFunction<void(
+		const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete)>;
+
+	//Type of callback function called when an attempt times out
+	using TimeoutHandlerType = TFunction<void()>;
+
+	//Type of callback function called with the result of the probe
+	using RouteConfirmationHandlerType = TFunction<void(bool bIsConfirmed)>;
+
+	/**
+	* @param Path Path of the redirect URI
+	*/
+	explicit FGoogleLoopbackListener(FString Path);
+
+	//Drops the pending attempts without calling their handlers
+	~FGoogleLoopbackListener();
+
+	/**
+	* Makes sure the route is bound on a started listener
+	*
+	* Returns immediately if the listener is already up on a suitable port
+	*
+	* @param RequestedPort Port to listen on, `0` keeps the current port,
+	* reuses the port of the previous start or picks a free one
+	* @return The port the listener is up on or `0` if it couldn't be started
+	*/
+	uint32 Start(uint32 RequestedPort = 0);
+
+	/**
+	* Registers an authentication attempt. The listener must be started
+	*
+	* Exactly one of the handlers is called, unless the listener is
+	* destroyed first
+	*
+	* @param OnRequest Handler of the redirect which carries the returned
+	* `state`
+	* @param OnTimeout Handler called if there is no redirect in time or the
+	* listener is shut down
+	* @param TimeoutSeconds How long to wait for the redirect
+	* @return Value of the `state` parameter to pass to the consent page
+	*/
+	FString AddAttempt(RequestHandlerType OnRequest,
+		TimeoutHandlerType OnTimeout, float TimeoutSeconds);
+
+	/**
+	* Calls the handler once the probe request has reached the route, right
+	* away if it already has. The listener must be started
+	*
+	* The handler is called with `false` if the probe fails or the listener
+	* is shut down first, and isn't called if the listener is destroyed first
+	*
+	* @param OnConfirmation Handler called with whether the route is
+	* confirmed
+	*/
+	void WhenRouteConfirmed(RouteConfirmationHandlerType OnConfirmation);
+
+	/**
+	* Unbinds the route, the pending attempts time out immediately and the
+	* handlers waiting for the probe are called with `false`
+	*/
+	void Shutdown();
+
+	/**
+	* @return `true` if the route is bound and the listener is up
+	*/
+	bool IsListening() const;
+
+	/**
+	* @return `true` if the probe request has reached the route
+	*/
+	bool IsRouteConfirmed() const;
+
+	/**
+	* @return The port the listener is up on or `0`
+	*/
+	uint32 GetPort() const;
+
+	//Name of the OAuth parameter attempts are told apart by
+	static constexpr const TCHAR* kStateField = TEXT("state");
+
+	//How long the route stays bound without attempts
+	static constexpr double kIdleTimeoutSeconds = 120.0;
+
+private:
+	struct FAttempt
+	{
+		RequestHandlerType OnRequest;
+
+		TimeoutHandlerType OnTimeout;
+
+		//`FPlatformTime::Seconds()` the attempt times out on
+		double ExpiresOn = 0.0;
+	};
+
+	bool HandleRequest(const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete);
+
+	//Times out the attempts and shuts the listener down when it's idle
+	bool Tick(float DeltaTime);
+
+	//Binds the route on the port and sends the probe request to it
+	bool TryStart(uint32 Candidate);
+
+	//Sends a request with `ProbeState` to the route
+	void ProbeRoute();
+
+	//Shuts the listener down if the probe hasn't reached the route, calls
+	//the handlers waiting for the probe
+	void HandleProbeResponse(FHttpRequestPtr Request,
+		FHttpResponsePtr Response, bool bIsSuccessful);
+
+	//Asks the OS for a free loopback port, `0` on failure
+	static uint32 FindFreePort();
+
+	//How many free ports are tried if another process takes the picked one
+	//before the listener binds it
+	static constexpr int32 kMaxPortAttempts = 4;
+
+	//How often the attempts are checked for the timeout
+	static constexpr float kTickIntervalSeconds = 1.0f;
+
+	FString Path;
+
+	uint32 Port = 0;
+
+	//Port the listener of the HTTP server module has been started on, is
+	//kept over shutdowns since that listener can't be stopped
+	uint32 ReservedPort = 0;
+
+	TSharedPtr<IHttpRouter> Router;
+
+	FHttpRouteHandle RouteHandle;
+
+	//Pending attempts by their `state`
+	TMap<FString, FAttempt> Attempts;
+
+	//`FPlatformTime::Seconds()` the last attempt was finished on
+	double IdleSince = 0.0;
+
+	FDelegateHandle TickerHandle;
+
+	//`state` of the probe request, is never handed to an attempt
+	FString ProbeState;
+
+	bool bIsRouteConfirmed = false;
+
+	//Handlers waiting for the in-flight probe request
+	TArray<RouteConfirmationHandlerType> RouteConfirmationHandlers;
+
+	FHttpRequestPtr ProbeRequest;
+};
@@ -0,0 +1,290 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Containers/Ticker.h"
+#include "HttpModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "GoogleLoopbackListener.h"
+
+namespace
+{
+	//How long the probe request may take to reach the route
+	constexpr double kProbeTimeoutSeconds = 5.0;
+
+	const TCHAR* const kPath = TEXT("/loopback-listener-spec");
+}
+
+BEGIN_DEFINE_SPEC(FGoogleLoopbackListenerSpec,
+	"GoogleOAuth.LoopbackListener",
+	EAutomationTestFlags::ProductFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FGoogleLoopbackListener> Listener;
+
+/**
+* Sends a redirect carrying the state to the listener like the browser does
+*
+* @param OnResponse Called with the response code, `0` if there's no
+* response
+*/
+void SendRedirect(const FString& State, TFunction<void(int32)> OnResponse)
+{
+	FString Url = FString::Printf(TEXT("http://127.0.0.1:%u%s"),
+		Listener->GetPort(), kPath);
+	if (!State.IsEmpty())
+	{
+		Url += FString::Printf(TEXT("?%s=%s&code=spec"),
+			FGoogleLoopbackListener::kStateField, *State);
+	}
+
+	FHttpRequestPtr Request = FHttpModule::Get().CreateRequest();
+	Request->SetVerb(TEXT("GET"));
+	Request->SetURL(Url);
+	Request->OnProcessRequestComplete().BindLambda(
+		[OnResponse](FHttpRequestPtr, FHttpResponsePtr Response, bool)
+		{
+			OnResponse(Response.IsValid() ? Response->GetResponseCode() : 0);
+		});
+	Request->ProcessRequest();
+}
+
+//Attempt handler which answers the redirect and records its state
+FGoogleLoopbackListener::RequestHandlerType AnswerRedirect(
+	TSharedRef<TArray<FString>> HandledStates)
+{
+	return [HandledStates](const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete)
+	{
+		const FString* State =
+			Request.QueryParams.Find(FGoogleLoopbackListener::kStateField);
+		HandledStates->Add(State ? *State : FString());
+
+		OnComplete(FHttpServerResponse::Create(TEXT("done"),
+			TEXT("text/plain")));
+	};
+}
+
+END_DEFINE_SPEC(FGoogleLoopbackListenerSpec)
+
+void FGoogleLoopbackListenerSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Listener = MakeUnique<FGoogleLoopbackListener>(kPath);
+	});
+
+	AfterEach([this]()
+	{
+		Listener.Reset();
+	});
+
+	It("Rebinds on the same port after a shutdown",
+		[this]()
+		{
+			uint32 Port = Listener->Start();
+			TestNotEqual("Expecting the listener to start", Port, 0u);
+
+			Listener->Shutdown();
+			TestFalse("Expecting the route to be unbound",
+				Listener->IsListening());
+
+			TestEqual("Expecting the listener of the first start to be reused",
+				Listener->Start(), Port);
+		}
+	);
+
+	LatentIt("Confirms the route with a probe request",
+		[this](const FDoneDelegate& Done)
+		{
+			TestNotEqual("Expecting the listener to start", Listener->Start(),
+				0u);
+
+			double Deadline = FPlatformTime::Seconds() + kProbeTimeoutSeconds;
+			FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+				[this, Deadline, Done](float DeltaTime)
+				{
+					if (!Listener->IsRouteConfirmed() &&
+						FPlatformTime::Seconds() < Deadline)
+					{
+						return true;
+					}
+
+					TestTrue("Expecting the probe to reach the route",
+						Listener->IsRouteConfirmed());
+					TestTrue("Expecting the listener to stay up",
+						Listener->IsListening());
+
+					Done.Execute();
+
+					return false;
+				}));
+		}
+	);
+
+	It("Fails the confirmation when shut down before the probe",
+		[this]()
+		{
+			TestNotEqual("Expecting the listener to start", Listener->Start(),
+				0u);
+
+			TOptional<bool> bIsConfirmed;
+			Listener->WhenRouteConfirmed([&bIsConfirmed](bool bResult)
+				{
+					bIsConfirmed = bResult;
+				});
+			Listener->Shutdown();
+
+			TestTrue("Expecting the handler to be called with `false`",
+				bIsConfirmed.IsSet() && !bIsConfirmed.GetValue());
+		}
+	);
+
+	LatentIt("Times an attempt out",
+		[this](const FDoneDelegate& Done)
+		{
+			TestNotEqual("Expecting the listener to start", Listener->Start(),
+				0u);
+
+			TSharedRef<TArray<FString>> HandledStates =
+				MakeShared<TArray<FString>>();
+			TSharedRef<bool> bIsTimedOut = MakeShared<bool>(false);
+			Listener->AddAttempt(AnswerRedirect(HandledStates),
+				[bIsTimedOut]()
+				{
+					*bIsTimedOut = true;
+				}, 0.1f);
+
+			double Deadline = FPlatformTime::Seconds() + kProbeTimeoutSeconds;
+			FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+				[this, Deadline, Done, HandledStates, bIsTimedOut](
+					float DeltaTime)
+				{
+					if (!*bIsTimedOut && FPlatformTime::Seconds() < Deadline)
+					{
+						return true;
+					}
+
+					TestTrue("Expecting the attempt to time out",
+						*bIsTimedOut);
+					TestEqual("Expecting no redirect to be handled",
+						HandledStates->Num(), 0);
+					TestTrue("Expecting the listener to stay up",
+						Listener->IsListening());
+
+					Done.Execute();
+
+					return false;
+				}));
+		}
+	);
+
+	LatentIt("Answers a stray state with 400",
+		[this](const FDoneDelegate& Done)
+		{
+			AddExpectedError(TEXT("doesn't belong to any authentication"),
+				EAutomationExpectedErrorFlags::Contains, 2);
+
+			TestNotEqual("Expecting the listener to start", Listener->Start(),
+				0u);
+
+			Listener->WhenRouteConfirmed([this, Done](bool bIsConfirmed)
+				{
+					if (!TestTrue("Expecting the route to be confirmed",
+						bIsConfirmed))
+					{
+						Done.Execute();
+						return;
+					}
+
+					TSharedRef<TArray<FString>> HandledStates =
+						MakeShared<TArray<FString>>();
+					FString State = Listener->AddAttempt(
+						AnswerRedirect(HandledStates), []() {}, 60.0f);
+
+					SendRedirect(TEXT("stray"),
+						[this, Done, State, HandledStates](int32 StrayCode)
+						{
+							TestEqual("Expecting a stray state to be rejected",
+								StrayCode, 400);
+
+							SendRedirect(FString(),
+								[this, Done, State, HandledStates](
+									int32 NoStateCode)
+								{
+									TestEqual("Expecting a missing state to "
+										"be rejected", NoStateCode, 400);
+
+									SendRedirect(State,
+										[this, Done, State, HandledStates](
+											int32 Code)
+										{
+											TestEqual("Expecting the attempt "
+												"to be kept", Code, 200);
+											TestTrue("Expecting its handler "
+												"to be called",
+												HandledStates->Num() == 1 &&
+												(*HandledStates)[0] == State);
+
+											Done.Execute();
+										});
+								});
+						});
+				});
+		}
+	);
+
+	LatentIt("Tells concurrent attempts apart",
+		[this](const FDoneDelegate& Done)
+		{
+			TestNotEqual("Expecting the listener to start", Listener->Start(),
+				0u);
+
+			Listener->WhenRouteConfirmed([this, Done](bool bIsConfirmed)
+				{
+					if (!TestTrue("Expecting the route to be confirmed",
+						bIsConfirmed))
+					{
+						Done.Execute();
+						return;
+					}
+
+					TSharedRef<TArray<FString>> FirstStates =
+						MakeShared<TArray<FString>>();
+					TSharedRef<TArray<FString>> SecondStates =
+						MakeShared<TArray<FString>>();
+					FString First = Listener->AddAttempt(
+						AnswerRedirect(FirstStates), []() {}, 60.0f);
+					FString Second = Listener->AddAttempt(
+						AnswerRedirect(SecondStates), []() {}, 60.0f);
+					TestNotEqual("Expecting different states", First, Second);
+
+					//The second attempt finishes first
+					SendRedirect(Second, [this, Done, First, Second,
+						FirstStates, SecondStates](int32 SecondCode)
+						{
+							SendRedirect(First, [this, Done, First, Second,
+								FirstStates, SecondStates, SecondCode](
+									int32 FirstCode)
+								{
+									TestTrue("Expecting both redirects to be "
+										"answered", FirstCode == 200 &&
+										SecondCode == 200);
+									TestTrue("Expecting each attempt to get "
+										"its own redirect",
+										FirstStates->Num() == 1 &&
+										(*FirstStates)[0] == First &&
+										SecondStates->Num() == 1 &&
+										(*SecondStates)[0] == Second);
+
+									Done.Execute();
+								});
+						});
+				});
+		}
+	);
+}
@@ -0,0 +1,262 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "GoogleDesktopOAuth.h"
+#include "GoogleOAuthMockServer.h"
+
+namespace
+{
+	using Status = FGoogleDesktopOAuth::Status;
+
+	//Loopback port the mock server listens on
+	constexpr uint32 kMockServerPort = 18463;
+
+	//Imitated round trip to Google, `0` measures the client and the local
+	//stack only
+	constexpr float kResponseDelaySeconds = 0.0f;
+
+	constexpr int32 kNumberOfCalls = 256;
+
+	/**
+	* State of one run of calls which are kept `Concurrency` in flight
+	*/
+	struct FRun
+	{
+		FString Name;
+
+		int32 NumberOfCalls = 0;
+
+		int32 Concurrency = 0;
+
+		Status ExpectedCode = Status::kSuccessCode;
+
+		//Issues one call, the call reports its result through the argument
+		TFunction<void(TFunction<void(Status)>)> Issue;
+
+		int32 NumberOfIssuedCalls = 0;
+
+		int32 NumberOfCompletedCalls = 0;
+
+		int32 NumberOfUnexpectedCodes = 0;
+
+		double StartTime = 0.0;
+
+		TArray<double> Latencies;
+
+		FDoneDelegate Done;
+	};
+
+	double GetPercentile(const TArray<double>& SortedValues,
+		double Percentile)
+	{
+		if (SortedValues.Num() == 0)
+		{
+			return 0.0;
+		}
+
+		int32 Index = FMath::Clamp(
+			FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0,
+			SortedValues.Num() - 1);
+
+		return SortedValues[Index];
+	}
+}
+
+/**
+* Times the HTTP flows of `FGoogleDesktopOAuth` against
+* `FGoogleOAuthMockServer`
+*
+* Both the client and the server are ticked on the game thread, so the
+* latencies are rounded up to the frame time and the throughput is bound by
+* the frame rate. Compare the runs with each other rather than with the
+* real endpoints
+*/
+BEGIN_DEFINE_SPEC(FGoogleOAuthFlowBenchmarkSpec,
+	"GoogleOAuth.Benchmark.Flows",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FGoogleOAuthMockServer> Server;
+
+TUniquePtr<FGoogleDesktopOAuth> OAuth;
+
+void IssueNext(TSharedRef<FRun> Run)
+{
+	Run->NumberOfIssuedCalls++;
+
+	double IssueTime = FPlatformTime::Seconds();
+	Run->Issue([this, Run, IssueTime](Status Code)
+	{
+		Run->Latencies.Add(FPlatformTime::Seconds() - IssueTime);
+		if (Code != Run->ExpectedCode)
+		{
+			Run->NumberOfUnexpectedCodes++;
+		}
+
+		if (Run->NumberOfIssuedCalls < Run->NumberOfCalls)
+		{
+			IssueNext(Run);
+		}
+
+		if (++Run->NumberOfCompletedCalls == Run->NumberOfCalls)
+		{
+			Report(*Run);
+		}
+	});
+}
+
+void Report(FRun& Run)
+{
+	double ElapsedTime = FPlatformTime::Seconds() - Run.StartTime;
+	Run.Latencies.Sort();
+
+	AddInfo(FString::Printf(TEXT("%s, %d in flight: %.1f calls/s; latency"
+		" p50 %.2f ms, p99 %.2f ms, max %.2f ms"), *Run.Name,
+		Run.Concurrency, Run.NumberOfCalls / ElapsedTime,
+		GetPercentile(Run.Latencies, 0.5) * 1000.0,
+		GetPercentile(Run.Latencies, 0.99) * 1000.0,
+		Run.Latencies.Last() * 1000.0));
+
+	TestEqual(FString::Printf(TEXT("%s: expecting every call to report the"
+		" expected code"), *Run.Name), Run.NumberOfUnexpectedCodes, 0);
+
+	Run.Done.Execute();
+}
+
+void Measure(FString Name, int32 Concurrency, Status ExpectedCode,
+	TFunction<void(TFunction<void(Status)>)> Issue,
+	const FDoneDelegate& Done)
+{
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->Name = MoveTemp(Name);
+	Run->NumberOfCalls = kNumberOfCalls;
+	Run->Concurrency = Concurrency;
+	Run->ExpectedCode = ExpectedCode;
+	Run->Issue = MoveTemp(Issue);
+	Run->Done = Done;
+	Run->Latencies.Reserve(kNumberOfCalls);
+	Run->StartTime = FPlatformTime::Seconds();
+
+	// calls which complete synchronously issue the following ones themselves
+	for (int32 i = 0; i < Concurrency &&
+		Run->NumberOfIssuedCalls < Run->NumberOfCalls; i++)
+	{
+		IssueNext(Run);
+	}
+}
+
+END_DEFINE_SPEC(FGoogleOAuthFlowBenchmarkSpec)
+
+void FGoogleOAuthFlowBenchmarkSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Server = MakeUnique<FGoogleOAuthMockServer>(kMockServerPort);
+		Server->SetResponseDelay(kResponseDelaySeconds);
+		Server->AddRefreshToken(TEXT("valid-refresh-token"));
+		TestTrue("Expecting the mock server to start", Server->Start());
+
+		OAuth = MakeUnique<FGoogleDesktopOAuth>(Server->GetEndpoints());
+	});
+
+	AfterEach([this]()
+	{
+		OAuth.Reset();
+		Server.Reset();
+	});
+
+	for (int32 Concurrency : { 1, 16 })
+	{
+		Describe(FString::Printf(TEXT("%d in flight"), Concurrency),
+			[this, Concurrency]()
+			{
+				LatentIt("Refresh", FTimespan::FromSeconds(60),
+					[this, Concurrency](const FDoneDelegate& Done)
+					{
+						Measure("Refresh", Concurrency, Status::kSuccessCode,
+							[this](TFunction<void(Status)> OnComplete)
+							{
+								OAuth->RefreshAuthToken(
+									[OnComplete](FString Token,
+										int64 ExpiresOn, Status Code)
+									{
+										OnComplete(Code);
+									}, TEXT("client-id"),
+									TEXT("client-secret"),
+									TEXT("valid-refresh-token"));
+							}, Done);
+					});
+
+				LatentIt("Refresh with invalid_grant",
+					FTimespan::FromSeconds(60),
+					[this, Concurrency](const FDoneDelegate& Done)
+					{
+						Measure("Refresh with invalid_grant", Concurrency,
+							Status::kInvalidGrantErrorCode,
+							[this](TFunction<void(Status)> OnComplete)
+							{
+								OAuth->RefreshAuthToken(
+									[OnComplete](FString Token,
+										int64 ExpiresOn, Status Code)
+									{
+										OnComplete(Code);
+									}, TEXT("client-id"),
+									TEXT("client-secret"),
+									TEXT("revoked-refresh-token"));
+							}, Done);
+					});
+
+				LatentIt("Remote check of a valid token",
+					FTimespan::FromSeconds(60),
+					[this, Concurrency](const FDoneDelegate& Done)
+					{
+						FString AccessToken = Server->IssueAccessToken();
+						Measure("Remote check", Concurrency,
+							Status::kSuccessCode,
+							[this, AccessToken]
+							(TFunction<void(Status)> OnComplete)
+							{
+								OAuth->CheckAccessToken(OnComplete,
+									AccessToken);
+							}, Done);
+					});
+
+				LatentIt("Remote check of an unknown token",
+					FTimespan::FromSeconds(60),
+					[this, Concurrency](const FDoneDelegate& Done)
+					{
+						Measure("Remote check of an unknown token",
+							Concurrency, Status::kUnknownErrorCode,
+							[this](TFunction<void(Status)> OnComplete)
+							{
+								OAuth->CheckAccessToken(OnComplete,
+									TEXT("ya29.unknown"));
+							}, Done);
+					});
+
+				LatentIt("Local-first check of a remembered token",
+					FTimespan::FromSeconds(60),
+					[this, Concurrency](const FDoneDelegate& Done)
+					{
+						FString AccessToken = Server->IssueAccessToken();
+						OAuth->RememberAccessToken(AccessToken,
+							FDateTime::Now().ToUnixTimestamp() +
+							FGoogleOAuthMockServer::
+								kAccessTokenLifetimeSeconds);
+
+						Measure("Local-first check", Concurrency,
+							Status::kSuccessCode,
+							[this, AccessToken]
+							(TFunction<void(Status)> OnComplete)
+							{
+								OAuth->CheckAccessToken(OnComplete,
+									AccessToken,
+									FGoogleDesktopOAuth::TokenValidationMode::
+										LocalFirst);
+							}, Done);
+					});
+			});
+	}
+}
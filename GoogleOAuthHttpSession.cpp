@@ -0,0 +1,225 @@
+//Flying Wild Hog. All rights reserved
+
+#include "GoogleOAuthHttpSession.h"
+#include "GoogleDesktopOAuthLog.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Containers/Ticker.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	//Name of `Retry-After` HTTP header
+	const TCHAR* const kRetryAfterHeader = TEXT("Retry-After");
+
+	//`Retry-After` is either a number of seconds or an HTTP date
+	bool ParseRetryAfter(const FString& Value, float& OutSeconds)
+	{
+		if (Value.IsNumeric())
+		{
+			OutSeconds = FCString::Atof(*Value);
+
+			return true;
+		}
+
+		FDateTime Date;
+		if (FDateTime::ParseHttpDate(Value, Date))
+		{
+			OutSeconds = FMath::Max(0.0f, static_cast<float>(
+				(Date - FDateTime::UtcNow()).GetTotalSeconds()));
+
+			return true;
+		}
+
+		return false;
+	}
+}
+
+FGoogleOAuthHttpSession::FGoogleOAuthHttpSession(int32 MaxConnections)
+	: MaxConnections(FMath::Max(MaxConnections, 1)) {}
+
+FGoogleOAuthHttpSession::~FGoogleOAuthHttpSession()
+{
+	Lifetime.Reset();
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe>
+	FGoogleOAuthHttpSession::CreateRequest() const
+{
+	return FHttpModule::Get().CreateRequest();
+}
+
+void FGoogleOAuthHttpSession::ProcessRequest(
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request,
+	CompletionCallbackType Callback)
+{
+	TSharedRef<int32, ESPMode::ThreadSafe> NumberOfRetries =
+		MakeShared<int32, ESPMode::ThreadSafe>(0);
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakLifetime = Lifetime;
+
+	Request->OnProcessRequestComplete().BindLambda(
+		[this, WeakLifetime, Callback = MoveTemp(Callback), NumberOfRetries](
+			FHttpRequestPtr Request, FHttpResponsePtr Response,
+			bool bWasSuccessful)
+		{
+			// the request has outlived the session, which may have taken the
+			// owner of the callback with it
+			if (!WeakLifetime.IsValid())
+			{
+				return;
+			}
+
+			// the connection is back in the HTTP module's cache by now, the
+			// next request picks it up. A retried request doesn't hold it
+			// while waiting
+			HandleRequestCompletion();
+
+			float DelaySeconds;
+			if (ShouldRetry(Request, Response, *NumberOfRetries, DelaySeconds))
+			{
+				(*NumberOfRetries)++;
+				ScheduleRetry(Request.ToSharedRef(), DelaySeconds);
+				return;
+			}
+
+			Callback(Request, Response, bWasSuccessful);
+		});
+
+	Submit(MoveTemp(Request));
+}
+
+void FGoogleOAuthHttpSession::SetRetryPolicy(const FRetryPolicy& Policy)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	RetryPolicy = Policy;
+}
+
+int32 FGoogleOAuthHttpSession::GetNumberOfRequestsInFlight() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	return NumberOfRequestsInFlight;
+}
+
+void FGoogleOAuthHttpSession::Submit(
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (NumberOfRequestsInFlight >= MaxConnections)
+		{
+			QueuedRequests.Enqueue(MoveTemp(Request));
+			return;
+		}
+
+		NumberOfRequestsInFlight++;
+	}
+
+	Request->ProcessRequest();
+}
+
+void FGoogleOAuthHttpSession::HandleRequestCompletion()
+{
+	FHttpRequestPtr NextRequest;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		// the slot is handed to the next request rather than released
+		if (!QueuedRequests.Dequeue(NextRequest))
+		{
+			NumberOfRequestsInFlight--;
+		}
+	}
+
+	if (NextRequest.IsValid())
+	{
+		NextRequest->ProcessRequest();
+	}
+}
+
+bool FGoogleOAuthHttpSession::ShouldRetry(FHttpRequestPtr Request,
+	FHttpResponsePtr Response, int32 NumberOfRetries,
+	float& OutDelaySeconds) const
+{
+	FRetryPolicy Policy;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Policy = RetryPolicy;
+	}
+
+	if (NumberOfRetries >= Policy.MaxRetries)
+	{
+		return false;
+	}
+
+	FString RetryAfter;
+	if (Request->GetStatus() == EHttpRequestStatus::Failed_ConnectionError)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("`%s` has failed due to connectivity problems"),
+			*Request->GetURL());
+	}
+	else if (Response.IsValid() && (Response->GetResponseCode() == 429 ||
+		(Response->GetResponseCode() >= 500 &&
+			Response->GetResponseCode() < 600)))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("`%s` has answered with %d"), *Request->GetURL(),
+			Response->GetResponseCode());
+
+		RetryAfter = Response->GetHeader(kRetryAfterHeader);
+	}
+	else
+	{
+		// the request has succeeded or failed for good
+		return false;
+	}
+
+	float DelaySeconds = FMath::Min(Policy.MaxDelaySeconds,
+		Policy.InitialDelaySeconds *
+			FMath::Pow(Policy.BackoffMultiplier, NumberOfRetries));
+	DelaySeconds = FMath::FRandRange(DelaySeconds * 0.5f, DelaySeconds);
+
+	float RetryAfterSeconds;
+	if (!RetryAfter.IsEmpty() && ParseRetryAfter(RetryAfter, RetryAfterSeconds))
+	{
+		if (RetryAfterSeconds > Policy.MaxRetryAfterSeconds)
+		{
+			UE_LOG(LogGoogleDesktopOAuth, Warning,
+				TEXT("The server asks to retry in %.0f seconds, giving up"),
+				RetryAfterSeconds);
+
+			return false;
+		}
+
+		DelaySeconds = FMath::Max(DelaySeconds, RetryAfterSeconds);
+	}
+
+	UE_LOG(LogGoogleDesktopOAuth, Log,
+		TEXT("Retrying in %.2f seconds (retry %d of %d)"), DelaySeconds,
+		NumberOfRetries + 1, Policy.MaxRetries);
+
+	OutDelaySeconds = DelaySeconds;
+
+	return true;
+}
+
+void FGoogleOAuthHttpSession::ScheduleRetry(
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, float DelaySeconds)
+{
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakLifetime = Lifetime;
+
+	FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+		[this, WeakLifetime, Request](float DeltaTime)
+		{
+			if (WeakLifetime.IsValid())
+			{
+				Submit(Request);
+			}
+
+			return false;
+		}), DelaySeconds);
+}
@@ -0,0 +1,146 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Interfaces/IHttpRequest.h"
+
+/**
+* HTTP session the requests of `FGoogleDesktopOAuth` go through
+*
+* The HTTP module keeps finished connections alive and hands them to the
+* following requests to the same host, but every request which is started
+* while all of them are busy opens a new connection and pays for a new TLS
+* handshake. The session caps the number of requests in flight and queues
+* the rest, so a burst of calls is served by at most `MaxConnections` warm
+* connections instead of a handshake per call
+*
+* Transient failures are retried according to `FRetryPolicy` before the
+* callback sees them
+*
+* Is thread-safe. Completion callbacks are called on the game thread the same
+* way the HTTP module calls them
+*
+* Uses `LogGoogleDesktopOAuth` log category
+*/
+class FGoogleOAuthHttpSession
+{
+public:
+	//Type of callback function used when returning from an HTTP request
+	using CompletionCallbackType = TFunction<void(FHttpRequestPtr Request,
+		FHttpResponsePtr Response, bool bWasSuccessful)>;
+
+	/**
+	* How transient failures are retried
+	*
+	* Only connection errors, `5xx` and `429` responses are transient. Any
+	* other `4xx` response (including `invalid_grant`) is final and is never
+	* retried. The delay before the retry number `N` (counting from `0`) is
+	* `InitialDelaySeconds * BackoffMultiplier ^ N` capped by
+	* `MaxDelaySeconds`, a random half of which is subtracted so that many
+	* clients failing at once don't retry at once. `Retry-After` of the
+	* response is waited for if it's longer
+	*/
+	struct FRetryPolicy
+	{
+		//How many times a request is retried, `0` disables the retries
+		int32 MaxRetries = 3;
+
+		float InitialDelaySeconds = 0.5f;
+
+		float BackoffMultiplier = 2.0f;
+
+		float MaxDelaySeconds = 8.0f;
+
+		//The failure is reported at once if `Retry-After` asks to wait
+		//longer than that
+		float MaxRetryAfterSeconds = 30.0f;
+	};
+
+	/**
+	* @param MaxConnections How many requests may be in flight at once, that
+	* is how many connections the session keeps open
+	*/
+	explicit FGoogleOAuthHttpSession(
+		int32 MaxConnections = kDefaultMaxConnections);
+
+	/**
+	* Queued requests and requests waiting for a retry are dropped. Requests
+	* in flight aren't cancelled, but their completion is ignored, so no
+	* callback is called after the session is gone
+	*/
+	~FGoogleOAuthHttpSession();
+
+	/**
+	* Creates a request which is to be passed to `ProcessRequest()`
+	*
+	* @return The request
+	*/
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateRequest() const;
+
+	/**
+	* Starts a request or queues it if `MaxConnections` requests are already
+	* in flight. Queued requests are started in the order they were queued
+	*
+	* The completion delegate of the request is overwritten. The callback
+	* isn't called if the session is destroyed before the request returns
+	*
+	* @param Request The request
+	* @param Callback Callback to be called when the request returns and
+	* isn't going to be retried
+	*/
+	void ProcessRequest(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request,
+		CompletionCallbackType Callback);
+
+	/**
+	* Replaces the retry policy, affects the requests which fail afterwards
+	*
+	* @param Policy The policy
+	*/
+	void SetRetryPolicy(const FRetryPolicy& Policy);
+
+	/**
+	* @return Count of the requests which are in flight
+	*/
+	int32 GetNumberOfRequestsInFlight() const;
+
+	//Is enough for a refresh, a check and a key request of a few accounts
+	//at once
+	static constexpr int32 kDefaultMaxConnections = 4;
+
+private:
+	//Starts a request with a bound completion delegate or queues it
+	void Submit(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request);
+
+	//Starts the next queued request on the released connection
+	void HandleRequestCompletion();
+
+	/**
+	* Decides whether a failed request is retried
+	*
+	* @param NumberOfRetries How many times the request has been retried
+	* @param OutDelaySeconds How long to wait before the retry
+	* @return `true` if the request is to be retried
+	*/
+	bool ShouldRetry(FHttpRequestPtr Request, FHttpResponsePtr Response,
+		int32 NumberOfRetries, float& OutDelaySeconds) const;
+
+	void ScheduleRetry(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request,
+		float DelaySeconds);
+
+	const int32 MaxConnections;
+
+	mutable FCriticalSection CriticalSection;
+
+	FRetryPolicy RetryPolicy;
+
+	int32 NumberOfRequestsInFlight = 0;
+
+	TQueue<FHttpRequestPtr> QueuedRequests;
+
+	//Is watched by the completions of the requests and by the scheduled
+	//retries, which do nothing once the session is gone
+	TSharedPtr<bool, ESPMode::ThreadSafe> Lifetime =
+		MakeShared<bool, ESPMode::ThreadSafe>(true);
+};
@@ -0,0 +1,175 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "GoogleOAuthHttpSession.h"
+#include "GoogleOAuthMockServer.h"
+
+namespace
+{
+	//Loopback port the mock server listens on
+	constexpr uint32 kMockServerPort = 18464;
+
+	//Size of the burst of refresh requests, e.g. every account of a
+	//service refreshing at startup
+	constexpr int32 kNumberOfRequests = 64;
+
+	const TCHAR* const kRefreshToken = TEXT("valid-refresh-token");
+
+	/**
+	* State of one burst of requests
+	*/
+	struct FBurst
+	{
+		FString Name;
+
+		int32 NumberOfCompletedRequests = 0;
+
+		int32 NumberOfFailedRequests = 0;
+
+		int32 NumberOfConnectionsBefore = 0;
+
+		double StartTime = 0.0;
+
+		TArray<double> Latencies;
+
+		FDoneDelegate Done;
+	};
+}
+
+/**
+* Compares a burst of refresh requests sent the way `FGoogleDesktopOAuth`
+* used to send them (a request per call, all in flight at once) with the
+* same burst sent through `FGoogleOAuthHttpSession`
+*
+* There is no TLS stand-in, the mock server speaks plain HTTP, so a new
+* connection costs a TCP handshake on the loopback only. The count of
+* opened connections is reported as well: with TLS each of them is a full
+* handshake round trip to Google
+*/
+BEGIN_DEFINE_SPEC(FGoogleOAuthHttpSessionBenchmarkSpec,
+	"GoogleOAuth.Benchmark.HttpSession",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FGoogleOAuthMockServer> Server;
+
+TUniquePtr<FGoogleOAuthHttpSession> Session;
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateRefreshRequest(
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request)
+{
+	Request->SetVerb(TEXT("POST"));
+	Request->SetHeader(TEXT("Content-Type"),
+		TEXT("application/x-www-form-urlencoded"));
+	Request->SetURL(Server->GetEndpoints().RefreshTokenUrl);
+	Request->SetContentAsString(FString::Printf(TEXT("client_id=client-id&"
+		"client_secret=client-secret&grant_type=refresh_token&"
+		"refresh_token=%s"), kRefreshToken));
+
+	return Request;
+}
+
+TSharedRef<FBurst> StartBurst(FString Name, const FDoneDelegate& Done)
+{
+	TSharedRef<FBurst> Burst = MakeShared<FBurst>();
+	Burst->Name = MoveTemp(Name);
+	Burst->Done = Done;
+	Burst->Latencies.Reserve(kNumberOfRequests);
+	Burst->NumberOfConnectionsBefore = Server->GetNumberOfConnections();
+	Burst->StartTime = FPlatformTime::Seconds();
+
+	return Burst;
+}
+
+TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)> MakeCompletion(
+	TSharedRef<FBurst> Burst)
+{
+	double IssueTime = FPlatformTime::Seconds();
+
+	return [this, Burst, IssueTime](FHttpRequestPtr Request,
+		FHttpResponsePtr Response, bool bWasSuccessful)
+	{
+		Burst->Latencies.Add(FPlatformTime::Seconds() - IssueTime);
+		if (!bWasSuccessful || !Response.IsValid() ||
+			Response->GetResponseCode() != 200)
+		{
+			Burst->NumberOfFailedRequests++;
+		}
+
+		if (++Burst->NumberOfCompletedRequests == kNumberOfRequests)
+		{
+			Report(*Burst);
+		}
+	};
+}
+
+void Report(FBurst& Burst)
+{
+	double ElapsedTime = FPlatformTime::Seconds() - Burst.StartTime;
+	Burst.Latencies.Sort();
+
+	AddInfo(FString::Printf(TEXT("%s: %d requests in %.2f ms, latency p50"
+		" %.2f ms, max %.2f ms, %d new connections"), *Burst.Name,
+		kNumberOfRequests, ElapsedTime * 1000.0,
+		Burst.Latencies[Burst.Latencies.Num() / 2] * 1000.0,
+		Burst.Latencies.Last() * 1000.0,
+		Server->GetNumberOfConnections() - Burst.NumberOfConnectionsBefore));
+
+	TestEqual(FString::Printf(TEXT("%s: expecting every request to"
+		" succeed"), *Burst.Name), Burst.NumberOfFailedRequests, 0);
+
+	Burst.Done.Execute();
+}
+
+END_DEFINE_SPEC(FGoogleOAuthHttpSessionBenchmarkSpec)
+
+void FGoogleOAuthHttpSessionBenchmarkSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Server = MakeUnique<FGoogleOAuthMockServer>(kMockServerPort);
+		Server->AddRefreshToken(kRefreshToken);
+		TestTrue("Expecting the mock server to start", Server->Start());
+
+		Session = MakeUnique<FGoogleOAuthHttpSession>();
+	});
+
+	AfterEach([this]()
+	{
+		Session.Reset();
+		Server.Reset();
+	});
+
+	LatentIt("A request per call", FTimespan::FromSeconds(60),
+		[this](const FDoneDelegate& Done)
+		{
+			TSharedRef<FBurst> Burst = StartBurst("A request per call", Done);
+			for (int32 i = 0; i < kNumberOfRequests; i++)
+			{
+				auto Request =
+					CreateRefreshRequest(FHttpModule::Get().CreateRequest());
+				Request->OnProcessRequestComplete().BindLambda(
+					MakeCompletion(Burst));
+				Request->ProcessRequest();
+			}
+		});
+
+	LatentIt("Session", FTimespan::FromSeconds(60),
+		[this](const FDoneDelegate& Done)
+		{
+			TSharedRef<FBurst> Burst = StartBurst(FString::Printf(
+				TEXT("Session of %d connections"),
+				FGoogleOAuthHttpSession::kDefaultMaxConnections), Done);
+			for (int32 i = 0; i < kNumberOfRequests; i++)
+			{
+				Session->ProcessRequest(
+					CreateRefreshRequest(Session->CreateRequest()),
+					MakeCompletion(Burst));
+			}
+		});
+}
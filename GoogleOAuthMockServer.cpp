@@ -0,0 +1,471 @@
+//Flying Wild Hog. All rights reserved
+
+#include "GoogleOAuthMockServer.h"
+#include "GoogleDesktopOAuthLog.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Containers/Ticker.h"
+#include "IPAddress.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Misc/Base64.h"
+#include "Algo/Reverse.h"
+#include "RSA.h"
+#include "PlatformCryptoTypes.h"
+#include "IPlatformCrypto.h"
+
+namespace
+{
+	const TCHAR* const kTokenPath = TEXT("/token");
+
+	const TCHAR* const kUserInfoPath = TEXT("/userinfo");
+
+	const TCHAR* const kCertsPath = TEXT("/certs");
+
+	//RSA-2048 key the ID tokens are signed with, its numbers are base64url
+	//big-endian as in a JWK. It's made for the tests and is public on
+	//purpose, never sign anything else with it
+	const TCHAR* const kSigningKeyModulus = TEXT(
+		"t98EuHG7QYuozmDlAvZPSpfDyTi6uakQwUFmG5vaXbYmeiANVKb4bFKJb5FGR0tf"
+		"qL5HxLa2QZ3dY5EttcFxA2GeeICThQOAtLQwVG1h_MfmhnAnHDfH7uq1OGF_xXlT"
+		"9igmGe_ZVc0OJ9Lu7mk5zSmLm7GPKL_XXf1W6VKbXuE89UaloLa2ITODC0eTXUmj"
+		"H2SSvxLr_9KjhST1KcBMGgfaBCJTqLk37jLfuSHhy6FjK4ZDExqRq-AXM3xjjsS0"
+		"wBNJn6y8wQjrLGa5I1CXpOci-34vCa7IWuMCHh2PHK_xrv__JBzMtUwQ6xVEW3oA"
+		"7i59Xdv0OrI-i9JDPQdrwQ");
+
+	const TCHAR* const kSigningKeyPrivateExponent = TEXT(
+		"L7ICH3YhBNedaitoPGR4HPlRKBk3FoHsfrTgL7k146kkQfmee570QeUHEZG1kTjU"
+		"D4mMRFLA5DR3ASTfno4XKrFf0hJIMfC-qiEziDL3gAK6oZTmEEPH8QmhCIcCBc97"
+		"IBc6CvBUiBUw3tOwdteEzttAA5sDb6aTzyWwLcXn16xU46wxup1-g7u2GyYIVrue"
+		"zpzyXEd2kHVHPZA_yhizMKjTguth7LcSQ6i3FtQsTXfTm88x7GjyuDdXELxaPCrm"
+		"vkviY1ZpeLG22ddGTdR9WlAFaeL1iATPuiiVenwFUkkCx5uBY5iA3GZFTiUz_ZhT"
+		"aU6U8ZeZq7A7J9QFpemvoQ");
+
+	const TCHAR* const kSigningKeyPublicExponent = TEXT("AQAB");
+
+	//DER prefix of PKCS#1 v1.5 `DigestInfo` of a SHA-256 hash
+	const uint8 kSha256DigestInfoPrefix[] = {
+		0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65,
+		0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+	};
+
+	FString EncodeBase64Url(const uint8* Data, int32 Size)
+	{
+		FString Result = FBase64::Encode(Data, Size);
+		Result.ReplaceCharInline(TEXT('+'), TEXT('-'));
+		Result.ReplaceCharInline(TEXT('/'), TEXT('_'));
+		while (Result.EndsWith(TEXT("=")))
+		{
+			Result.LeftChopInline(1);
+		}
+
+		return Result;
+	}
+
+	FString EncodeBase64Url(const FString& Text)
+	{
+		FTCHARToUTF8 Utf8(*Text);
+
+		return EncodeBase64Url(reinterpret_cast<const uint8*>(Utf8.Get()),
+			Utf8.Length());
+	}
+
+	//Decodes a number of the signing key into the little-endian order
+	//`FRSA` takes
+	TArray<uint8> DecodeKeyNumber(FString Number)
+	{
+		Number.ReplaceCharInline(TEXT('-'), TEXT('+'));
+		Number.ReplaceCharInline(TEXT('_'), TEXT('/'));
+		while (Number.Len() % 4 != 0)
+		{
+			Number.AppendChar(TEXT('='));
+		}
+
+		TArray<uint8> Result;
+		FBase64::Decode(Number, Result);
+		Algo::Reverse(Result);
+
+		return Result;
+	}
+
+	//Parses `application/x-www-form-urlencoded` body
+	TMap<FString, FString> ParseUrlEncodedBody(const TArray<uint8>& Body)
+	{
+		FUTF8ToTCHAR Converter(
+			reinterpret_cast<const ANSICHAR*>(Body.GetData()), Body.Num());
+		FString Content(Converter.Length(), Converter.Get());
+
+		TArray<FString> Pairs;
+		Content.ParseIntoArray(Pairs, TEXT("&"));
+
+		TMap<FString, FString> Params;
+		for (const FString& Pair : Pairs)
+		{
+			FString Key;
+			FString Value;
+			if (Pair.Split(TEXT("="), &Key, &Value))
+			{
+				Params.Add(FGenericPlatformHttp::UrlDecode(Key),
+					FGenericPlatformHttp::UrlDecode(Value));
+			}
+		}
+
+		return Params;
+	}
+}
+
+FGoogleOAuthMockServer::FGoogleOAuthMockServer(uint32 Port)
+	: Port(Port) {}
+
+FGoogleOAuthMockServer::~FGoogleOAuthMockServer()
+{
+	Stop();
+}
+
+bool FGoogleOAuthMockServer::Start()
+{
+	if (!FHttpServerModule::IsAvailable())
+	{
+		FModuleManager::LoadModuleChecked<FHttpServerModule>("HTTPServer");
+	}
+
+	if (!FHttpServerModule::IsAvailable())
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The HTTP server module cannot be loaded. Unable to start"
+				 " the mock server"));
+
+		return false;
+	}
+
+	FHttpServerModule& HttpServer = FHttpServerModule::Get();
+	Router = HttpServer.GetHttpRouter(Port);
+	if (!Router.IsValid())
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("Unable to listen on port %u"), Port);
+
+		return false;
+	}
+
+	RouteHandles.Add(Router->BindRoute(FHttpPath(kTokenPath),
+		EHttpServerRequestVerbs::VERB_POST,
+		[this](const FHttpServerRequest& Request,
+			const FHttpResultCallback& OnComplete)
+		{
+			return HandleToken(Request, OnComplete);
+		}));
+	RouteHandles.Add(Router->BindRoute(FHttpPath(kUserInfoPath),
+		EHttpServerRequestVerbs::VERB_GET,
+		[this](const FHttpServerRequest& Request,
+			const FHttpResultCallback& OnComplete)
+		{
+			return HandleUserInfo(Request, OnComplete);
+		}));
+	RouteHandles.Add(Router->BindRoute(FHttpPath(kCertsPath),
+		EHttpServerRequestVerbs::VERB_GET,
+		[this](const FHttpServerRequest& Request,
+			const FHttpResultCallback& OnComplete)
+		{
+			return HandleCerts(Request, OnComplete);
+		}));
+
+	HttpServer.StartAllListeners();
+
+	return true;
+}
+
+void FGoogleOAuthMockServer::Stop()
+{
+	if (Router.IsValid())
+	{
+		for (const FHttpRouteHandle& RouteHandle : RouteHandles)
+		{
+			Router->UnbindRoute(RouteHandle);
+		}
+	}
+
+	RouteHandles.Reset();
+	Router.Reset();
+}
+
+FGoogleDesktopOAuth::FEndpoints FGoogleOAuthMockServer::GetEndpoints() const
+{
+	FString Base = FString::Printf(TEXT("http://127.0.0.1:%u"), Port);
+
+	FGoogleDesktopOAuth::FEndpoints Endpoints;
+	Endpoints.RefreshTokenUrl = Base + kTokenPath;
+	Endpoints.CodeExchangeUrl = Base + kTokenPath;
+	Endpoints.UserInfoUrlBase = Base + kUserInfoPath +
+		TEXT("?access_token=");
+	Endpoints.JwksUrl = Base + kCertsPath;
+	// there is no consent page, the browser would just show an error
+	Endpoints.ManualAuthenticationUrlBase = Base + TEXT("/auth?");
+
+	return Endpoints;
+}
+
+void FGoogleOAuthMockServer::AddRefreshToken(const FString& RefreshToken)
+{
+	RefreshTokens.Add(RefreshToken);
+}
+
+void FGoogleOAuthMockServer::RevokeRefreshToken(const FString& RefreshToken)
+{
+	RefreshTokens.Remove(RefreshToken);
+}
+
+void FGoogleOAuthMockServer::AddAuthorizationCode(const FString& Code)
+{
+	AuthorizationCodes.Add(Code);
+}
+
+FString FGoogleOAuthMockServer::IssueAccessToken()
+{
+	// the real tokens are much longer, the length matters for the parsing
+	FString AccessToken = FString::Printf(TEXT("ya29.mock-%08d-%s"),
+		NextAccessTokenNumber++,
+		*FGuid::NewGuid().ToString(EGuidFormats::Base36Encoded));
+	AccessTokens.Add(AccessToken);
+
+	return AccessToken;
+}
+
+FString FGoogleOAuthMockServer::IssueIdToken(const FString& ClientId,
+	int64 LifetimeSeconds) const
+{
+	int64 Now = FDateTime::UtcNow().ToUnixTimestamp();
+	FString SigningInput = EncodeBase64Url(FString::Printf(
+		TEXT("{\"alg\": \"RS256\", \"kid\": \"%s\", \"typ\": \"JWT\"}"),
+		kSigningKeyId)) + TEXT(".") + EncodeBase64Url(FString::Printf(
+		TEXT("{\"iss\": \"https://accounts.google.com\", \"aud\": \"%s\","
+			 " \"sub\": \"100000000000000000000\", \"iat\": %lld,"
+			 " \"exp\": %lld}"), *ClientId, Now, Now + LifetimeSeconds));
+
+	// the signature is PKCS#1 v1.5 over SHA-256 of `header.payload`
+	FTCHARToUTF8 Utf8(*SigningInput);
+	FSHA256Signature Hash;
+	TUniquePtr<FEncryptionContext> EncryptionContext =
+		IPlatformCrypto::Get().CreateContext();
+	if (!EncryptionContext->CalcSHA256(TArrayView<const uint8>(
+		reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), Hash))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("Unable to hash the ID token"));
+
+		return FString();
+	}
+
+	TArray<uint8> DigestInfo(kSha256DigestInfoPrefix,
+		UE_ARRAY_COUNT(kSha256DigestInfoPrefix));
+	DigestInfo.Append(Hash.Signature, UE_ARRAY_COUNT(Hash.Signature));
+
+	TArray<uint8> Signature;
+	FRSA::TKeyPtr Key = FRSA::CreateKey(
+		DecodeKeyNumber(kSigningKeyPublicExponent),
+		DecodeKeyNumber(kSigningKeyPrivateExponent),
+		DecodeKeyNumber(kSigningKeyModulus));
+	int32 SignatureSize = Key ?
+		FRSA::EncryptPrivate(DigestInfo, Signature, Key) : -1;
+	if (Key)
+	{
+		FRSA::FreeKey(Key);
+	}
+
+	if (SignatureSize <= 0)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("Unable to sign the ID token"));
+
+		return FString();
+	}
+
+	return SigningInput + TEXT(".") +
+		EncodeBase64Url(Signature.GetData(), Signature.Num());
+}
+
+void FGoogleOAuthMockServer::FailTokenRequests(int32 NumberOfFailures,
+	EHttpServerResponseCodes Code, FString RetryAfter)
+{
+	NumberOfTokenFailures = NumberOfFailures;
+	TokenFailureCode = Code;
+	TokenFailureRetryAfter = MoveTemp(RetryAfter);
+}
+
+void FGoogleOAuthMockServer::SetResponseDelay(float Seconds)
+{
+	ResponseDelay = Seconds;
+}
+
+int32 FGoogleOAuthMockServer::GetNumberOfRequests() const
+{
+	return NumberOfRequests;
+}
+
+int32 FGoogleOAuthMockServer::GetNumberOfConnections() const
+{
+	return Peers.Num();
+}
+
+void FGoogleOAuthMockServer::CountRequest(const FHttpServerRequest& Request)
+{
+	NumberOfRequests++;
+
+	// every connection comes from its own ephemeral port
+	if (Request.PeerAddress.IsValid())
+	{
+		Peers.Add(Request.PeerAddress->ToString(true));
+	}
+}
+
+bool FGoogleOAuthMockServer::HandleToken(const FHttpServerRequest& Request,
+	const FHttpResultCallback& OnComplete)
+{
+	CountRequest(Request);
+
+	if (NumberOfTokenFailures > 0)
+	{
+		NumberOfTokenFailures--;
+
+		TMap<FString, FString> Headers;
+		if (!TokenFailureRetryAfter.IsEmpty())
+		{
+			Headers.Add(TEXT("Retry-After"), TokenFailureRetryAfter);
+		}
+
+		Answer(OnComplete, TokenFailureCode,
+			TEXT("{\"error\": \"temporarily_unavailable\","
+				 " \"error_description\": \"Try again later\"}"),
+			MoveTemp(Headers));
+
+		return true;
+	}
+
+	TMap<FString, FString> Params = ParseUrlEncodedBody(Request.Body);
+	const FString* GrantType = Params.Find(TEXT("grant_type"));
+
+	if (GrantType && *GrantType == TEXT("refresh_token"))
+	{
+		const FString* RefreshToken = Params.Find(TEXT("refresh_token"));
+		if (!RefreshToken || !RefreshTokens.Contains(*RefreshToken))
+		{
+			AnswerInvalidGrant(OnComplete);
+
+			return true;
+		}
+
+		Answer(OnComplete, EHttpServerResponseCodes::Ok, FString::Printf(
+			TEXT("{\"access_token\": \"%s\", \"expires_in\": %lld,"
+				 " \"token_type\": \"Bearer\"}"), *IssueAccessToken(),
+			kAccessTokenLifetimeSeconds));
+	}
+	else if (GrantType && *GrantType == TEXT("authorization_code"))
+	{
+		const FString* Code = Params.Find(TEXT("code"));
+		if (!Code || AuthorizationCodes.Remove(*Code) == 0)
+		{
+			AnswerInvalidGrant(OnComplete);
+
+			return true;
+		}
+
+		// the issued refresh token is immediately usable
+		FString RefreshToken = FString::Printf(TEXT("1//mock-%s"),
+			*FGuid::NewGuid().ToString(EGuidFormats::Base36Encoded));
+		RefreshTokens.Add(RefreshToken);
+
+		Answer(OnComplete, EHttpServerResponseCodes::Ok, FString::Printf(
+			TEXT("{\"access_token\": \"%s\", \"expires_in\": %lld,"
+				 " \"refresh_token\": \"%s\", \"token_type\": \"Bearer\"}"),
+			*IssueAccessToken(), kAccessTokenLifetimeSeconds,
+			*RefreshToken));
+	}
+	else
+	{
+		Answer(OnComplete, EHttpServerResponseCodes::BadRequest,
+			TEXT("{\"error\": \"unsupported_grant_type\","
+				 " \"error_description\": \"Invalid grant_type\"}"));
+	}
+
+	return true;
+}
+
+bool FGoogleOAuthMockServer::HandleUserInfo(const FHttpServerRequest& Request,
+	const FHttpResultCallback& OnComplete)
+{
+	CountRequest(Request);
+
+	const FString* AccessToken = Request.QueryParams.Find(
+		TEXT("access_token"));
+	if (!AccessToken || !AccessTokens.Contains(*AccessToken))
+	{
+		Answer(OnComplete, EHttpServerResponseCodes::Denied,
+			TEXT("{\"error\": \"invalid_request\","
+				 " \"error_description\": \"Invalid Credentials\"}"));
+
+		return true;
+	}
+
+	Answer(OnComplete, EHttpServerResponseCodes::Ok,
+		TEXT("{\"sub\": \"100000000000000000000\"}"));
+
+	return true;
+}
+
+bool FGoogleOAuthMockServer::HandleCerts(const FHttpServerRequest& Request,
+	const FHttpResultCallback& OnComplete)
+{
+	CountRequest(Request);
+
+	Answer(OnComplete, EHttpServerResponseCodes::Ok,
+		FString::Printf(TEXT("{\"keys\": [{\"kty\": \"RSA\", \"alg\":"
+			" \"RS256\", \"use\": \"sig\", \"kid\": \"%s\", \"n\": \"%s\","
+			" \"e\": \"%s\"}]}"), kSigningKeyId, kSigningKeyModulus,
+			kSigningKeyPublicExponent),
+		{ { TEXT("Cache-Control"), TEXT("public, max-age=3600") } });
+
+	return true;
+}
+
+void FGoogleOAuthMockServer::Answer(const FHttpResultCallback& OnComplete,
+	EHttpServerResponseCodes Code, FString Body,
+	TMap<FString, FString> Headers)
+{
+	// doesn't capture `this`, so a delayed answer outlives the server safely
+	auto Send = [OnComplete, Code, Body = MoveTemp(Body),
+		Headers = MoveTemp(Headers)]()
+	{
+		TUniquePtr<FHttpServerResponse> Response =
+			FHttpServerResponse::Create(Body, TEXT("application/json"));
+		Response->Code = Code;
+		for (const TPair<FString, FString>& Header : Headers)
+		{
+			Response->Headers.Add(Header.Key, { Header.Value });
+		}
+
+		OnComplete(MoveTemp(Response));
+	};
+
+	if (ResponseDelay <= 0.0f)
+	{
+		Send();
+		return;
+	}
+
+	FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+		[Send = MoveTemp(Send)](float DeltaTime)
+		{
+			Send();
+
+			return false;
+		}), ResponseDelay);
+}
+
+void FGoogleOAuthMockServer::AnswerInvalidGrant(
+	const FHttpResultCallback& OnComplete)
+{
+	Answer(OnComplete, EHttpServerResponseCodes::BadRequest,
+		TEXT("{\"error\": \"invalid_grant\", \"error_description\":"
+			 " \"Token has been expired or revoked.\"}"));
+}
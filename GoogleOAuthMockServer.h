@@ -0,0 +1,195 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+#include "HttpServerConstants.h"
+#include "GoogleDesktopOAuth.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+struct FHttpServerResponse;
+
+/**
+* Local stand-in for the Google OAuth endpoints, is served by UE4's HTTP
+* Server module on the loopback interface
+*
+* Implements the subset of the endpoints `FGoogleDesktopOAuth` talks to:
+* - `POST /token` - refreshes tokens and exchanges authorization codes.
+* Unknown or revoked refresh tokens and unknown codes are answered with
+* `invalid_grant` the same way Google does
+* - `GET /userinfo?access_token=` - answers `200` for the access tokens
+* issued by the server and `401` for any other
+* - `GET /certs` - answers with the key the ID tokens issued by
+* `IssueIdToken()` are signed with
+*
+* Pass `GetEndpoints()` to `FGoogleDesktopOAuth` to have it talk to the
+* server. Must be used on the game thread only, the requests are served
+* there as well
+*
+* Uses `LogGoogleDesktopOAuth` log category
+*/
+class FGoogleOAuthMockServer
+{
+public:
+	/**
+	* @param Port Loopback port to listen on
+	*/
+	explicit FGoogleOAuthMockServer(uint32 Port);
+
+	~FGoogleOAuthMockServer();
+
+	/**
+	* Binds the routes and starts listening
+	*
+	* @return `true` if the server is listening, `false` - if the HTTP Server
+	* module couldn't be loaded or the port is taken
+	*/
+	bool Start();
+
+	/**
+	* Unbinds the routes. Note that the HTTP Server module doesn't allow to
+	* stop a single listener, so the port stays taken until the module stops
+	* all of them
+	*/
+	void Stop();
+
+	/**
+	* Returns the endpoints which point to this server
+	*
+	* @return The endpoints to pass to `FGoogleDesktopOAuth`
+	*/
+	FGoogleDesktopOAuth::FEndpoints GetEndpoints() const;
+
+	/**
+	* Makes a refresh token known, refreshing it succeeds until it's revoked
+	*
+	* @param RefreshToken The token
+	*/
+	void AddRefreshToken(const FString& RefreshToken);
+
+	/**
+	* Revokes a refresh token, refreshing it fails with `invalid_grant`
+	*
+	* @param RefreshToken The token
+	*/
+	void RevokeRefreshToken(const FString& RefreshToken);
+
+	/**
+	* Makes an authorization code known, it can be exchanged once
+	*
+	* @param Code The code
+	*/
+	void AddAuthorizationCode(const FString& Code);
+
+	/**
+	* Issues an access token without any request, as if it was refreshed
+	*
+	* @return The token, is valid for `kAccessTokenLifetimeSeconds`
+	*/
+	FString IssueAccessToken();
+
+	/**
+	* Issues an ID token signed with the key the server publishes, without
+	* any request
+	*
+	* @param ClientId Client ID the token is issued for, is its `aud`
+	* @param LifetimeSeconds How long the token is valid, a negative value
+	* issues an expired token
+	* @return The token or an empty string if it couldn't be signed
+	*/
+	FString IssueIdToken(const FString& ClientId,
+		int64 LifetimeSeconds = kAccessTokenLifetimeSeconds) const;
+
+	/**
+	* Makes the next requests to `/token` fail without looking at them, to
+	* imitate throttling or an outage of Google
+	*
+	* @param NumberOfFailures How many requests fail
+	* @param Code Status of the failed responses, e.g. `429` or `503`
+	* @param RetryAfter Value of the `Retry-After` header of the failed
+	* responses, the header isn't sent if it's empty
+	*/
+	void FailTokenRequests(int32 NumberOfFailures,
+		EHttpServerResponseCodes Code, FString RetryAfter = FString());
+
+	/**
+	* Delays every response, to imitate the round trip to Google
+	*
+	* @param Seconds The delay, `0` answers within the same tick
+	*/
+	void SetResponseDelay(float Seconds);
+
+	/**
+	* Returns count of the requests served since the server was created
+	*
+	* @return Count of the requests
+	*/
+	int32 GetNumberOfRequests() const;
+
+	/**
+	* Returns count of the distinct connections the requests came through,
+	* tells how well the client reuses connections
+	*
+	* @return Count of the connections
+	*/
+	int32 GetNumberOfConnections() const;
+
+	//Lifetime of the issued access tokens, reported as `expires_in`
+	static constexpr int64 kAccessTokenLifetimeSeconds = 3599;
+
+	//`kid` of the key the ID tokens are signed with
+	static constexpr const TCHAR* kSigningKeyId = TEXT("mock-signing-key");
+
+private:
+	void CountRequest(const FHttpServerRequest& Request);
+
+	bool HandleToken(const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete);
+
+	bool HandleUserInfo(const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete);
+
+	bool HandleCerts(const FHttpServerRequest& Request,
+		const FHttpResultCallback& OnComplete);
+
+	//Answers with a JSON body, after `ResponseDelay` if it's set
+	void Answer(const FHttpResultCallback& OnComplete,
+		EHttpServerResponseCodes Code, FString Body,
+		TMap<FString, FString> Headers = TMap<FString, FString>());
+
+	//Answers with Google's `invalid_grant` error
+	void AnswerInvalidGrant(const FHttpResultCallback& OnComplete);
+
+	uint32 Port;
+
+	TSharedPtr<IHttpRouter> Router;
+
+	TArray<FHttpRouteHandle> RouteHandles;
+
+	TSet<FString> RefreshTokens;
+
+	TSet<FString> AuthorizationCodes;
+
+	TSet<FString> AccessTokens;
+
+	//Number the next issued access token gets
+	int32 NextAccessTokenNumber = 1;
+
+	float ResponseDelay = 0.0f;
+
+	//How many of the next `/token` requests fail, see `FailTokenRequests()`
+	int32 NumberOfTokenFailures = 0;
+
+	EHttpServerResponseCodes TokenFailureCode =
+		EHttpServerResponseCodes::ServiceUnavail;
+
+	FString TokenFailureRetryAfter;
+
+	int32 NumberOfRequests = 0;
+
+	//Addresses and ports of the peers the requests came from
+	TSet<FString> Peers;
+};
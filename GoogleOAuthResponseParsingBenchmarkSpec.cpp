@@ -0,0 +1,194 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "AllocationCounter.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Utf8JsonFieldReader.h"
+
+namespace
+{
+	using FMeasurement = FAllocationCounter::FMeasurement;
+
+	//Shapes of the responses of the token endpoint, the tokens are
+	//of the real length
+	const ANSICHAR* const kCodeExchangeResponse =
+		"{\n"
+		"  \"access_token\": \"ya29.a0AfH6SMBx3t7Jq0mZC1cA2Vq8Xr5bN4Ld9Ke7Hs2"
+		"Tg6Wf1Ye3Uj0Ri8Po5Ia4Sd7Fg2Hj9Kl1Zx6Cv3Bn8Mq0We5Rt2Yu7Io4Pa1Sd6Fg3Hj"
+		"8Kl0Zx5Cv2Bn7Mq9We4Rt1Yu6Io3Pa0Sd5Fg2Hj7Kl9Zx4Cv1Bn6Mq8We3Rt0Yu5Io2"
+		"Pa9Sd4Fg1Hj6Kl8Zx3Cv0Bn5Mq7We2Rt9Yu4Io1Pa8Sd3Fg0Hj5Kl7Zx2\",\n"
+		"  \"expires_in\": 3599,\n"
+		"  \"refresh_token\": \"1//0gLx4Yp2Qw8Er6Ty3Ui1Op9As7Df5Gh3Jk1Lz9Xc7Vb"
+		"5Nm3Qw1Er9Ty7Ui5Op3As1Df9Gh7Jk5Lz3Xc1Vb9Nm7Qw5Er3Ty1Ui9Op7As5Df3Gh1\",\n"
+		"  \"scope\": \"https://www.googleapis.com/auth/spreadsheets"
+		" https://www.googleapis.com/auth/drive.readonly\",\n"
+		"  \"token_type\": \"Bearer\"\n"
+		"}";
+
+	const ANSICHAR* const kRefreshResponse =
+		"{\n"
+		"  \"access_token\": \"ya29.a0AfH6SMCq8Wn2Ek5Rt7Yp0Ui3Oa6Sd9Fg1Hj4Kl7"
+		"Zx0Cv3Bn6Mq9We2Rt5Yu8Io1Pa4Sd7Fg0Hj3Kl6Zx9Cv2Bn5Mq8We1Rt4Yu7Io0Pa3Sd"
+		"6Fg9Hj2Kl5Zx8Cv1Bn4Mq7We0Rt3Yu6Io9Pa2Sd5Fg8Hj1Kl4Zx7Cv0Bn3Mq6We9Rt2"
+		"Yu5Io8Pa1Sd4Fg7Hj0Kl3Zx6Cv9Bn2Mq5We8Rt1Yu4Io7Pa0Sd3Fg6Hj9Kl2\",\n"
+		"  \"expires_in\": 3599,\n"
+		"  \"scope\": \"https://www.googleapis.com/auth/spreadsheets\",\n"
+		"  \"token_type\": \"Bearer\"\n"
+		"}";
+
+	const ANSICHAR* const kInvalidGrantResponse =
+		"{\n"
+		"  \"error\": \"invalid_grant\",\n"
+		"  \"error_description\": \"Token has been expired or revoked.\"\n"
+		"}";
+
+	TArray<uint8> ToBody(const ANSICHAR* Response)
+	{
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Response),
+			FCStringAnsi::Strlen(Response));
+	}
+
+	constexpr int32 kNumberOfCalls = 100000;
+}
+
+BEGIN_DEFINE_SPEC(FGoogleOAuthResponseParsingBenchmarkSpec,
+	"GoogleOAuth.Benchmark.ResponseParsing",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+/**
+* Reads the fields the way `FGoogleDesktopOAuth::HandleResultOfRequest()`
+* and its callers used to: the body is widened and parsed into a DOM
+*/
+void ReadThroughDom(const TArray<uint8>& Body,
+	const TArray<const TCHAR*>& Fields, TArray<FString>& OutValues)
+{
+	// that's what `IHttpResponse::GetContentAsString()` does
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Body.GetData()),
+		Body.Num());
+	FString Content(Converter.Length(), Converter.Get());
+
+	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	TSharedRef<TJsonReader<TCHAR>> JsonReader =
+		TJsonReaderFactory<TCHAR>::Create(Content);
+	FJsonSerializer::Deserialize(JsonReader, JsonObject);
+
+	for (int32 i = 0; i < Fields.Num(); i++)
+	{
+		JsonObject->TryGetStringField(Fields[i], OutValues[i]);
+	}
+}
+
+void ReadThroughReader(const TArray<uint8>& Body,
+	const TArray<const TCHAR*>& Fields, TArray<FString>& OutValues)
+{
+	FUtf8JsonFieldReader Reader(Body);
+
+	for (int32 i = 0; i < Fields.Num(); i++)
+	{
+		Reader.TryGetStringField(Fields[i], OutValues[i]);
+	}
+}
+
+void Compare(const FString& Name, const ANSICHAR* Response,
+	TArray<const TCHAR*> Fields)
+{
+	TArray<uint8> Body = ToBody(Response);
+	TArray<FString> DomValues;
+	TArray<FString> ReaderValues;
+	DomValues.SetNum(Fields.Num());
+	ReaderValues.SetNum(Fields.Num());
+
+	FMeasurement Dom = FAllocationCounter::Measure(kNumberOfCalls, [&]()
+	{
+		ReadThroughDom(Body, Fields, DomValues);
+	});
+	FMeasurement Reader = FAllocationCounter::Measure(kNumberOfCalls, [&]()
+	{
+		ReadThroughReader(Body, Fields, ReaderValues);
+	});
+
+	AddInfo(FString::Printf(TEXT("%s: DOM %.1f ns/call, %.2f allocations/call;"
+		" UTF-8 reader %.1f ns/call, %.2f allocations/call"), *Name,
+		Dom.NanosecondsPerCall, Dom.AllocationsPerCall,
+		Reader.NanosecondsPerCall, Reader.AllocationsPerCall));
+
+	for (int32 i = 0; i < Fields.Num(); i++)
+	{
+		TestEqual(FString::Printf(TEXT("Expecting `%s` to be read the same"
+			" way"), Fields[i]), ReaderValues[i], DomValues[i]);
+	}
+}
+
+END_DEFINE_SPEC(FGoogleOAuthResponseParsingBenchmarkSpec)
+
+void FGoogleOAuthResponseParsingBenchmarkSpec::Define()
+{
+	It("Code exchange response",
+		[this]()
+		{
+			Compare("Code exchange", kCodeExchangeResponse,
+				{ TEXT("access_token"), TEXT("refresh_token") });
+
+			FUtf8JsonFieldReader Reader(ToBody(kCodeExchangeResponse));
+			TestEqual("Expecting `expires_in` to be read",
+				Reader.GetIntegerField(TEXT("expires_in")), 3599ll);
+		}
+	);
+
+	It("Token refresh response",
+		[this]()
+		{
+			Compare("Token refresh", kRefreshResponse,
+				{ TEXT("access_token") });
+		}
+	);
+
+	It("invalid_grant response",
+		[this]()
+		{
+			Compare("invalid_grant", kInvalidGrantResponse,
+				{ TEXT("error"), TEXT("error_description") });
+		}
+	);
+
+	It("Duplicate keys",
+		[this]()
+		{
+			//The last field of a name wins, whatever the case of the name
+			Compare("Duplicate keys", "{\"access_token\": \"first\", "
+				"\"expires_in\": 1, \"error\": \"none\", "
+				"\"ACCESS_TOKEN\": \"second\", \"expires_in\": 2, "
+				"\"Access_Token\": \"third\"}",
+				{ TEXT("access_token"), TEXT("error") });
+
+			FUtf8JsonFieldReader Reader(ToBody(
+				"{\"expires_in\": 1, \"Expires_In\": 2}"));
+			TestEqual("Expecting the last `expires_in` to be read",
+				Reader.GetIntegerField(TEXT("expires_in")), 2ll);
+		}
+	);
+
+	It("Escaped and non-ASCII strings",
+		[this]()
+		{
+			TArray<uint8> Body = ToBody(
+				"{\"skip\": {\"a\": [1, \"}\"]}, \"value\": "
+				"\"q\\\"\\u0041\\n\xC5\x82\xF0\x9F\x98\x80\"}");
+			FUtf8JsonFieldReader Reader(Body);
+
+			FString Value;
+			TestTrue("Expecting the field to be found",
+				Reader.TryGetStringField(TEXT("value"), Value));
+			TestEqual("Expecting the value to be unescaped and decoded",
+				Value, FString(TEXT("q\"A\n\x0142")) +
+					FString(UTF8_TO_TCHAR("\xF0\x9F\x98\x80")));
+			TestFalse("Expecting nested fields not to be found",
+				Reader.TryGetStringField(TEXT("a"), Value));
+		}
+	);
+}
@@ -0,0 +1,203 @@
+//Flying Wild Hog. All rights reserved
+
+#include "GoogleTokenManager.h"
+#include "GoogleDesktopOAuthLog.h"
+
+FGoogleTokenManager::FGoogleTokenManager(FGoogleDesktopOAuth& OAuth,
+	FString ClientId, FString ClientSecret, FString RefreshToken,
+	int64 RefreshMarginSeconds)
+		: OAuth(OAuth), ClientId(MoveTemp(ClientId)),
+		  ClientSecret(MoveTemp(ClientSecret)),
+		  RefreshToken(MoveTemp(RefreshToken)),
+		  RefreshMarginSeconds(RefreshMarginSeconds) {}
+
+FGoogleTokenManager::~FGoogleTokenManager()
+{
+	StopBackgroundRefresh();
+}
+
+bool FGoogleTokenManager::TryGetCachedToken(FString& OutToken,
+	int64& OutExpiresOn) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!IsFresh(CachedExpiresOn))
+	{
+		return false;
+	}
+
+	OutToken = CachedToken;
+	OutExpiresOn = CachedExpiresOn;
+
+	return true;
+}
+
+void FGoogleTokenManager::GetToken(TokenCallbackType Callback)
+{
+	FString Token;
+	int64 ExpiresOn = 0;
+	bool bIsCached;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		bIsCached = IsFresh(CachedExpiresOn);
+		if (bIsCached)
+		{
+			Token = CachedToken;
+			ExpiresOn = CachedExpiresOn;
+		}
+		else
+		{
+			PendingCallbacks.Add(MoveTemp(Callback));
+		}
+	}
+
+	if (bIsCached)
+	{
+		Callback(MoveTemp(Token), ExpiresOn, Status::kSuccessCode);
+	}
+	else
+	{
+		RefreshIfNotInFlight();
+	}
+}
+
+void FGoogleTokenManager::SetToken(FString Token, int64 ExpiresOn)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	CachedToken = MoveTemp(Token);
+	CachedExpiresOn = ExpiresOn;
+}
+
+void FGoogleTokenManager::StartBackgroundRefresh()
+{
+	TWeakPtr<FGoogleTokenManager, ESPMode::ThreadSafe> WeakThis = AsShared();
+	bool bIsRefreshNeeded;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (TickerHandle.IsValid())
+		{
+			return;
+		}
+
+		TickerHandle = FTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+			{
+				auto This = WeakThis.Pin();
+
+				return This.IsValid() && This->Tick(DeltaTime);
+			}), kBackgroundCheckIntervalSeconds);
+
+		bIsRefreshNeeded = !IsFresh(CachedExpiresOn);
+	}
+
+	// don't wait for the first tick if there is no fresh token yet
+	if (bIsRefreshNeeded)
+	{
+		RefreshIfNotInFlight();
+	}
+}
+
+void FGoogleTokenManager::StopBackgroundRefresh()
+{
+	FDelegateHandle Handle;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Handle = TickerHandle;
+		TickerHandle.Reset();
+	}
+
+	if (Handle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(Handle);
+	}
+}
+
+bool FGoogleTokenManager::Tick(float DeltaTime)
+{
+	bool bIsRefreshNeeded;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		// the check is done a tick interval ahead so that the token is never
+		// served stale between two ticks
+		bIsRefreshNeeded = CachedExpiresOn - RefreshMarginSeconds -
+			static_cast<int64>(kBackgroundCheckIntervalSeconds) <=
+			FDateTime::Now().ToUnixTimestamp();
+	}
+
+	if (bIsRefreshNeeded)
+	{
+		RefreshIfNotInFlight();
+	}
+
+	return true;
+}
+
+void FGoogleTokenManager::RefreshIfNotInFlight()
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (bIsRefreshInFlight)
+		{
+			return;
+		}
+
+		bIsRefreshInFlight = true;
+	}
+
+	UE_LOG(LogGoogleDesktopOAuth, Log, TEXT("Refreshing the access token"));
+
+	TWeakPtr<FGoogleTokenManager, ESPMode::ThreadSafe> WeakThis = AsShared();
+	OAuth.RefreshAuthToken(
+		[WeakThis](FString Token, int64 ExpiresOn, Status Code)
+		{
+			auto This = WeakThis.Pin();
+			if (This.IsValid())
+			{
+				This->HandleRefreshResult(MoveTemp(Token), ExpiresOn, Code);
+			}
+		}, ClientId, ClientSecret, RefreshToken);
+}
+
+void FGoogleTokenManager::HandleRefreshResult(FString Token,
+	int64 ExpiresOn, Status Code)
+{
+	TArray<TokenCallbackType> Callbacks;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (Code == Status::kSuccessCode)
+		{
+			CachedToken = Token;
+			CachedExpiresOn = ExpiresOn;
+		}
+
+		bIsRefreshInFlight = false;
+		Callbacks = MoveTemp(PendingCallbacks);
+	}
+
+	if (Code == Status::kInvalidGrantErrorCode)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The refresh token is invalid, the background refresh is"
+				 " stopped"));
+
+		StopBackgroundRefresh();
+	}
+
+	for (TokenCallbackType& Callback : Callbacks)
+	{
+		Callback(Token, ExpiresOn, Code);
+	}
+}
+
+bool FGoogleTokenManager::IsFresh(int64 ExpiresOn) const
+{
+	return ExpiresOn - RefreshMarginSeconds >
+		FDateTime::Now().ToUnixTimestamp();
+}
@@ -0,0 +1,139 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "GoogleDesktopOAuth.h"
+
+/**
+* Keeps a valid access token of one Google account at hand
+*
+* The token is refreshed through `FGoogleDesktopOAuth::RefreshAuthToken()`
+* ahead of its expiration by a background ticker, so callers normally get the
+* cached token without waiting. All the concurrent requests for a token which
+* can't be served from the cache are coalesced into one in-flight refresh
+* request
+*
+* Is thread-safe. Must be created through `MakeShared` as async callbacks
+* keep only weak references to the manager
+*
+* Uses `LogGoogleDesktopOAuth` log category
+*/
+class FGoogleTokenManager :
+	public TSharedFromThis<FGoogleTokenManager, ESPMode::ThreadSafe>
+{
+public:
+	using Status = FGoogleDesktopOAuth::Status;
+
+	//Type of callback function used when requesting a token
+	using TokenCallbackType = FGoogleDesktopOAuth::RefreshCallbackType;
+
+	/**
+	* @param OAuth OAuth service to refresh tokens through, must outlive the
+	* manager
+	* @param ClientId Client ID of the Google App authentication happens for
+	* @param ClientSecret Client secret of the Google App authentication
+	* happens for
+	* @param RefreshToken Refresh token which is owned by the user the tokens
+	* are issued for
+	* @param RefreshMarginSeconds How long before the expiration the token is
+	* refreshed
+	*/
+	FGoogleTokenManager(FGoogleDesktopOAuth& OAuth, FString ClientId,
+		FString ClientSecret, FString RefreshToken,
+		int64 RefreshMarginSeconds = kDefaultRefreshMarginSeconds);
+
+	/**
+	* Stops the background refresh. Callbacks of an in-flight refresh are
+	* not called
+	*/
+	~FGoogleTokenManager();
+
+	/**
+	* Returns the cached access token if it is valid at least for
+	* `RefreshMarginSeconds` more. Never sends requests
+	*
+	* @param OutToken The cached access token, is set only on success
+	* @param OutExpiresOn Unix timestamp the token expires on, is set only on
+	* success
+	* @return `true` if the cached token is valid, `false` - otherwise
+	*/
+	bool TryGetCachedToken(FString& OutToken, int64& OutExpiresOn) const;
+
+	/**
+	* Returns a valid access token
+	*
+	* If the cached token is valid the callback is called immediately on the
+	* calling thread. Otherwise a refresh is started (unless one is already in
+	* flight) and the callback is called when it completes. The codes are the
+	* same as the ones `FGoogleDesktopOAuth::RefreshAuthToken()` reports
+	*
+	* @param Callback Callback to be called with the token
+	*/
+	void GetToken(TokenCallbackType Callback);
+
+	/**
+	* Sets a token obtained elsewhere (e.g. through
+	* `FGoogleDesktopOAuth::AuthenticateManually()`) as the cached one
+	*
+	* @param Token Access token
+	* @param ExpiresOn Unix timestamp the token expires on
+	*/
+	void SetToken(FString Token, int64 ExpiresOn);
+
+	/**
+	* Starts refreshing the token in the background ahead of its expiration.
+	* Is stopped automatically if the refresh token turns out to be invalid
+	*/
+	void StartBackgroundRefresh();
+
+	/**
+	* Stops refreshing the token in the background
+	*/
+	void StopBackgroundRefresh();
+
+	//Default value of how long before the expiration the token is refreshed
+	static constexpr int64 kDefaultRefreshMarginSeconds = 300;
+
+private:
+	/**
+	* Sends a refresh request unless one is already in flight
+	*/
+	void RefreshIfNotInFlight();
+
+	void HandleRefreshResult(FString Token, int64 ExpiresOn, Status Code);
+
+	//Checks whether the token expiring on `ExpiresOn` may still be served
+	bool IsFresh(int64 ExpiresOn) const;
+
+	bool Tick(float DeltaTime);
+
+	//How often the background ticker checks the expiration of the token
+	static constexpr float kBackgroundCheckIntervalSeconds = 10.0f;
+
+	FGoogleDesktopOAuth& OAuth;
+
+	const FString ClientId;
+
+	const FString ClientSecret;
+
+	const FString RefreshToken;
+
+	const int64 RefreshMarginSeconds;
+
+	//Guards all the fields below
+	mutable FCriticalSection CriticalSection;
+
+	FString CachedToken;
+
+	//Unix timestamp the cached token expires on, `0` if there is no token
+	int64 CachedExpiresOn = 0;
+
+	bool bIsRefreshInFlight = false;
+
+	//Callbacks waiting for the in-flight refresh
+	TArray<TokenCallbackType> PendingCallbacks;
+
+	FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,531 @@
+//Flying Wild Hog. All rights reserved
+
+#include "GoogleTokenStore.h"
+#include "GoogleDesktopOAuthLog.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "PlatformCryptoTypes.h"
+#include "IPlatformCrypto.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <wincrypt.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+#pragma comment(lib, "crypt32.lib")
+#elif PLATFORM_MAC
+#include <Security/Security.h>
+#elif PLATFORM_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	constexpr int32 kKeySize = 32;
+	constexpr int32 kIVSize = 12;
+	constexpr int32 kAuthTagSize = 16;
+
+	FString NormalizeScopes(const FString& Scopes)
+	{
+		TArray<FString> ScopesList;
+		Scopes.ParseIntoArrayWS(ScopesList);
+		ScopesList.Sort();
+
+		return FString::Join(ScopesList, TEXT(" "));
+	}
+
+	using ESecretReadResult = FGoogleTokenStore::ESecretReadResult;
+
+	FString GetDefaultStoreDirectory()
+	{
+		return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("GoogleOAuth"));
+	}
+
+	/**
+	* Writes next to the target and then moves so that a crash never leaves a
+	* half-written file. The temporary name is unique, so concurrent writers
+	* never write into the same temporary file
+	*
+	* @param bCanReplace Whether an existing target is replaced, otherwise
+	* the writing fails
+	*/
+	bool SaveFileAtomically(const TArray<uint8>& Data, const FString& Path,
+		bool bIsOwnerOnly = false, bool bCanReplace = true)
+	{
+		FString TemporaryPath = FString::Printf(TEXT("%s.%s.tmp"), *Path,
+			*FGuid::NewGuid().ToString());
+		if (!FFileHelper::SaveArrayToFile(Data, *TemporaryPath))
+		{
+			return false;
+		}
+
+#if PLATFORM_UNIX
+		FString FullPath = FPaths::ConvertRelativePathToFull(TemporaryPath);
+		if (bIsOwnerOnly &&
+			chmod(TCHAR_TO_UTF8(*FullPath), S_IRUSR | S_IWUSR) != 0)
+		{
+			IFileManager::Get().Delete(*TemporaryPath, false, false, true);
+
+			return false;
+		}
+#endif
+
+		if (!IFileManager::Get().Move(*Path, *TemporaryPath, bCanReplace,
+			true))
+		{
+			IFileManager::Get().Delete(*TemporaryPath, false, false, true);
+
+			return false;
+		}
+
+		return true;
+	}
+
+#if !PLATFORM_MAC
+	/**
+	* Reads the file, a missing one is told apart from one which can't be
+	* read
+	*/
+	ESecretReadResult ReadSecretFile(const FString& Path,
+		TArray<uint8>& OutData)
+	{
+		if (!IFileManager::Get().FileExists(*Path))
+		{
+			return ESecretReadResult::NotFound;
+		}
+
+		return FFileHelper::LoadFileToArray(OutData, *Path) ?
+			ESecretReadResult::Read : ESecretReadResult::Failed;
+	}
+#endif
+
+#if PLATFORM_WINDOWS
+	// DPAPI ties the key to the Windows account of the current user
+
+	class FPlatformSecretStore : public FGoogleTokenStore::ISecretStore
+	{
+	public:
+		ESecretReadResult Read(TArray<uint8>& OutSecret) override
+		{
+			TArray<uint8> Blob;
+			ESecretReadResult Result = ReadSecretFile(GetPath(), Blob);
+			if (Result != ESecretReadResult::Read)
+			{
+				return Result;
+			}
+
+			DATA_BLOB Input{static_cast<DWORD>(Blob.Num()), Blob.GetData()};
+			DATA_BLOB Output{};
+			if (!CryptUnprotectData(&Input, nullptr, nullptr, nullptr,
+				nullptr, CRYPTPROTECT_UI_FORBIDDEN, &Output))
+			{
+				return ESecretReadResult::Failed;
+			}
+
+			OutSecret = TArray<uint8>(Output.pbData, Output.cbData);
+			SecureZeroMemory(Output.pbData, Output.cbData);
+			LocalFree(Output.pbData);
+
+			return ESecretReadResult::Read;
+		}
+
+		bool Write(const TArray<uint8>& Secret) override
+		{
+			DATA_BLOB Input{static_cast<DWORD>(Secret.Num()),
+				const_cast<uint8*>(Secret.GetData())};
+			DATA_BLOB Output{};
+			if (!CryptProtectData(&Input, TEXT("FGoogleTokenStore"), nullptr,
+				nullptr, nullptr, CRYPTPROTECT_UI_FORBIDDEN, &Output))
+			{
+				return false;
+			}
+
+			TArray<uint8> Blob(Output.pbData, Output.cbData);
+			LocalFree(Output.pbData);
+
+			return SaveFileAtomically(Blob, GetPath(), false, false);
+		}
+
+	private:
+		static FString GetPath()
+		{
+			return FPaths::Combine(GetDefaultStoreDirectory(),
+				TEXT("tokens.key"));
+		}
+	};
+#elif PLATFORM_MAC
+	// a generic password item of the login Keychain per project
+
+	class FPlatformSecretStore : public FGoogleTokenStore::ISecretStore
+	{
+	public:
+		ESecretReadResult Read(TArray<uint8>& OutSecret) override
+		{
+			CFMutableDictionaryRef Query = CreateQuery();
+			CFDictionaryAddValue(Query, kSecReturnData, kCFBooleanTrue);
+			CFDictionaryAddValue(Query, kSecMatchLimit, kSecMatchLimitOne);
+
+			CFTypeRef Result = nullptr;
+			OSStatus Status = SecItemCopyMatching(Query, &Result);
+			CFRelease(Query);
+			if (Status == errSecItemNotFound)
+			{
+				return ESecretReadResult::NotFound;
+			}
+
+			if (Status != errSecSuccess || !Result)
+			{
+				return ESecretReadResult::Failed;
+			}
+
+			CFDataRef Data = static_cast<CFDataRef>(Result);
+			OutSecret = TArray<uint8>(CFDataGetBytePtr(Data),
+				CFDataGetLength(Data));
+			CFRelease(Result);
+
+			return ESecretReadResult::Read;
+		}
+
+		bool Write(const TArray<uint8>& Secret) override
+		{
+			// fails as a duplicate if the item exists, it's never replaced
+			CFMutableDictionaryRef Query = CreateQuery();
+			CFDataRef Data = CFDataCreate(kCFAllocatorDefault,
+				Secret.GetData(), Secret.Num());
+			CFDictionaryAddValue(Query, kSecValueData, Data);
+
+			OSStatus Status = SecItemAdd(Query, nullptr);
+			CFRelease(Data);
+			CFRelease(Query);
+
+			return Status == errSecSuccess;
+		}
+
+	private:
+		static CFMutableDictionaryRef CreateQuery()
+		{
+			CFMutableDictionaryRef Query = CFDictionaryCreateMutable(
+				kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks,
+				&kCFTypeDictionaryValueCallBacks);
+			CFStringRef Account =
+				FPlatformString::TCHARToCFString(FApp::GetProjectName());
+			CFDictionaryAddValue(Query, kSecClass, kSecClassGenericPassword);
+			CFDictionaryAddValue(Query, kSecAttrService,
+				CFSTR("FGoogleTokenStore"));
+			CFDictionaryAddValue(Query, kSecAttrAccount, Account);
+			CFRelease(Account);
+
+			return Query;
+		}
+	};
+#else
+	// no secret store is available to the engine, the key is kept in a file
+	// only the current user can read, outside of the project so that it
+	// isn't shared or synced together with the token files
+
+	class FPlatformSecretStore : public FGoogleTokenStore::ISecretStore
+	{
+	public:
+		ESecretReadResult Read(TArray<uint8>& OutSecret) override
+		{
+			return ReadSecretFile(GetPath(), OutSecret);
+		}
+
+		bool Write(const TArray<uint8>& Secret) override
+		{
+			return SaveFileAtomically(Secret, GetPath(), true, false);
+		}
+
+	private:
+		static FString GetPath()
+		{
+			return FPaths::Combine(FPlatformProcess::UserSettingsDir(),
+				TEXT("GoogleOAuth"), FApp::GetProjectName(),
+				TEXT("tokens.key"));
+		}
+	};
+#endif
+
+	// where the tokens and the key are kept, see `SetStorage()`
+	struct FStorage
+	{
+		FCriticalSection CriticalSection;
+
+		FString Directory = GetDefaultStoreDirectory();
+
+		TSharedPtr<FGoogleTokenStore::ISecretStore, ESPMode::ThreadSafe>
+			SecretStore =
+				MakeShared<FPlatformSecretStore, ESPMode::ThreadSafe>();
+
+		// the key is read from the store once
+		TArray<uint8> CachedKey;
+	};
+
+	FStorage& GetStorage()
+	{
+		static FStorage Storage;
+
+		return Storage;
+	}
+}
+
+bool FGoogleTokenStore::Load(const FString& ClientId, const FString& Scopes,
+	FTokens& OutTokens)
+{
+	FString Path = GetPath(ClientId, Scopes);
+
+	TArray<uint8> Data;
+	if (!IFileManager::Get().FileExists(*Path) ||
+		!FFileHelper::LoadFileToArray(Data, *Path))
+	{
+		return false;
+	}
+
+	// magic, version, IV and the authentication tag
+	constexpr int32 kHeaderSize = 2 * sizeof(uint32) + kIVSize + kAuthTagSize;
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	if (Data.Num() >= kHeaderSize)
+	{
+		FMemory::Memcpy(&Magic, Data.GetData(), sizeof(Magic));
+		FMemory::Memcpy(&Version, Data.GetData() + sizeof(Magic),
+			sizeof(Version));
+	}
+
+	if (Magic != kMagic || Version != kVersion)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("The token cache `%s` is malformed or outdated, ignoring it"),
+			*Path);
+
+		return false;
+	}
+
+	TArray<uint8> Key;
+	if (!GetKey(false, Key))
+	{
+		return false;
+	}
+
+	TArrayView<const uint8> IV(Data.GetData() + 2 * sizeof(uint32), kIVSize);
+	TArrayView<const uint8> AuthTag(IV.GetData() + kIVSize, kAuthTagSize);
+	TArrayView<const uint8> Ciphertext(Data.GetData() + kHeaderSize,
+		Data.Num() - kHeaderSize);
+
+	TUniquePtr<FEncryptionContext> EncryptionContext =
+		IPlatformCrypto::Get().CreateContext();
+	TUniquePtr<IPlatformCryptoDecryptor> Decryptor =
+		EncryptionContext->CreateDecryptor_AES_256_GCM(Key, IV, AuthTag);
+
+	// the tag is checked by `Finalize()`, nothing is trusted before that
+	TArray<uint8> Payload;
+	int32 UpdateSize = 0;
+	int32 FinalizeSize = 0;
+	bool bIsDecrypted = false;
+	if (Decryptor)
+	{
+		Payload.SetNumUninitialized(
+			Decryptor->GetUpdateBufferSizeBytes(Ciphertext) +
+			Decryptor->GetFinalizeBufferSizeBytes());
+		bIsDecrypted = Decryptor->Update(Ciphertext, Payload, UpdateSize) ==
+				EPlatformCryptoResult::Success &&
+			Decryptor->Finalize(TArrayView<uint8>(Payload).Slice(UpdateSize,
+				Payload.Num() - UpdateSize), FinalizeSize) ==
+				EPlatformCryptoResult::Success;
+	}
+
+	if (!bIsDecrypted)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Warning,
+			TEXT("The token cache `%s` can't be decrypted (it was probably"
+				 " written by another user or modified), ignoring it"), *Path);
+
+		return false;
+	}
+
+	Payload.SetNum(UpdateSize + FinalizeSize);
+	FMemoryReader Reader(Payload);
+	FTokens Tokens;
+	Reader << Tokens.AccessToken;
+	Reader << Tokens.ExpiresOn;
+	Reader << Tokens.RefreshToken;
+
+	if (Reader.IsError())
+	{
+		return false;
+	}
+
+	OutTokens = MoveTemp(Tokens);
+
+	return true;
+}
+
+bool FGoogleTokenStore::Save(const FString& ClientId, const FString& Scopes,
+	const FTokens& Tokens)
+{
+	FString Path = GetPath(ClientId, Scopes);
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	FTokens TokensCopy = Tokens;
+	Writer << TokensCopy.AccessToken;
+	Writer << TokensCopy.ExpiresOn;
+	Writer << TokensCopy.RefreshToken;
+
+	TArray<uint8> Key;
+	TUniquePtr<FEncryptionContext> EncryptionContext =
+		IPlatformCrypto::Get().CreateContext();
+
+	// the IV must never repeat for a key, so it's random per write
+	uint8 IV[kIVSize];
+	TUniquePtr<IPlatformCryptoEncryptor> Encryptor;
+	if (GetKey(true, Key) && EncryptionContext->CreateRandomBytes(
+		TArrayView<uint8>(IV, kIVSize)) == EPlatformCryptoResult::Success)
+	{
+		Encryptor = EncryptionContext->CreateEncryptor_AES_256_GCM(Key,
+			TArrayView<const uint8>(IV, kIVSize));
+	}
+
+	TArray<uint8> Ciphertext;
+	uint8 AuthTag[kAuthTagSize];
+	int32 UpdateSize = 0;
+	int32 FinalizeSize = 0;
+	int32 AuthTagSize = 0;
+	bool bIsEncrypted = false;
+	if (Encryptor)
+	{
+		Ciphertext.SetNumUninitialized(
+			Encryptor->GetUpdateBufferSizeBytes(Payload) +
+			Encryptor->GetFinalizeBufferSizeBytes());
+		bIsEncrypted = Encryptor->Update(Payload, Ciphertext, UpdateSize) ==
+				EPlatformCryptoResult::Success &&
+			Encryptor->Finalize(TArrayView<uint8>(Ciphertext).Slice(
+				UpdateSize, Ciphertext.Num() - UpdateSize), FinalizeSize) ==
+				EPlatformCryptoResult::Success &&
+			Encryptor->GenerateAuthTag(TArrayView<uint8>(AuthTag,
+				kAuthTagSize), AuthTagSize) ==
+				EPlatformCryptoResult::Success &&
+			AuthTagSize == kAuthTagSize;
+	}
+
+	if (!bIsEncrypted)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("Unable to encrypt the token cache `%s`"), *Path);
+
+		return false;
+	}
+
+	TArray<uint8> Data;
+	Data.Append(reinterpret_cast<const uint8*>(&kMagic), sizeof(kMagic));
+	Data.Append(reinterpret_cast<const uint8*>(&kVersion), sizeof(kVersion));
+	Data.Append(IV, kIVSize);
+	Data.Append(AuthTag, kAuthTagSize);
+	Data.Append(Ciphertext.GetData(), UpdateSize + FinalizeSize);
+
+	if (!SaveFileAtomically(Data, Path))
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("Unable to write the token cache `%s`"), *Path);
+
+		return false;
+	}
+
+	return true;
+}
+
+void FGoogleTokenStore::Delete(const FString& ClientId, const FString& Scopes)
+{
+	IFileManager::Get().Delete(*GetPath(ClientId, Scopes), false, false,
+		true);
+}
+
+void FGoogleTokenStore::SetStorage(const FString& Directory,
+	TSharedPtr<ISecretStore, ESPMode::ThreadSafe> SecretStore)
+{
+	FStorage& Storage = GetStorage();
+	FScopeLock Lock(&Storage.CriticalSection);
+	Storage.Directory = Directory.IsEmpty() ? GetDefaultStoreDirectory() :
+		Directory;
+	Storage.SecretStore = SecretStore ? MoveTemp(SecretStore) :
+		MakeShared<FPlatformSecretStore, ESPMode::ThreadSafe>();
+	Storage.CachedKey.Empty();
+}
+
+FString FGoogleTokenStore::GetPath(const FString& ClientId,
+	const FString& Scopes)
+{
+	FTCHARToUTF8 Identity(*(ClientId + TEXT("\n") + NormalizeScopes(Scopes)));
+	FSHAHash Hash;
+	FSHA1::HashBuffer(Identity.Get(), Identity.Length(), Hash.Hash);
+
+	FStorage& Storage = GetStorage();
+	FScopeLock Lock(&Storage.CriticalSection);
+
+	return FPaths::Combine(Storage.Directory,
+		Hash.ToString() + TEXT(".tokens"));
+}
+
+bool FGoogleTokenStore::GetKey(bool bCanCreate, TArray<uint8>& OutKey)
+{
+	// the lock also keeps two threads from creating different keys
+	FStorage& Storage = GetStorage();
+	FScopeLock Lock(&Storage.CriticalSection);
+	if (Storage.CachedKey.Num() == kKeySize)
+	{
+		OutKey = Storage.CachedKey;
+
+		return true;
+	}
+
+	TArray<uint8> Key;
+	ESecretReadResult Result = Storage.SecretStore->Read(Key);
+	if (Result == ESecretReadResult::NotFound && bCanCreate)
+	{
+		Key.SetNumUninitialized(kKeySize);
+		TUniquePtr<FEncryptionContext> EncryptionContext =
+			IPlatformCrypto::Get().CreateContext();
+		bool bIsCreated = EncryptionContext->CreateRandomBytes(Key) ==
+			EPlatformCryptoResult::Success &&
+			Storage.SecretStore->Write(Key);
+
+		// another process may have stored its key meanwhile, it's used then
+		Result = bIsCreated ? ESecretReadResult::Read :
+			Storage.SecretStore->Read(Key);
+		if (Result == ESecretReadResult::NotFound)
+		{
+			UE_LOG(LogGoogleDesktopOAuth, Error,
+				TEXT("Unable to create the token cache key"));
+
+			return false;
+		}
+	}
+
+	if (Result == ESecretReadResult::NotFound)
+	{
+		// nothing was saved with a key yet, so there's nothing to decrypt
+		return false;
+	}
+
+	if (Result == ESecretReadResult::Failed || Key.Num() != kKeySize)
+	{
+		UE_LOG(LogGoogleDesktopOAuth, Error,
+			TEXT("The token cache key can't be read, the tokens are neither"
+				 " loaded nor saved until it's readable or removed"));
+
+		return false;
+	}
+
+	Storage.CachedKey = Key;
+	OutKey = MoveTemp(Key);
+
+	return true;
+}
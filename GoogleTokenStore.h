@@ -0,0 +1,136 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Encrypted on-disk storage of Google OAuth tokens
+*
+* Tokens are stored per client ID and scope set in
+* `<Saved>/GoogleOAuth/<hash>.tokens`. The files are encrypted with
+* AES-256 in GCM mode, so a modified file fails to decrypt instead of being
+* read as garbage. The key is random and is kept in the secret store of the
+* OS: the Keychain on Mac, a DPAPI-protected file on Windows. Other
+* platforms have no store available to the engine, there the key is kept
+* in `<UserSettings>/GoogleOAuth/<Project>/tokens.key` readable only by its
+* owner, away from the token files. A token file copied to another machine
+* or account can't be decrypted. Note that it's a protection against
+* leaking tokens through shared or synced directories, not against a
+* process which runs under the same user
+*
+* The key is created by the first `Save()` only. When the store holds a key
+* which can't be read, the tokens are neither loaded nor saved, the key is
+* never replaced as that would make all the stored tokens unreadable
+*
+* All the methods are blocking and may be called from any thread, see
+* `FGoogleDesktopOAuth::LoadCachedTokens()` for the non-blocking access
+*
+* Uses `LogGoogleDesktopOAuth` log category
+*/
+class FGoogleTokenStore
+{
+public:
+	//Result of reading the key from a secret store
+	enum class ESecretReadResult
+	{
+		Read,
+		NotFound,
+		Failed
+	};
+
+	//Storage of the key, the default one is the secret store of the OS
+	class ISecretStore
+	{
+	public:
+		virtual ~ISecretStore() = default;
+
+		/**
+		* @param OutSecret The stored secret, is set only if it's read
+		* @return Whether the secret was read, wasn't stored yet or couldn't
+		* be read
+		*/
+		virtual ESecretReadResult Read(TArray<uint8>& OutSecret) = 0;
+
+		/**
+		* Stores the secret unless the store already holds one
+		*
+		* @return `true` if the secret was stored, `false` - otherwise
+		*/
+		virtual bool Write(const TArray<uint8>& Secret) = 0;
+	};
+
+	//Tokens of one client ID and scope set
+	struct FTokens
+	{
+		FString AccessToken;
+
+		//Unix timestamp the access token expires on
+		int64 ExpiresOn = 0;
+
+		FString RefreshToken;
+	};
+
+	/**
+	* Reads and decrypts the tokens
+	*
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Space-separated scopes the tokens are issued for, the
+	* order doesn't matter
+	* @param OutTokens The stored tokens, are set only on success
+	* @return `true` if the tokens were stored and could be decrypted,
+	* `false` - otherwise
+	*/
+	static bool Load(const FString& ClientId, const FString& Scopes,
+		FTokens& OutTokens);
+
+	/**
+	* Encrypts and writes the tokens replacing the stored ones
+	*
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Space-separated scopes the tokens are issued for, the
+	* order doesn't matter
+	* @param Tokens The tokens to store
+	* @return `true` if the tokens were written, `false` - otherwise
+	*/
+	static bool Save(const FString& ClientId, const FString& Scopes,
+		const FTokens& Tokens);
+
+	/**
+	* Deletes the stored tokens, e.g. after the refresh token was revoked
+	*
+	* @param ClientId Client ID of the Google App the tokens are issued for
+	* @param Scopes Space-separated scopes the tokens are issued for
+	*/
+	static void Delete(const FString& ClientId, const FString& Scopes);
+
+	/**
+	* Replaces where the tokens and the key are kept, is meant for tests so
+	* that they leave the ones of the user alone. Drops the cached key
+	*
+	* @param Directory Directory of the token files, the default one if empty
+	* @param SecretStore Store of the key, the one of the OS if `nullptr`
+	*/
+	static void SetStorage(const FString& Directory,
+		TSharedPtr<ISecretStore, ESPMode::ThreadSafe> SecretStore);
+
+private:
+	static FString GetPath(const FString& ClientId, const FString& Scopes);
+
+	/**
+	* Reads the key from the secret store
+	*
+	* @param bCanCreate Whether a new random key is created and stored when
+	* the store holds none. A key which can't be read is never replaced
+	* @param OutKey The AES-256 key, is set only on success
+	* @return `true` if the key is available, `false` - otherwise
+	*/
+	static bool GetKey(bool bCanCreate, TArray<uint8>& OutKey);
+
+	//Magic number the file starts with, `GTOK` in ASCII
+	static constexpr uint32 kMagic = 0x4B4F5447u;
+
+	//Version of the file format, version 1 files are AES-CBC ones with a
+	//derived key and are ignored
+	static constexpr uint32 kVersion = 2;
+};
@@ -0,0 +1,234 @@
+//Flying Wild Hog. All rights reserved
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "GoogleTokenStore.h"
+
+namespace
+{
+	using ESecretReadResult = FGoogleTokenStore::ESecretReadResult;
+
+	const TCHAR* const kClientId = TEXT("client-id");
+
+	const TCHAR* const kScopes = TEXT("openid email profile");
+
+	//Secret store in memory, so that the specs leave the key of the user
+	//alone
+	class FMemorySecretStore : public FGoogleTokenStore::ISecretStore
+	{
+	public:
+		//What `Read()` reports, the secret is handed over only if it's read
+		ESecretReadResult ReadResult = ESecretReadResult::NotFound;
+
+		TArray<uint8> Secret;
+
+		int32 NumberOfWrites = 0;
+
+		ESecretReadResult Read(TArray<uint8>& OutSecret) override
+		{
+			if (ReadResult == ESecretReadResult::Read)
+			{
+				OutSecret = Secret;
+			}
+
+			return ReadResult;
+		}
+
+		bool Write(const TArray<uint8>& NewSecret) override
+		{
+			if (ReadResult != ESecretReadResult::NotFound)
+			{
+				return false;
+			}
+
+			Secret = NewSecret;
+			ReadResult = ESecretReadResult::Read;
+			NumberOfWrites++;
+
+			return true;
+		}
+	};
+}
+
+BEGIN_DEFINE_SPEC(FGoogleTokenStoreSpec,
+	"GoogleOAuth.TokenStore",
+	EAutomationTestFlags::ProductFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+
+FString Directory;
+
+TSharedPtr<FMemorySecretStore, ESPMode::ThreadSafe> SecretStore;
+
+FGoogleTokenStore::FTokens Tokens;
+
+//Starts over with the secret store, as after a restart of the application
+void UseSecretStore(
+	const TSharedPtr<FMemorySecretStore, ESPMode::ThreadSafe>& NewSecretStore)
+{
+	SecretStore = NewSecretStore;
+	FGoogleTokenStore::SetStorage(Directory, SecretStore);
+}
+
+TArray<FString> FindTokenFiles()
+{
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *Directory, TEXT("tokens"));
+
+	return Files;
+}
+
+END_DEFINE_SPEC(FGoogleTokenStoreSpec)
+
+void FGoogleTokenStoreSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Directory = FPaths::Combine(FPaths::AutomationTransientDir(),
+			TEXT("GoogleTokenStore"));
+		IFileManager::Get().DeleteDirectory(*Directory, false, true);
+		UseSecretStore(MakeShared<FMemorySecretStore, ESPMode::ThreadSafe>());
+
+		Tokens.AccessToken = TEXT("ya29.access-token");
+		Tokens.ExpiresOn = 1700000000;
+		Tokens.RefreshToken = TEXT("1//refresh-token");
+	});
+
+	AfterEach([this]()
+	{
+		FGoogleTokenStore::SetStorage(FString(), nullptr);
+		SecretStore.Reset();
+		IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	});
+
+	It("Round trip",
+		[this]()
+		{
+			TestTrue("Expecting the tokens to be saved",
+				FGoogleTokenStore::Save(kClientId, kScopes, Tokens));
+			TestEqual("Expecting one key to be created",
+				SecretStore->NumberOfWrites, 1);
+
+			//The key is read again from the store
+			UseSecretStore(SecretStore);
+			FGoogleTokenStore::FTokens Loaded;
+			if (TestTrue("Expecting the tokens to be loaded",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded)))
+			{
+				TestEqual("Expecting the same access token",
+					Loaded.AccessToken, Tokens.AccessToken);
+				TestEqual("Expecting the same expiration",
+					Loaded.ExpiresOn, Tokens.ExpiresOn);
+				TestEqual("Expecting the same refresh token",
+					Loaded.RefreshToken, Tokens.RefreshToken);
+			}
+
+			TestTrue("Expecting the tokens to be saved again",
+				FGoogleTokenStore::Save(kClientId, kScopes, Tokens));
+			TestEqual("Expecting the key to be reused",
+				SecretStore->NumberOfWrites, 1);
+
+			FGoogleTokenStore::Delete(kClientId, kScopes);
+			TestFalse("Expecting no tokens after deleting them",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded));
+		}
+	);
+
+	It("Doesn't depend on the order of the scopes",
+		[this]()
+		{
+			TestTrue("Expecting the tokens to be saved",
+				FGoogleTokenStore::Save(kClientId, TEXT("profile openid"),
+					Tokens));
+			TestTrue("Expecting the tokens to be replaced",
+				FGoogleTokenStore::Save(kClientId, TEXT(" openid  profile"),
+					Tokens));
+			TestEqual("Expecting one token file",
+				FindTokenFiles().Num(), 1);
+
+			FGoogleTokenStore::FTokens Loaded;
+			TestTrue("Expecting the tokens to be loaded in another order",
+				FGoogleTokenStore::Load(kClientId, TEXT("openid profile"),
+					Loaded) && Loaded.RefreshToken == Tokens.RefreshToken);
+			TestFalse("Expecting no tokens of other scopes",
+				FGoogleTokenStore::Load(kClientId, TEXT("openid"), Loaded));
+		}
+	);
+
+	It("Rejects a modified file",
+		[this]()
+		{
+			AddExpectedError(TEXT("can't be decrypted"),
+				EAutomationExpectedErrorFlags::Contains, 1);
+
+			FGoogleTokenStore::Save(kClientId, kScopes, Tokens);
+			TArray<FString> Files = FindTokenFiles();
+			if (!TestEqual("Expecting one token file", Files.Num(), 1))
+			{
+				return;
+			}
+
+			//The ciphertext is at the end, the header stays valid
+			FString Path = FPaths::Combine(Directory, Files[0]);
+			TArray<uint8> Data;
+			FFileHelper::LoadFileToArray(Data, *Path);
+			Data.Last() ^= 0x01;
+			FFileHelper::SaveArrayToFile(Data, *Path);
+
+			FGoogleTokenStore::FTokens Loaded;
+			TestFalse("Expecting the authentication tag check to fail",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded));
+		}
+	);
+
+	It("Doesn't create a key when loading",
+		[this]()
+		{
+			FGoogleTokenStore::Save(kClientId, kScopes, Tokens);
+
+			//The key is gone, e.g. the Keychain item was removed
+			UseSecretStore(
+				MakeShared<FMemorySecretStore, ESPMode::ThreadSafe>());
+			FGoogleTokenStore::FTokens Loaded;
+			TestFalse("Expecting no tokens without the key",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded));
+			TestEqual("Expecting no key to be created",
+				SecretStore->NumberOfWrites, 0);
+		}
+	);
+
+	It("Leaves a key which can't be read alone",
+		[this]()
+		{
+			AddExpectedError(TEXT("token cache key can't be read"),
+				EAutomationExpectedErrorFlags::Contains, 2);
+			AddExpectedError(TEXT("Unable to encrypt the token cache"),
+				EAutomationExpectedErrorFlags::Contains, 1);
+
+			FGoogleTokenStore::Save(kClientId, kScopes, Tokens);
+			TArray<uint8> Key = SecretStore->Secret;
+
+			//E.g. the Keychain is locked
+			SecretStore->ReadResult = ESecretReadResult::Failed;
+			UseSecretStore(SecretStore);
+
+			FGoogleTokenStore::FTokens Loaded;
+			TestFalse("Expecting no tokens to be loaded",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded));
+			TestFalse("Expecting no tokens to be saved",
+				FGoogleTokenStore::Save(kClientId, kScopes, Tokens));
+			TestEqual("Expecting the key not to be replaced",
+				SecretStore->NumberOfWrites, 1);
+
+			//Once the store is readable again the tokens are too
+			SecretStore->ReadResult = ESecretReadResult::Read;
+			TestTrue("Expecting the same key",
+				SecretStore->Secret == Key);
+			TestTrue("Expecting the tokens to be loaded with the old key",
+				FGoogleTokenStore::Load(kClientId, kScopes, Loaded));
+		}
+	);
+}
@@ -0,0 +1,60 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FExtractionRequest;
+struct FVersion;
+
+/**
+ * Request which is deserialized section by section as the extraction
+ * asks for them, so that only the sections in use take memory
+ *
+ * A section is a property of `FExtractionRequest`. The sections of a
+ * request which isn't loaded keep their default values
+ */
+class IRequestSections
+{
+public:
+    virtual ~IRequestSections() = default;
+
+    /**
+     * Reads the version the request requires
+     *
+     * @param OutVersion The version, is set only on success
+     * @return `true` on success, `false` if the request has no valid
+     * version, such a request mustn't be used
+     */
+    virtual bool ExtractVersion(FVersion& OutVersion) = 0;
+
+    /**
+     * Returns the names of the sections present in the request
+     *
+     * @return Names of the properties of `FExtractionRequest`
+     */
+    virtual TArray<FName> GetSectionNames() const = 0;
+
+    /**
+     * Deserializes a section into the request, the other sections are
+     * left intact
+     *
+     * @param Name Name of the section
+     * @param Request Request to deserialize the section into
+     * @return `true` on success, `false` if the section isn't present or
+     * is malformed
+     */
+    virtual bool LoadSection(FName Name, FExtractionRequest& Request) = 0;
+
+    /**
+     * Resets a section of the request to the default value, releasing the
+     * memory it has taken. It may be loaded again afterwards
+     *
+     * @param Name Name of the section
+     * @param Request Request the section has been loaded into
+     */
+    virtual void UnloadSection(FName Name, FExtractionRequest& Request) = 0;
+};
@@ -0,0 +1,73 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestDeserializer.h"
+#include "IRequestSections.h"
+
+class FRequestArena;
+
+/**
+ * Request deserializer which is able to read the contents straight from
+ * the bytes an `IRequestViewProvider` holds
+ */
+class IRequestViewDeserializer : public IRequestDeserializer
+{
+public:
+    /**
+     * The same as `Deserialize()` but reads the contents from a view
+     *
+     * @param Contents UTF-8 encoded contents without BOM. The deserializer
+     * may refer to the view until the request is extracted, the provider
+     * keeps it valid that long
+     */
+    virtual void DeserializeView(TArrayView<const uint8> Contents) = 0;
+
+    /**
+     * Reads the version from the first bytes of the contents without
+     * deserializing them, so that an incompatible request is rejected
+     * before its body is parsed
+     *
+     * @param Head The first bytes of UTF-8 encoded contents without BOM,
+     * may end in the middle of a token
+     * @param OutVersion The version, is set only on success
+     * @return `true` if the version has been read, `false` if it's beyond
+     * the head or the format doesn't support peeking, in which case the
+     * version is checked after the deserialization
+     */
+    virtual bool PeekVersion(TArrayView<const uint8> Head,
+        FVersion& OutVersion)
+    {
+        return false;
+    }
+
+    /**
+     * Makes `DeserializeView()` keep its intermediate state in an arena
+     * instead of on the heap, so that it's released at once instead of
+     * being freed piece by piece
+     *
+     * @param Arena The arena or `nullptr` to go back to the heap. It has to
+     * stay intact until the request is extracted, the owner releases it
+     * afterwards and may reuse it for the next request
+     */
+    virtual void SetArena(FRequestArena* Arena) {}
+
+    /**
+     * Indexes the contents instead of deserializing them, the sections of
+     * the request are deserialized when they are asked for
+     *
+     * @param Contents The same as for `DeserializeView()`, has to stay
+     * valid while the sections are in use
+     * @return The sections or `nullptr` if the format doesn't support lazy
+     * deserialization or the contents are malformed
+     */
+    virtual TUniquePtr<IRequestSections> DeserializeViewLazily(
+        TArrayView<const uint8> Contents)
+    {
+        return nullptr;
+    }
+};
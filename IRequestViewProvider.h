@@ -0,0 +1,30 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestProvider.h"
+
+/**
+ * Request provider which is able to hand the contents over as bytes it
+ * already holds, e.g. mapped straight from a file, instead of a string
+ * which has to be read, widened and copied first
+ *
+ * `FRequestLoader` prefers `RetrieveView()` over `RetrieveContents()` when
+ * it's paired with an `IRequestViewDeserializer`
+ */
+class IRequestViewProvider : public IRequestProvider
+{
+public:
+    /**
+     * Returns the contents of the request
+     *
+     * @return UTF-8 encoded contents without BOM, empty if they can't be
+     * retrieved. The view stays valid until the provider is destroyed or
+     * the method is called again
+     */
+    virtual TArrayView<const uint8> RetrieveView() = 0;
+};
@@ -0,0 +1,332 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "JsonRequestDeserializer.h"
+#include "RequestLoaderLog.h"
+#include "ExtractionRequest.h"
+#include "Utf8ViewArchive.h"
+#include "Utf8JsonFieldReader.h"
+#include "ArenaJsonReader.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "JsonObjectConverter.h"
+
+namespace
+{
+    //Parses `MAJOR.MINOR.INDEX`
+    bool ParseVersion(const FString& VersionString, FVersion& OutVersion)
+    {
+        TArray<FString> Parts;
+        VersionString.ParseIntoArray(Parts, TEXT("."));
+        if (Parts.Num() != 3 || !Parts[0].IsNumeric() ||
+            !Parts[1].IsNumeric() || !Parts[2].IsNumeric())
+        {
+            return false;
+        }
+
+        OutVersion.Major = FCString::Atoi(*Parts[0]);
+        OutVersion.Minor = FCString::Atoi(*Parts[1]);
+        OutVersion.Index = FCString::Atoi(*Parts[2]);
+
+        return true;
+    }
+
+    /**
+     * Sections of a JSON request, each of them is a top-level field other
+     * than the version
+     *
+     * A section is parsed as an object of the single field, which leaves
+     * the other properties of the request intact, so only one section at a
+     * time has a DOM
+     */
+    class FJsonRequestSections : public IRequestSections
+    {
+    public:
+        explicit FJsonRequestSections(
+            TArray<FUtf8JsonFieldReader::FRawField> Fields)
+        {
+            for (FUtf8JsonFieldReader::FRawField& Field : Fields)
+            {
+                if (Field.Key == FJsonRequestDeserializer::kVersionField)
+                {
+                    VersionField = Field.Field;
+                }
+                else
+                {
+                    Sections.Add(FName(*Field.Key), Field.Field);
+                }
+            }
+        }
+
+        virtual bool ExtractVersion(FVersion& OutVersion) override
+        {
+            TSharedPtr<FJsonObject> Object;
+            FUtf8ViewArchive Archive(VersionField, TEXT('{'), TEXT('}'));
+            FJsonSerializer::Deserialize(
+                TJsonReaderFactory<TCHAR>::Create(&Archive), Object);
+
+            FString VersionString;
+            if (!Object.IsValid() || !Object->TryGetStringField(
+                    FJsonRequestDeserializer::kVersionField, VersionString)
+                || !ParseVersion(VersionString, OutVersion))
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("The request has no valid `%s` field"),
+                    FJsonRequestDeserializer::kVersionField);
+
+                return false;
+            }
+
+            return true;
+        }
+
+        virtual TArray<FName> GetSectionNames() const override
+        {
+            TArray<FName> Names;
+            Sections.GenerateKeyArray(Names);
+
+            return Names;
+        }
+
+        virtual bool LoadSection(FName Name,
+            FExtractionRequest& Request) override
+        {
+            const TArrayView<const uint8>* Field = Sections.Find(Name);
+            if (Field == nullptr)
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("The request has no `%s` section"),
+                    *Name.ToString());
+
+                return false;
+            }
+
+            TSharedPtr<FJsonObject> Object;
+            FUtf8ViewArchive Archive(*Field, TEXT('{'), TEXT('}'));
+            TSharedRef<TJsonReader<TCHAR>> Reader =
+                TJsonReaderFactory<TCHAR>::Create(&Archive);
+            if (!FJsonSerializer::Deserialize(Reader, Object) ||
+                !Object.IsValid())
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("Failed to parse the `%s` section: %s"),
+                    *Name.ToString(), *Reader->GetErrorMessage());
+
+                return false;
+            }
+
+            if (!FJsonObjectConverter::JsonObjectToUStruct(
+                Object.ToSharedRef(), &Request))
+            {
+                UE_LOG(LogXYZProductRequestLoader, Error,
+                    TEXT("The `%s` section doesn't match "
+                         "`FExtractionRequest`"),
+                    *Name.ToString());
+
+                return false;
+            }
+
+            return true;
+        }
+
+        virtual void UnloadSection(FName Name,
+            FExtractionRequest& Request) override
+        {
+            //Property names match JSON keys case-insensitively, the same
+            //way `FJsonObjectConverter` matches them
+            FProperty* Property =
+                FExtractionRequest::StaticStruct()->FindPropertyByName(Name);
+            if (Property != nullptr)
+            {
+                Property->ClearValue_InContainer(&Request);
+            }
+        }
+
+    private:
+        TMap<FName, TArrayView<const uint8>> Sections;
+
+        TArrayView<const uint8> VersionField;
+    };
+}
+
+void FJsonRequestDeserializer::Deserialize(FString Contents)
+{
+    Root.Reset();
+    ArenaRoot = nullptr;
+
+    TSharedRef<TJsonReader<TCHAR>> Reader =
+        TJsonReaderFactory<TCHAR>::Create(MoveTemp(Contents));
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to parse the request: %s"),
+            *Reader->GetErrorMessage());
+
+        Root.Reset();
+    }
+}
+
+void FJsonRequestDeserializer::DeserializeView(
+    TArrayView<const uint8> Contents)
+{
+    Root.Reset();
+    ArenaRoot = nullptr;
+
+    if (Arena != nullptr)
+    {
+        ArenaRoot = FArenaJsonReader::Parse(Contents, *Arena);
+        if (ArenaRoot == nullptr || ArenaRoot->Type != EJson::Object)
+        {
+            UE_LOG(LogXYZProductRequestLoader, Error,
+                TEXT("Failed to parse the request, it's malformed"));
+
+            ArenaRoot = nullptr;
+        }
+
+        return;
+    }
+
+    FUtf8ViewArchive Archive(Contents);
+    TSharedRef<TJsonReader<TCHAR>> Reader =
+        TJsonReaderFactory<TCHAR>::Create(&Archive);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to parse the request: %s"),
+            *Reader->GetErrorMessage());
+
+        Root.Reset();
+    }
+}
+
+bool FJsonRequestDeserializer::PeekVersion(TArrayView<const uint8> Head,
+    FVersion& OutVersion)
+{
+    //The reader skips the fields preceding the version without parsing
+    //them and gives up where the head is cut off
+    FString VersionString;
+    if (!FUtf8JsonFieldReader(Head).TryGetStringField(kVersionField,
+        VersionString))
+    {
+        return false;
+    }
+
+    return ParseVersion(VersionString, OutVersion);
+}
+
+void FJsonRequestDeserializer::SetArena(FRequestArena* Arena)
+{
+    this->Arena = Arena;
+    ArenaRoot = nullptr;
+}
+
+TUniquePtr<IRequestSections> FJsonRequestDeserializer::DeserializeViewLazily(
+    TArrayView<const uint8> Contents)
+{
+    Root.Reset();
+    ArenaRoot = nullptr;
+
+    TArray<FUtf8JsonFieldReader::FRawField> Fields;
+    if (!FUtf8JsonFieldReader(Contents).TryGetRawFields(Fields))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to index the request, it's malformed"));
+
+        return nullptr;
+    }
+
+    return MakeUnique<FJsonRequestSections>(MoveTemp(Fields));
+}
+
+FVersion FJsonRequestDeserializer::ExtractVersion()
+{
+    FVersion Version{};
+    FString VersionString;
+    if (!TryGetVersionString(VersionString))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request has no `%s` field"), kVersionField);
+
+        return Version;
+    }
+
+    if (!ParseVersion(VersionString, Version))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request version `%s` is malformed"), *VersionString);
+
+        return FVersion{};
+    }
+
+    return Version;
+}
+
+TUniquePtr<FExtractionRequest> FJsonRequestDeserializer::ExtractRequest()
+{
+    if (!Root.IsValid() && ArenaRoot == nullptr)
+    {
+        return nullptr;
+    }
+
+    //Without a valid version the request would pass every version check
+    //with the default one, so it's rejected as malformed
+    FVersion Version;
+    FString VersionString;
+    if (!TryGetVersionString(VersionString) ||
+        !ParseVersion(VersionString, Version))
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request can't be extracted without a valid `%s`"),
+            kVersionField);
+
+        Root.Reset();
+        ArenaRoot = nullptr;
+
+        return nullptr;
+    }
+
+    TUniquePtr<FExtractionRequest> Request =
+        MakeUnique<FExtractionRequest>();
+
+    bool bIsConverted;
+    if (ArenaRoot != nullptr)
+    {
+        bIsConverted = FArenaJsonReader::ToStruct(*ArenaRoot,
+            FExtractionRequest::StaticStruct(), Request.Get());
+        ArenaRoot = nullptr;
+    }
+    else
+    {
+        bIsConverted = FJsonObjectConverter::JsonObjectToUStruct(
+            Root.ToSharedRef(), Request.Get());
+    }
+
+    if (!bIsConverted)
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("The request doesn't match `FExtractionRequest`"));
+
+        return nullptr;
+    }
+
+    return Request;
+}
+
+bool FJsonRequestDeserializer::TryGetVersionString(
+    FString& OutVersionString) const
+{
+    if (ArenaRoot != nullptr)
+    {
+        const FArenaJsonValue* Field =
+            FArenaJsonReader::FindField(*ArenaRoot, kVersionField);
+
+        return Field != nullptr &&
+            FArenaJsonReader::TryGetString(*Field, OutVersionString);
+    }
+
+    return Root.IsValid() &&
+        Root->TryGetStringField(kVersionField, OutVersionString);
+}
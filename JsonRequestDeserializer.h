@@ -0,0 +1,67 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewDeserializer.h"
+
+class FJsonObject;
+struct FArenaJsonValue;
+
+/**
+ * Deserializes requests stored as JSON
+ *
+ * The version is stored as a top-level `version` string field in the
+ * `MAJOR.MINOR.INDEX` form, the rest of the top-level fields are the
+ * fields of `FExtractionRequest`. A request without a valid version is
+ * malformed, `ExtractRequest()` fails for it
+ *
+ * `DeserializeView()` parses the UTF-8 bytes in place, without widening
+ * them into a string first. `PeekVersion()` finds the version only if it
+ * precedes the fields which don't fit into the head, so writers should put
+ * it first
+ *
+ * `DeserializeViewLazily()` only finds where the top-level fields are,
+ * each of them is a section which is parsed when it's loaded
+ *
+ * With an arena `DeserializeView()` parses the contents into the arena
+ * instead of into a DOM and `ExtractRequest()` converts them straight into
+ * the request, see `FArenaJsonReader`
+ */
+class FJsonRequestDeserializer : public IRequestViewDeserializer
+{
+public:
+    virtual void Deserialize(FString Contents) override;
+
+    virtual void DeserializeView(TArrayView<const uint8> Contents) override;
+
+    virtual bool PeekVersion(TArrayView<const uint8> Head,
+        FVersion& OutVersion) override;
+
+    virtual void SetArena(FRequestArena* Arena) override;
+
+    virtual TUniquePtr<IRequestSections> DeserializeViewLazily(
+        TArrayView<const uint8> Contents) override;
+
+    virtual FVersion ExtractVersion() override;
+
+    virtual TUniquePtr<FExtractionRequest> ExtractRequest() override;
+
+    //Name of the top-level field the version is stored in
+    static constexpr const TCHAR* kVersionField = TEXT("version");
+
+private:
+    //Finds the version field in the DOM or in the arena
+    bool TryGetVersionString(FString& OutVersionString) const;
+
+    TSharedPtr<FJsonObject> Root;
+
+    FRequestArena* Arena = nullptr;
+
+    //Root of the contents parsed into the arena, is dropped once the
+    //request is extracted so that the arena may be released
+    const FArenaJsonValue* ArenaRoot = nullptr;
+};
@@ -0,0 +1,216 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#include "LinuxHIDManager.h"
+
+#if PLATFORM_LINUX
+
+#include "GamepadDetection.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+namespace
+{
+	//Directory the hidraw nodes are exposed through
+	const char* const kHidrawClassPath = "/sys/class/hidraw";
+
+	//Netlink multicast group the kernel broadcasts uevents to
+	constexpr uint32 kKernelUeventGroup = 1;
+
+	//Netlink multicast group udevd re-broadcasts processed uevents to
+	constexpr uint32 kUdevUeventGroup = 2;
+
+	//Subsystem name which is present in each hidraw-related uevent
+	const char kHidrawSubsystem[] = "hidraw";
+
+	//Prefix of the line of `device/uevent` file which contains bus type,
+	//Vendor ID and Product ID, e.g. `HID_ID=0003:0000054C:000009CC`
+	const char kHIDIDPrefix[] = "HID_ID=";
+}
+
+FLinuxHIDManager::FLinuxHIDManager()
+{
+	// the socket is opened before the first enumeration so that no uevent
+	// which happens in between is lost
+	OpenMonitor();
+}
+
+FLinuxHIDManager::~FLinuxHIDManager()
+{
+	if (MonitorSocket >= 0)
+	{
+		close(MonitorSocket);
+	}
+}
+
+TArray<FHID> FLinuxHIDManager::QueryHIDs()
+{
+	if (MonitorSocket < 0 || DrainMonitor())
+	{
+		bAreCachedHIDsStale = true;
+	}
+
+	if (bAreCachedHIDsStale)
+	{
+		EnumerateHIDs();
+		bAreCachedHIDsStale = MonitorSocket < 0;
+	}
+
+	return CachedHIDs;
+}
+
+void FLinuxHIDManager::OpenMonitor()
+{
+	MonitorSocket = socket(AF_NETLINK,
+		SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+	if (MonitorSocket < 0)
+	{
+		UE_LOG(LogGamepadDetection, Warning,
+			TEXT("Unable to open uevent socket (errno %d). HIDs will be"
+				 " enumerated on each query"), errno);
+		return;
+	}
+
+	// both groups are listened to: the kernel one works without udevd (e.g.
+	// in containers), the udev one is the one libudev monitors use. we only
+	// read sysfs, so it doesn't matter which of them reports first
+	sockaddr_nl Address;
+	FMemory::Memzero(Address);
+	Address.nl_family = AF_NETLINK;
+	Address.nl_groups = kKernelUeventGroup | kUdevUeventGroup;
+
+	if (bind(MonitorSocket, reinterpret_cast<sockaddr*>(&Address),
+		sizeof(Address)) < 0)
+	{
+		UE_LOG(LogGamepadDetection, Warning,
+			TEXT("Unable to bind uevent socket (errno %d). HIDs will be"
+				 " enumerated on each query"), errno);
+
+		close(MonitorSocket);
+		MonitorSocket = -1;
+	}
+}
+
+bool FLinuxHIDManager::DrainMonitor()
+{
+	bool bHasHidrawEvents = false;
+
+	// uevents are limited to 8 KiB by the kernel
+	char Buffer[8192];
+	while (true)
+	{
+		ssize_t Received = recv(MonitorSocket, Buffer, sizeof(Buffer),
+			MSG_DONTWAIT);
+		if (Received < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			// the socket buffer has overflown and some uevents were dropped,
+			// so we can't say for sure whether a HID was (dis)connected
+			if (errno == ENOBUFS)
+			{
+				bHasHidrawEvents = true;
+				continue;
+			}
+
+			break;
+		}
+
+		if (!bHasHidrawEvents && memmem(Buffer, Received, kHidrawSubsystem,
+			sizeof(kHidrawSubsystem) - 1) != nullptr)
+		{
+			bHasHidrawEvents = true;
+		}
+	}
+
+	return bHasHidrawEvents;
+}
+
+void FLinuxHIDManager::EnumerateHIDs()
+{
+	CachedHIDs.Reset();
+
+	DIR* Directory = opendir(kHidrawClassPath);
+	if (Directory == nullptr)
+	{
+		UE_LOG(LogGamepadDetection, Log,
+			TEXT("`%s` is unavailable, no HIDs are connected"),
+			ANSI_TO_TCHAR(kHidrawClassPath));
+		return;
+	}
+
+	while (dirent* Entry = readdir(Directory))
+	{
+		if (strncmp(Entry->d_name, kHidrawSubsystem,
+			sizeof(kHidrawSubsystem) - 1) != 0)
+		{
+			continue;
+		}
+
+		char UeventPath[256];
+		snprintf(UeventPath, sizeof(UeventPath), "%s/%s/device/uevent",
+			kHidrawClassPath, Entry->d_name);
+
+		FHID HID;
+		if (ReadHIDIDs(UeventPath, HID.VendorID, HID.ProductID))
+		{
+			HID.HardwareID = FString(TEXT("/dev/")) +
+				ANSI_TO_TCHAR(Entry->d_name);
+			CachedHIDs.Add(MoveTemp(HID));
+		}
+	}
+
+	closedir(Directory);
+}
+
+bool FLinuxHIDManager::ReadHIDIDs(const char* UeventPath,
+	uint32& OutVendorID, uint32& OutProductID)
+{
+	// sysfs reports 4096 as a size of any attribute, so the file is read
+	// directly instead of going through the platform file layer
+	int File = open(UeventPath, O_RDONLY | O_CLOEXEC);
+	if (File < 0)
+	{
+		return false;
+	}
+
+	char Contents[1024];
+	ssize_t Size = read(File, Contents, sizeof(Contents) - 1);
+	close(File);
+
+	if (Size <= 0)
+	{
+		return false;
+	}
+	Contents[Size] = '\0';
+
+	const char* Line = strstr(Contents, kHIDIDPrefix);
+	if (Line == nullptr)
+	{
+		return false;
+	}
+
+	unsigned int Bus = 0;
+	unsigned int VendorID = 0;
+	unsigned int ProductID = 0;
+	if (sscanf(Line + sizeof(kHIDIDPrefix) - 1, "%x:%x:%x", &Bus, &VendorID,
+		&ProductID) != 3)
+	{
+		return false;
+	}
+
+	OutVendorID = VendorID;
+	OutProductID = ProductID;
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Copyright Flying Wild Hog. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HIDManager.h"
+
+#if PLATFORM_LINUX
+
+/**
+* HID manager which is backed by the Linux hidraw subsystem
+*
+* Vendor and Product IDs of the connected HIDs are read from
+* `/sys/class/hidraw`. The list of HIDs is enumerated once and then cached.
+* A netlink uevent socket (the one udev monitors listen to) is used to find
+* out whether a HID has been attached or detached since the last
+* enumeration, so `QueryHIDs()` re-enumerates HIDs only when something has
+* actually changed. In the steady state a call costs one non-blocking
+* `recv()` and a copy of the cached list.
+*
+* If the uevent socket can't be opened (e.g. in a restricted sandbox) HIDs
+* are enumerated on each call
+*
+* Isn't thread-safe
+*/
+class GAMEPADDETECTION_API FLinuxHIDManager : public FHIDManager
+{
+public:
+	/**
+	* The default constructor. Opens the uevent socket, the enumeration
+	* itself is postponed until the first `QueryHIDs()` call
+	*/
+	FLinuxHIDManager();
+
+	FLinuxHIDManager(const FLinuxHIDManager&) = delete;
+
+	FLinuxHIDManager& operator=(const FLinuxHIDManager&) = delete;
+
+	/**
+	* Returns the list of currently connected HIDs
+	*
+	* `HardwareID` of each returned HID is the path of its hidraw node
+	* (e.g. `/dev/hidraw3`)
+	*
+	* @return The list of currently connected HIDs
+	*/
+	virtual TArray<FHID> QueryHIDs() override;
+
+	/**
+	* Closes the uevent socket
+	*/
+	virtual ~FLinuxHIDManager();
+
+private:
+	/**
+	* Opens a non-blocking netlink socket subscribed to kernel and udev
+	* uevents. Leaves `MonitorSocket` equal to `-1` on failure
+	*/
+	void OpenMonitor();
+
+	/**
+	* Reads all pending uevents from the socket without blocking
+	*
+	* @return `true` if at least one of the pending uevents relates to the
+	* hidraw subsystem, `false` - otherwise
+	*/
+	bool DrainMonitor();
+
+	/**
+	* Walks through `/sys/class/hidraw` and fills `CachedHIDs`
+	*/
+	void EnumerateHIDs();
+
+	/**
+	* Extracts Vendor and Product IDs from `HID_ID` line of a hidraw node's
+	* `device/uevent` file
+	*
+	* @param UeventPath Path to the `uevent` file
+	* @param OutVendorID Vendor ID of the device
+	* @param OutProductID Product ID of the device
+	* @return `true` if the IDs were extracted, `false` - otherwise
+	*/
+	static bool ReadHIDIDs(const char* UeventPath, uint32& OutVendorID,
+		uint32& OutProductID);
+
+	//File descriptor of the uevent socket, `-1` if it's not opened
+	int32 MonitorSocket = -1;
+
+	//Indicates whether `CachedHIDs` has to be re-enumerated
+	bool bAreCachedHIDsStale = true;
+
+	//HIDs found during the last enumeration
+	TArray<FHID> CachedHIDs;
+};
+
+#endif
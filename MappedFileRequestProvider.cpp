@@ -0,0 +1,99 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "MappedFileRequestProvider.h"
+#include "RequestLoaderLog.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    constexpr uint8 Utf8Bom[] = { 0xEF, 0xBB, 0xBF };
+}
+
+FMappedFileRequestProvider::FMappedFileRequestProvider(FString Path)
+    : Path(MoveTemp(Path)) {}
+
+FMappedFileRequestProvider::~FMappedFileRequestProvider()
+{
+    Unmap();
+}
+
+FString FMappedFileRequestProvider::RetrieveContents()
+{
+    TArrayView<const uint8> View = RetrieveView();
+
+    FString Contents;
+    FFileHelper::BufferToString(Contents, View.GetData(), View.Num());
+
+    return Contents;
+}
+
+TArrayView<const uint8> FMappedFileRequestProvider::RetrieveView()
+{
+    if (!Map())
+    {
+        return TArrayView<const uint8>();
+    }
+
+    TArrayView<const uint8> View(MappedRegion->GetMappedPtr(),
+        MappedRegion->GetMappedSize());
+
+    if (View.Num() >= UE_ARRAY_COUNT(Utf8Bom) && FMemory::Memcmp(
+        View.GetData(), Utf8Bom, UE_ARRAY_COUNT(Utf8Bom)) == 0)
+    {
+        View = View.Slice(UE_ARRAY_COUNT(Utf8Bom),
+            View.Num() - UE_ARRAY_COUNT(Utf8Bom));
+    }
+
+    return View;
+}
+
+bool FMappedFileRequestProvider::Map()
+{
+    if (MappedRegion.IsValid())
+    {
+        return true;
+    }
+
+    IPlatformFile& PlatformFile =
+        FPlatformFileManager::Get().GetPlatformFile();
+
+    MappedFile.Reset(PlatformFile.OpenMapped(*Path));
+    if (!MappedFile.IsValid())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to map the request file `%s`"), *Path);
+
+        return false;
+    }
+
+    //An empty file can't be mapped but is a valid, if empty, request
+    if (MappedFile->GetFileSize() == 0)
+    {
+        return false;
+    }
+
+    MappedRegion.Reset(MappedFile->MapRegion());
+    if (!MappedRegion.IsValid())
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Failed to map a region of the request file `%s`"), *Path);
+
+        MappedFile.Reset();
+
+        return false;
+    }
+
+    return true;
+}
+
+void FMappedFileRequestProvider::Unmap()
+{
+    //The region has to go before the file it maps
+    MappedRegion.Reset();
+    MappedFile.Reset();
+}
@@ -0,0 +1,48 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewProvider.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Provides the request stored in a UTF-8 encoded file by mapping the file
+ * read-only into memory
+ *
+ * `RetrieveView()` hands the mapped bytes over as they are, so the contents
+ * are never copied to the heap. `RetrieveContents()` is kept for the
+ * deserializers which need a string and copies the bytes the same way
+ * `FFileHelper::LoadFileToString()` does
+ */
+class FMappedFileRequestProvider : public IRequestViewProvider
+{
+public:
+    /**
+     * @param Path Path to the request file
+     */
+    explicit FMappedFileRequestProvider(FString Path);
+
+    virtual ~FMappedFileRequestProvider() override;
+
+    virtual FString RetrieveContents() override;
+
+    virtual TArrayView<const uint8> RetrieveView() override;
+
+private:
+    //Maps the file unless it's mapped already, returns `false` on failure
+    bool Map();
+
+    void Unmap();
+
+    FString Path;
+
+    TUniquePtr<IMappedFileHandle> MappedFile;
+
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+};
@@ -0,0 +1,27 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "RequestArena.h"
+
+//The stack is used without marks, it's flushed as a whole instead
+FRequestArena::FRequestArena() : Stack(0) {}
+
+void* FRequestArena::Allocate(SIZE_T Size, SIZE_T Alignment)
+{
+    check(Size <= static_cast<SIZE_T>(MAX_int32));
+
+    return Stack.PushBytes(static_cast<int32>(Size),
+        static_cast<int32>(Alignment));
+}
+
+void FRequestArena::Release()
+{
+    Stack.Flush();
+}
+
+int64 FRequestArena::GetNumberOfBytes() const
+{
+    return Stack.GetByteCount();
+}
@@ -0,0 +1,65 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+
+/**
+ * Arena the intermediate state of a deserialization is allocated in
+ *
+ * Memory is handed out from pages of the engine page pool and is released
+ * all at once by `Release()` or by the destructor, nothing is freed on its
+ * own. Only trivially destructible objects are allocated in it, since no
+ * destructor is ever run
+ *
+ * Isn't thread-safe, give each deserializer an arena of its own
+ *
+ * @see IRequestViewDeserializer::SetArena()
+ */
+class FRequestArena
+{
+public:
+    FRequestArena();
+
+    FRequestArena(const FRequestArena&) = delete;
+
+    FRequestArena& operator=(const FRequestArena&) = delete;
+
+    /**
+     * Allocates uninitialized memory which stays valid until the arena is
+     * released
+     */
+    void* Allocate(SIZE_T Size, SIZE_T Alignment);
+
+    /**
+     * Constructs an object in the arena
+     */
+    template <typename T, typename... ArgsType>
+    T* New(ArgsType&&... Args)
+    {
+        static_assert(TIsTriviallyDestructible<T>::Value,
+            "Destructors of the objects in the arena are never run");
+
+        return new(Allocate(sizeof(T), alignof(T)))
+            T(Forward<ArgsType>(Args)...);
+    }
+
+    /**
+     * Releases everything allocated in the arena, the pages go back to the
+     * pool and are reused by the next allocations
+     */
+    void Release();
+
+    /**
+     * @return Count of bytes the arena holds, including the unused ends of
+     * its pages
+     */
+    int64 GetNumberOfBytes() const;
+
+private:
+    FMemStackBase Stack;
+};
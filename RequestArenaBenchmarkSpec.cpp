@@ -0,0 +1,151 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "ExtractionRequest.h"
+#include "RequestArena.h"
+#include "RequestLoaderStats.h"
+#include "AllocationCounter.h"
+#include "RequestSpecHelpers.h"
+#include "JsonRequestDeserializer.h"
+
+namespace
+{
+    //Sizes of the synthetic requests
+    constexpr int32 RequestSizes[] =
+        { 1024, 1024 * 1024, 10 * 1024 * 1024 };
+
+    constexpr int32 NumberOfRepetitions = 3;
+
+    /**
+     * Time and allocations of one deserialization, the best time of the
+     * repetitions is kept
+     */
+    struct FMeasurement
+    {
+        double ParseTime = MAX_dbl;
+
+        double ExtractTime = MAX_dbl;
+
+        //Time of destroying the intermediate state and the request
+        double ReleaseTime = MAX_dbl;
+
+        uint64 ParseAllocations = 0;
+
+        uint64 ExtractAllocations = 0;
+
+        int64 ArenaBytes = 0;
+    };
+}
+
+/**
+ * Compares deserializing JSON requests into a DOM with deserializing them
+ * into an arena, by the time and by the count of heap allocations of
+ * parsing the contents and of extracting the request
+ */
+BEGIN_DEFINE_SPEC(FRequestArenaBenchmarkSpec,
+                  "XYZProduct.Benchmark.RequestArena",
+                  EAutomationTestFlags::PerfFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+//Counts the allocations of the deserializations while a test runs
+TUniquePtr<FAllocationCounter> AllocationCounter;
+
+/**
+ * Deserializes the contents with or without an arena and reports the times
+ * and the allocations
+ */
+void Measure(const FString& Name, TArrayView<const uint8> Contents,
+    FRequestArena* Arena)
+{
+    FMeasurement Measurement;
+    for (int32 i = 0; i < NumberOfRepetitions; i++)
+    {
+        TUniquePtr<FJsonRequestDeserializer> Deserializer =
+            MakeUnique<FJsonRequestDeserializer>();
+        Deserializer->SetArena(Arena);
+
+        uint64 Allocations =
+            FAllocationCounter::GetNumberOfThreadAllocations();
+        double StartTime = FPlatformTime::Seconds();
+        Deserializer->DeserializeView(Contents);
+        double ParseTime = FPlatformTime::Seconds() - StartTime;
+        Measurement.ParseAllocations =
+            FAllocationCounter::GetNumberOfThreadAllocations() -
+            Allocations;
+
+        Allocations = FAllocationCounter::GetNumberOfThreadAllocations();
+        StartTime = FPlatformTime::Seconds();
+        Deserializer->ExtractVersion();
+        TUniquePtr<FExtractionRequest> Request =
+            Deserializer->ExtractRequest();
+        double ExtractTime = FPlatformTime::Seconds() - StartTime;
+        Measurement.ExtractAllocations =
+            FAllocationCounter::GetNumberOfThreadAllocations() -
+            Allocations;
+
+        TestTrue(FString::Printf(TEXT("%s: expecting the request to be "
+            "extracted"), *Name), Request.IsValid());
+
+        Measurement.ArenaBytes =
+            Arena != nullptr ? Arena->GetNumberOfBytes() : 0;
+
+        StartTime = FPlatformTime::Seconds();
+        Request.Reset();
+        Deserializer.Reset();
+        if (Arena != nullptr)
+        {
+            Arena->Release();
+        }
+        double ReleaseTime = FPlatformTime::Seconds() - StartTime;
+
+        Measurement.ParseTime = FMath::Min(Measurement.ParseTime, ParseTime);
+        Measurement.ExtractTime =
+            FMath::Min(Measurement.ExtractTime, ExtractTime);
+        Measurement.ReleaseTime =
+            FMath::Min(Measurement.ReleaseTime, ReleaseTime);
+    }
+
+    AddInfo(FString::Printf(TEXT("%s: parse %.2f ms / %llu allocations, "
+        "extract %.2f ms / %llu, release %.2f ms, %lld bytes in the arena"),
+        *Name, Measurement.ParseTime * 1000.0, Measurement.ParseAllocations,
+        Measurement.ExtractTime * 1000.0, Measurement.ExtractAllocations,
+        Measurement.ReleaseTime * 1000.0, Measurement.ArenaBytes));
+}
+
+END_DEFINE_SPEC(FRequestArenaBenchmarkSpec)
+
+void FRequestArenaBenchmarkSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        AllocationCounter = MakeUnique<FAllocationCounter>();
+    });
+
+    AfterEach([this]()
+    {
+        AllocationCounter.Reset();
+    });
+
+    for (int32 Size : RequestSizes)
+    {
+        It(FString::Printf(TEXT("%d bytes"), Size), [this, Size]()
+        {
+            TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(
+                FRequestSpecHelpers::MakeRequest(Size));
+            AddInfo(FString::Printf(TEXT("Request of %d bytes"),
+                Contents.Num()));
+
+            Measure(TEXT("DOM"), Contents, nullptr);
+
+            //The arena outlives the repetitions, so that the later ones
+            //reuse its pages the way a loader reusing an arena does
+            FRequestArena Arena;
+            Measure(TEXT("Arena"), Contents, &Arena);
+        });
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "RequestBatchLoader.h"
+#include "RequestLoader.h"
+#include "JsonRequestDeserializer.h"
+#include "MappedFileRequestProvider.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Templates/Atomic.h"
+
+FRequestBatchLoader::FRequestBatchLoader(int32 MaxConcurrency)
+    : MaxConcurrency(MaxConcurrency > 0 ? MaxConcurrency
+        : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1) {}
+
+TArray<FRequestLoadResult> FRequestBatchLoader::LoadRequests(
+    int32 NumberOfRequests, const LoaderFactoryType& LoaderFactory) const
+{
+    TArray<FRequestLoadResult> Results;
+    Results.SetNum(NumberOfRequests);
+
+    //Requests are handed out one at a time rather than split into equal
+    //ranges up front, so a task which gets small requests takes more
+    TAtomic<int32> NextIndex(0);
+    auto LoadNextRequests = [&Results, &NextIndex, &LoaderFactory,
+        NumberOfRequests]()
+    {
+        for (int32 Index = NextIndex++; Index < NumberOfRequests;
+            Index = NextIndex++)
+        {
+            TUniquePtr<FRequestLoader> Loader = LoaderFactory(Index);
+            if (Loader.IsValid())
+            {
+                FRequestLoadResult& Result = Results[Index];
+                Result.Request = Loader->LoadRequest(Result.Status);
+            }
+        }
+    };
+
+    //The calling thread is one of the loading threads
+    int32 NumberOfTasks =
+        FMath::Max(FMath::Min(MaxConcurrency, NumberOfRequests) - 1, 0);
+
+    FGraphEventArray Tasks;
+    Tasks.Reserve(NumberOfTasks);
+    for (int32 i = 0; i < NumberOfTasks; i++)
+    {
+        Tasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+            LoadNextRequests, TStatId(), nullptr,
+            ENamedThreads::AnyBackgroundThreadNormalTask));
+    }
+
+    LoadNextRequests();
+
+    FTaskGraphInterface::Get().WaitUntilTasksComplete(Tasks);
+
+    return Results;
+}
+
+TArray<FRequestLoadResult> FRequestBatchLoader::LoadRequestFiles(
+    const TArray<FString>& Paths) const
+{
+    return LoadRequests(Paths.Num(), [&Paths](int32 Index)
+    {
+        return MakeUnique<FRequestLoader>(
+            TUniquePtr<IRequestViewProvider>(
+                MakeUnique<FMappedFileRequestProvider>(Paths[Index])),
+            TUniquePtr<IRequestViewDeserializer>(
+                MakeUnique<FJsonRequestDeserializer>()));
+    });
+}
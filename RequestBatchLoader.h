@@ -0,0 +1,56 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RequestLoadStatus.h"
+
+class FRequestLoader;
+
+/**
+ * Loads many requests at once on the task graph
+ *
+ * Every request is loaded by a loader of its own, made by the factory on
+ * the task which loads it, so no provider or deserializer is shared
+ * between tasks. At most `MaxConcurrency` requests are loaded at once, the
+ * calling thread loads requests as well instead of just waiting
+ */
+class FRequestBatchLoader
+{
+public:
+    //Creates a loader for the request of the given index, is called from
+    //many threads at once
+    using LoaderFactoryType =
+        TFunction<TUniquePtr<FRequestLoader>(int32 Index)>;
+
+    /**
+     * @param MaxConcurrency How many requests may be loaded at once, the
+     * default is one per worker thread and one for the calling thread
+     */
+    explicit FRequestBatchLoader(int32 MaxConcurrency = 0);
+
+    /**
+     * Loads the requests and waits for all of them
+     *
+     * @param NumberOfRequests How many requests to load
+     * @param LoaderFactory Factory of the loaders
+     * @return Results in the order of the indices
+     */
+    TArray<FRequestLoadResult> LoadRequests(int32 NumberOfRequests,
+        const LoaderFactoryType& LoaderFactory) const;
+
+    /**
+     * Loads JSON request files, each of them is mapped into memory
+     *
+     * @param Paths Paths to the files
+     * @return Results in the order of the paths
+     */
+    TArray<FRequestLoadResult> LoadRequestFiles(
+        const TArray<FString>& Paths) const;
+
+private:
+    const int32 MaxConcurrency;
+};
@@ -0,0 +1,216 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTLS.h"
+#include "version.h"
+#include "ExtractionRequest.h"
+#include "RequestLoader.h"
+#include "RequestBatchLoader.h"
+#include "JsonRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+
+BEGIN_DEFINE_SPEC(FRequestBatchLoaderSpec,
+                  "XYZProduct.Loading.RequestBatchLoader",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FString Directory;
+
+//Requests of growing sizes, the one of index `i` has `i + 1` elements
+TArray<FExtractionRequest> Requests;
+
+TArray<TArray<uint8>> Contents;
+
+//Loads `Contents` from memory
+TArray<FRequestLoadResult> LoadContents(int32 MaxConcurrency,
+    TSet<uint32>& OutThreadIds)
+{
+    FCriticalSection CriticalSection;
+
+    return FRequestBatchLoader(MaxConcurrency).LoadRequests(Contents.Num(),
+        [this, &CriticalSection, &OutThreadIds](int32 Index)
+        {
+            {
+                FScopeLock Lock(&CriticalSection);
+                OutThreadIds.Add(FPlatformTLS::GetCurrentThreadId());
+            }
+
+            return MakeUnique<FRequestLoader>(
+                TUniquePtr<IRequestViewProvider>(
+                    MakeUnique<FMemoryRequestProvider>(Contents[Index])),
+                TUniquePtr<IRequestViewDeserializer>(
+                    MakeUnique<FJsonRequestDeserializer>()));
+        });
+}
+
+void CheckLoaded(const FString& What,
+    const TArray<FRequestLoadResult>& Results)
+{
+    if (!TestEqual(What + TEXT(": expecting a result per request"),
+        Results.Num(), Requests.Num()))
+    {
+        return;
+    }
+
+    for (int32 i = 0; i < Results.Num(); i++)
+    {
+        FString Name = FString::Printf(TEXT("%s: request %d"), *What, i);
+        if (TestTrue(Name + TEXT(" expecting to load"),
+            Results[i].Status == ERequestLoadStatus::Loaded &&
+            Results[i].Request.IsValid()))
+        {
+            TestEqual(Name + TEXT(" expecting the request of its index"),
+                FRequestSpecHelpers::Export(*Results[i].Request),
+                FRequestSpecHelpers::Export(Requests[i]));
+        }
+    }
+}
+
+END_DEFINE_SPEC(FRequestBatchLoaderSpec)
+
+void FRequestBatchLoaderSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Directory = FPaths::Combine(FPaths::AutomationTransientDir(),
+            TEXT("RequestBatchLoader"));
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+        Requests.Reset();
+        Contents.Reset();
+        for (int32 i = 0; i < 8; i++)
+        {
+            FExtractionRequest& Request = Requests.AddDefaulted_GetRef();
+            FRequestSpecHelpers::ResizeArrays(Request, i + 1);
+            Contents.Add(FRequestSpecHelpers::ToUtf8(
+                FRequestSpecHelpers::ToJson(Request)));
+        }
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    });
+
+    It("Reports the outcome of every file in order",
+        [this]()
+        {
+            AddExpectedError(TEXT("the plugin version mismatch"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+            AddExpectedError(TEXT("Failed to map the request file"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+            AddExpectedError(TEXT("Failed to parse the request"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+            AddExpectedError(TEXT("has no `version` field"),
+                EAutomationExpectedErrorFlags::Contains, 1);
+
+            FString LoadedPath = FPaths::Combine(Directory,
+                TEXT("Loaded.json"));
+            FFileHelper::SaveArrayToFile(Contents[0], *LoadedPath);
+
+            FString NewerPath = FPaths::Combine(Directory,
+                TEXT("Newer.json"));
+            FFileHelper::SaveStringToFile(FString::Printf(
+                TEXT("{\"version\": \"%d.0.0\"}"), VERSION_MAJOR + 1),
+                *NewerPath);
+
+            TArray<FString> Paths = { LoadedPath, NewerPath,
+                FPaths::Combine(Directory, TEXT("Missing.json")),
+                LoadedPath };
+            TArray<FRequestLoadResult> Results =
+                FRequestBatchLoader(2).LoadRequestFiles(Paths);
+            if (!TestEqual(TEXT("Expecting a result per file"),
+                Results.Num(), Paths.Num()))
+            {
+                return;
+            }
+
+            for (int32 i : { 0, 3 })
+            {
+                TestTrue(FString::Printf(TEXT("Expecting file %d to load"),
+                    i), Results[i].Status == ERequestLoadStatus::Loaded &&
+                    Results[i].Request.IsValid());
+            }
+            TestTrue(TEXT("Expecting the newer file to mismatch"),
+                Results[1].Status == ERequestLoadStatus::VersionMismatch &&
+                !Results[1].Request.IsValid());
+            TestTrue(TEXT("Expecting the missing file to fail"),
+                Results[2].Status == ERequestLoadStatus::Failed &&
+                !Results[2].Request.IsValid());
+        }
+    );
+
+    It("Loads on the calling thread alone one at a time",
+        [this]()
+        {
+            TSet<uint32> ThreadIds;
+            CheckLoaded(TEXT("One at a time"), LoadContents(1, ThreadIds));
+
+            TestTrue(TEXT("Expecting only the calling thread to load"),
+                ThreadIds.Num() == 1 &&
+                ThreadIds.Contains(FPlatformTLS::GetCurrentThreadId()));
+        }
+    );
+
+    It("Loads the same requests many at a time",
+        [this]()
+        {
+            TSet<uint32> ThreadIds;
+            CheckLoaded(TEXT("Many at a time"), LoadContents(4, ThreadIds));
+
+            TestTrue(TEXT("Expecting at most 4 loading threads"),
+                ThreadIds.Num() <= 4);
+            CheckLoaded(TEXT("Default concurrency"),
+                LoadContents(0, ThreadIds));
+        }
+    );
+
+    It("Fails a request without a loader",
+        [this]()
+        {
+            TArray<FRequestLoadResult> Results =
+                FRequestBatchLoader(4).LoadRequests(Contents.Num(),
+                    [this](int32 Index) -> TUniquePtr<FRequestLoader>
+                    {
+                        if (Index % 2 == 1)
+                        {
+                            return nullptr;
+                        }
+
+                        return MakeUnique<FRequestLoader>(
+                            TUniquePtr<IRequestViewProvider>(
+                                MakeUnique<FMemoryRequestProvider>(
+                                    Contents[Index])),
+                            TUniquePtr<IRequestViewDeserializer>(
+                                MakeUnique<FJsonRequestDeserializer>()));
+                    });
+            if (!TestEqual(TEXT("Expecting a result per request"),
+                Results.Num(), Contents.Num()))
+            {
+                return;
+            }
+
+            for (int32 i = 0; i < Results.Num(); i++)
+            {
+                bool bIsLoaded =
+                    Results[i].Status == ERequestLoadStatus::Loaded &&
+                    Results[i].Request.IsValid();
+                bool bIsFailed =
+                    Results[i].Status == ERequestLoadStatus::Failed &&
+                    !Results[i].Request.IsValid();
+                TestTrue(FString::Printf(TEXT("Expecting request %d to %s"),
+                    i, i % 2 == 1 ? TEXT("fail") : TEXT("load")),
+                    i % 2 == 1 ? bIsFailed : bIsLoaded);
+            }
+        }
+    );
+}
@@ -0,0 +1,34 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExtractionRequest.h"
+
+/**
+ * Outcome of loading a request
+ */
+enum class ERequestLoadStatus : uint8
+{
+    Loaded,
+
+    //The request requires a newer version of the plugin
+    VersionMismatch,
+
+    //The request can't be retrieved or deserialized
+    Failed
+};
+
+/**
+ * Outcome of loading a request together with the request
+ */
+struct FRequestLoadResult
+{
+    //The request, `nullptr` unless it's loaded
+    TUniquePtr<FExtractionRequest> Request;
+
+    ERequestLoadStatus Status = ERequestLoadStatus::Failed;
+};
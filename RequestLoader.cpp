@@ -1,39 +1,329 @@
 ﻿#include "RequestLoader.h"
+#include "RequestLoaderLog.h"
 #include "version.h"
+#include "Async/Async.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.inl"
 
-DEFINE_LOG_CATEGORY_STATIC(LogXYZProductRequestLoader, All, All);
+DEFINE_LOG_CATEGORY(LogXYZProductRequestLoader)
 
-FRequestLoader::FRequestLoader(
-    TUniquePtr<IRequestProvider> RequestProvider,
-    TUniquePtr<IRequestDeserializer> RequestDeserializer)
-        : RequestProvider(MoveTemp(RequestProvider)),
-          RequestDeserializer(MoveTemp(RequestDeserializer)) {}
+UE_TRACE_CHANNEL_DEFINE(RequestLoaderChannel)
 
-TUniquePtr<FExtractionRequest> FRequestLoader::LoadRequest() const
+//Reported once per `LoadRequest()`, whatever its outcome
+UE_TRACE_EVENT_BEGIN(RequestLoader, Load)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint64, BytesRetrieved)
+    UE_TRACE_EVENT_FIELD(uint64, Allocations)
+UE_TRACE_EVENT_END()
+
+namespace
 {
-    FString Contents = RequestProvider->RetrieveContents();
+    /**
+     * Adds the time spent and the allocations made in the scope to
+     * counters
+     */
+    class FScopedPhaseAccumulator
+    {
+    public:
+        FScopedPhaseAccumulator(uint64& Cycles, uint64& Allocations)
+            : Cycles(Cycles), Allocations(Allocations),
+              StartCycles(FPlatformTime::Cycles64()),
+              StartAllocations(
+                  FRequestLoaderAllocationHook::GetNumberOfAllocations()) {}
 
-    RequestDeserializer->Deserialize(MoveTemp(Contents));
-    
-    FVersion RequiredVersion = RequestDeserializer->ExtractVersion();
+        ~FScopedPhaseAccumulator()
+        {
+            Cycles += FPlatformTime::Cycles64() - StartCycles;
+            Allocations +=
+                FRequestLoaderAllocationHook::GetNumberOfAllocations() -
+                StartAllocations;
+        }
 
-    if (!CheckVersionsCompatibility(RequiredVersion))
+    private:
+        uint64& Cycles;
+
+        uint64& Allocations;
+
+        uint64 StartCycles;
+
+        uint64 StartAllocations;
+    };
+
+    /**
+     * Reports the bytes retrieved and the allocations made in the scope
+     * through `RequestLoaderChannel` when the scope ends
+     */
+    class FScopedLoadTrace
+    {
+    public:
+        explicit FScopedLoadTrace(const FRequestLoaderStats& Stats)
+            : Stats(Stats), StartBytes(Stats.NumberOfBytesRetrieved),
+              StartAllocations(
+                  FRequestLoaderAllocationHook::GetNumberOfAllocations()) {}
+
+        ~FScopedLoadTrace()
+        {
+            UE_TRACE_LOG(RequestLoader, Load, RequestLoaderChannel)
+                << Load.Cycle(FPlatformTime::Cycles64())
+                << Load.BytesRetrieved(
+                    Stats.NumberOfBytesRetrieved - StartBytes)
+                << Load.Allocations(
+                    FRequestLoaderAllocationHook::GetNumberOfAllocations() -
+                    StartAllocations);
+        }
+
+    private:
+        const FRequestLoaderStats& Stats;
+
+        uint64 StartBytes;
+
+        uint64 StartAllocations;
+    };
+
+    //How many first bytes of the contents are looked at for the version,
+    //is a page, the only one of a mapped file which gets touched for an
+    //incompatible request
+    constexpr int32 VersionPeekSize = 4096;
+
+    bool PeekVersion(IRequestViewDeserializer& Deserializer,
+        TArrayView<const uint8> Contents, FVersion& OutVersion)
+    {
+        return Deserializer.PeekVersion(Contents.Slice(0,
+            FMath::Min(Contents.Num(), VersionPeekSize)), OutVersion);
+    }
+
+    void LogVersionsMismatch(const FVersion& RequiredVersion)
     {
         FString RequiredVersionString = FString::Printf(TEXT("%d.%d.%d"),
             RequiredVersion.Major, RequiredVersion.Minor,
             RequiredVersion.Index);
         FString PluginVersionString = FString::Printf(TEXT("%d.%d.%d"),
             VERSION_MAJOR, VERSION_MINOR, VERSION_INDEX);
-        
+
         UE_LOG(LogXYZProductRequestLoader, Error,
             TEXT("The required version and the plugin version mismatch: "
                  "%s against %s"),
             *RequiredVersionString, *PluginVersionString);
+    }
+}
+
+TAtomic<FRequestLoaderAllocationHook::FGetNumberOfAllocations>
+    FRequestLoaderAllocationHook::Function(nullptr);
+
+void FRequestLoaderAllocationHook::Set(FGetNumberOfAllocations Function)
+{
+    FRequestLoaderAllocationHook::Function = Function;
+}
+
+uint64 FRequestLoaderAllocationHook::GetNumberOfAllocations()
+{
+    FGetNumberOfAllocations CurrentFunction = Function;
+
+    return CurrentFunction != nullptr ? CurrentFunction() : 0;
+}
+
+FRequestLoader::FRequestLoader(
+    TUniquePtr<IRequestProvider> RequestProvider,
+    TUniquePtr<IRequestDeserializer> RequestDeserializer)
+        : RequestProvider(MoveTemp(RequestProvider)),
+          RequestDeserializer(MoveTemp(RequestDeserializer)) {}
+
+FRequestLoader::FRequestLoader(
+    TUniquePtr<IRequestViewProvider> RequestProvider,
+    TUniquePtr<IRequestViewDeserializer> RequestDeserializer)
+        : RequestProvider(MoveTemp(RequestProvider)),
+          RequestDeserializer(MoveTemp(RequestDeserializer))
+{
+    RequestViewProvider =
+        static_cast<IRequestViewProvider*>(this->RequestProvider.Get());
+    RequestViewDeserializer =
+        static_cast<IRequestViewDeserializer*>(
+            this->RequestDeserializer.Get());
+}
+
+TUniquePtr<FExtractionRequest> FRequestLoader::LoadRequest() const
+{
+    ERequestLoadStatus Status;
+
+    return LoadRequest(Status);
+}
+
+TUniquePtr<FExtractionRequest> FRequestLoader::LoadRequest(
+    ERequestLoadStatus& OutStatus) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FRequestLoader_LoadRequest,
+        RequestLoaderChannel);
+    FScopedLoadTrace LoadTrace(Stats);
+
+    OutStatus = ERequestLoadStatus::Failed;
+    Stats.NumberOfLoads++;
+
+    if (RequestViewProvider != nullptr && RequestViewDeserializer != nullptr)
+    {
+        TArrayView<const uint8> Contents;
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+                FRequestLoader_RetrieveContents, RequestLoaderChannel);
+            FScopedPhaseAccumulator Accumulator(Stats.RetrieveContentsCycles,
+                Stats.RetrieveContentsAllocations);
+
+            Contents = RequestViewProvider->RetrieveView();
+        }
+        Stats.NumberOfBytesRetrieved += Contents.Num();
+
+        FVersion PeekedVersion;
+        bool bIsPeekedVersionCompatible;
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+                FRequestLoader_PeekVersion, RequestLoaderChannel);
+            FScopedPhaseAccumulator Accumulator(Stats.ExtractVersionCycles,
+                Stats.ExtractVersionAllocations);
+
+            bIsPeekedVersionCompatible = !PeekVersion(
+                *RequestViewDeserializer, Contents, PeekedVersion) ||
+                CheckVersionsCompatibility(PeekedVersion);
+        }
+
+        if (!bIsPeekedVersionCompatible)
+        {
+            LogVersionsMismatch(PeekedVersion);
+            OutStatus = ERequestLoadStatus::VersionMismatch;
+
+            return nullptr;
+        }
+
+        TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FRequestLoader_Deserialize,
+            RequestLoaderChannel);
+        FScopedPhaseAccumulator Accumulator(Stats.DeserializeCycles,
+            Stats.DeserializeAllocations);
+
+        //The contents are parsed where the provider holds them, no copy
+        //of a possibly huge request is made
+        RequestViewDeserializer->DeserializeView(Contents);
+    }
+    else
+    {
+        FString Contents;
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+                FRequestLoader_RetrieveContents, RequestLoaderChannel);
+            FScopedPhaseAccumulator Accumulator(Stats.RetrieveContentsCycles,
+                Stats.RetrieveContentsAllocations);
+
+            Contents = RequestProvider->RetrieveContents();
+        }
+        Stats.NumberOfBytesRetrieved += Contents.Len() * sizeof(TCHAR);
+
+        TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FRequestLoader_Deserialize,
+            RequestLoaderChannel);
+        FScopedPhaseAccumulator Accumulator(Stats.DeserializeCycles,
+            Stats.DeserializeAllocations);
+
+        RequestDeserializer->Deserialize(MoveTemp(Contents));
+    }
+    
+    FVersion RequiredVersion;
+    bool bIsVersionCompatible;
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+            FRequestLoader_ExtractVersion, RequestLoaderChannel);
+        FScopedPhaseAccumulator Accumulator(Stats.ExtractVersionCycles,
+            Stats.ExtractVersionAllocations);
+
+        RequiredVersion = RequestDeserializer->ExtractVersion();
+        bIsVersionCompatible = CheckVersionsCompatibility(RequiredVersion);
+    }
+
+    if (!bIsVersionCompatible)
+    {
+        LogVersionsMismatch(RequiredVersion);
+        OutStatus = ERequestLoadStatus::VersionMismatch;
 
         return nullptr;
     }
     
-    return RequestDeserializer->ExtractRequest();
+    TUniquePtr<FExtractionRequest> Request;
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(
+            FRequestLoader_ExtractRequest, RequestLoaderChannel);
+        FScopedPhaseAccumulator Accumulator(Stats.ExtractRequestCycles,
+            Stats.ExtractRequestAllocations);
+
+        Request = RequestDeserializer->ExtractRequest();
+    }
+
+    if (Request.IsValid())
+    {
+        OutStatus = ERequestLoadStatus::Loaded;
+    }
+
+    return Request;
+}
+
+TFuture<FRequestLoadResult> FRequestLoader::LoadRequestAsync() const
+{
+    return Async(EAsyncExecution::ThreadPool, [this]()
+    {
+        FRequestLoadResult Result;
+        Result.Request = LoadRequest(Result.Status);
+
+        return Result;
+    });
+}
+
+TUniquePtr<IRequestSections> FRequestLoader::LoadRequestSections() const
+{
+    if (RequestViewProvider == nullptr || RequestViewDeserializer == nullptr)
+    {
+        UE_LOG(LogXYZProductRequestLoader, Error,
+            TEXT("Lazy loading requires a view provider and a view "
+                 "deserializer"));
+
+        return nullptr;
+    }
+
+    TArrayView<const uint8> Contents = RequestViewProvider->RetrieveView();
+
+    FVersion PeekedVersion;
+    if (PeekVersion(*RequestViewDeserializer, Contents, PeekedVersion)
+        && !CheckVersionsCompatibility(PeekedVersion))
+    {
+        LogVersionsMismatch(PeekedVersion);
+
+        return nullptr;
+    }
+
+    TUniquePtr<IRequestSections> Sections =
+        RequestViewDeserializer->DeserializeViewLazily(Contents);
+    if (!Sections.IsValid())
+    {
+        return nullptr;
+    }
+
+    FVersion RequiredVersion;
+    if (!Sections->ExtractVersion(RequiredVersion))
+    {
+        return nullptr;
+    }
+
+    if (!CheckVersionsCompatibility(RequiredVersion))
+    {
+        LogVersionsMismatch(RequiredVersion);
+
+        return nullptr;
+    }
+
+    return Sections;
+}
+
+const FRequestLoaderStats& FRequestLoader::GetStats() const
+{
+    return Stats;
+}
+
+void FRequestLoader::ResetStats()
+{
+    Stats = FRequestLoaderStats();
 }
 
 bool FRequestLoader::CheckVersionsCompatibility(
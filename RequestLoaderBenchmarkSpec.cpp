@@ -0,0 +1,307 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "RequestLoader.h"
+#include "RequestBatchLoader.h"
+#include "RequestPrefetchQueue.h"
+#include "RequestLoaderStats.h"
+#include "AllocationCounter.h"
+#include "RequestSpecHelpers.h"
+#include "MappedFileRequestProvider.h"
+#include "CompressedRequestProvider.h"
+#include "JsonRequestDeserializer.h"
+#include "BinaryRequestDeserializer.h"
+#include "CachedRequestDeserializer.h"
+
+namespace
+{
+    //Sizes of the synthetic requests
+    constexpr int32 RequestSizes[] =
+        { 1024, 1024 * 1024, 10 * 1024 * 1024, 100 * 1024 * 1024 };
+
+    //Batch the throughput of `FRequestBatchLoader` is measured on
+    constexpr int32 BatchSize = 64;
+    constexpr int32 BatchRequestSize = 256 * 1024;
+
+    //How many requests of the batch are loaded at once, `0` is the default
+    //of one per worker thread and one for the calling thread
+    constexpr int32 BatchConcurrencies[] = { 1, 2, 4, 8, 0 };
+
+    //Requests handed out by `FRequestPrefetchQueue` and how long the
+    //extraction of each of them is simulated to take
+    constexpr int32 PrefetchSize = 16;
+    constexpr int32 PrefetchRequestSize = 1024 * 1024;
+    constexpr float ExtractionSeconds = 0.02f;
+
+    constexpr int32 PrefetchDepths[] = { 1, 2, 4 };
+}
+
+/**
+ * Loads synthetic requests of growing sizes with each provider and
+ * deserializer and reports where the time and the allocations go
+ *
+ * The requests are built from `FExtractionRequest` itself, so they are
+ * only as big as its arrays allow: a request without arrays is reported
+ * at its natural size
+ */
+BEGIN_DEFINE_SPEC(FRequestLoaderBenchmarkSpec,
+                  "XYZProduct.Benchmark.RequestLoader",
+                  EAutomationTestFlags::PerfFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FString Directory;
+
+//Counts the allocations of the loading phases while a test runs
+TUniquePtr<FAllocationCounter> AllocationCounter;
+
+void Measure(const FString& Name, const FRequestLoader& Loader)
+{
+    ERequestLoadStatus Status;
+    double StartTime = FPlatformTime::Seconds();
+    TUniquePtr<FExtractionRequest> Request = Loader.LoadRequest(Status);
+    double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+    TestTrue(FString::Printf(TEXT("%s: expecting the request to load"),
+        *Name), Status == ERequestLoadStatus::Loaded);
+
+    const FRequestLoaderStats& Stats = Loader.GetStats();
+    AddInfo(FString::Printf(TEXT("%s: %.2f ms, %llu bytes; retrieve "
+        "%.2f ms / %llu allocations, deserialize %.2f ms / %llu, version "
+        "%.2f ms / %llu, extract %.2f ms / %llu"), *Name,
+        ElapsedTime * 1000.0, Stats.NumberOfBytesRetrieved,
+        FPlatformTime::ToMilliseconds64(Stats.RetrieveContentsCycles),
+        Stats.RetrieveContentsAllocations,
+        FPlatformTime::ToMilliseconds64(Stats.DeserializeCycles),
+        Stats.DeserializeAllocations,
+        FPlatformTime::ToMilliseconds64(Stats.ExtractVersionCycles),
+        Stats.ExtractVersionAllocations,
+        FPlatformTime::ToMilliseconds64(Stats.ExtractRequestCycles),
+        Stats.ExtractRequestAllocations));
+}
+
+void MeasureSize(int32 Size)
+{
+    TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(
+        FRequestSpecHelpers::MakeRequest(Size));
+
+    AddInfo(FString::Printf(TEXT("Request of %d bytes"), Contents.Num()));
+
+    FString TextPath = FPaths::Combine(Directory, TEXT("Request.json"));
+    FFileHelper::SaveArrayToFile(Contents, *TextPath);
+
+    TArray<uint8> Compressed;
+    FString CompressedPath = FPaths::Combine(Directory, TEXT("Request.xyzc"));
+    FCompressedRequestProvider::Compress(Contents,
+        FCompressedRequestProvider::EMethod::Zlib, Compressed);
+    FFileHelper::SaveArrayToFile(Compressed, *CompressedPath);
+
+    FString BinaryPath = FPaths::Combine(Directory, TEXT("Request.bin"));
+    FBinaryRequestDeserializer::ConvertFromText(TextPath, BinaryPath);
+
+    Measure(TEXT("Mapped file, JSON from a string"), FRequestLoader(
+        TUniquePtr<IRequestProvider>(
+            MakeUnique<FMappedFileRequestProvider>(TextPath)),
+        TUniquePtr<IRequestDeserializer>(
+            MakeUnique<FJsonRequestDeserializer>())));
+
+    Measure(TEXT("Mapped file, JSON from a view"), FRequestLoader(
+        TUniquePtr<IRequestViewProvider>(
+            MakeUnique<FMappedFileRequestProvider>(TextPath)),
+        TUniquePtr<IRequestViewDeserializer>(
+            MakeUnique<FJsonRequestDeserializer>())));
+
+    Measure(TEXT("Zlib-compressed file, JSON from a view"), FRequestLoader(
+        TUniquePtr<IRequestViewProvider>(
+            MakeUnique<FCompressedRequestProvider>(
+                MakeUnique<FMappedFileRequestProvider>(CompressedPath))),
+        TUniquePtr<IRequestViewDeserializer>(
+            MakeUnique<FJsonRequestDeserializer>())));
+
+    Measure(TEXT("Mapped file, binary"), FRequestLoader(
+        TUniquePtr<IRequestViewProvider>(
+            MakeUnique<FMappedFileRequestProvider>(BinaryPath)),
+        TUniquePtr<IRequestViewDeserializer>(
+            MakeUnique<FBinaryRequestDeserializer>())));
+
+    //The first load fills the cache, the second one hits it
+    FString CachePath = FPaths::Combine(Directory, TEXT("Cache"));
+    for (const TCHAR* Name : { TEXT("Mapped file, cold cache"),
+        TEXT("Mapped file, warm cache") })
+    {
+        Measure(Name, FRequestLoader(
+            TUniquePtr<IRequestViewProvider>(
+                MakeUnique<FMappedFileRequestProvider>(TextPath)),
+            TUniquePtr<IRequestViewDeserializer>(
+                MakeUnique<FCachedRequestDeserializer>(
+                    MakeUnique<FJsonRequestDeserializer>(), CachePath))));
+    }
+}
+
+void MeasureBatch()
+{
+    TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(
+        FRequestSpecHelpers::MakeRequest(BatchRequestSize));
+
+    TArray<FString> Paths;
+    for (int32 i = 0; i < BatchSize; i++)
+    {
+        FString& Path = Paths.Add_GetRef(FPaths::Combine(Directory,
+            FString::Printf(TEXT("Batch%d.json"), i)));
+        FFileHelper::SaveArrayToFile(Contents, *Path);
+    }
+
+    AddInfo(FString::Printf(TEXT("Batch of %d requests of %d bytes"),
+        BatchSize, Contents.Num()));
+
+    double NumberOfMegabytes =
+        static_cast<double>(Contents.Num()) * BatchSize / (1024.0 * 1024.0);
+    for (int32 MaxConcurrency : BatchConcurrencies)
+    {
+        double StartTime = FPlatformTime::Seconds();
+        TArray<FRequestLoadResult> Results =
+            FRequestBatchLoader(MaxConcurrency).LoadRequestFiles(Paths);
+        double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+        int32 NumberOfLoaded = 0;
+        for (const FRequestLoadResult& Result : Results)
+        {
+            NumberOfLoaded += Result.Status == ERequestLoadStatus::Loaded;
+        }
+
+        FString Name = MaxConcurrency > 0 ?
+            FString::Printf(TEXT("%d at once"), MaxConcurrency) :
+            FString(TEXT("Default concurrency"));
+        TestEqual(FString::Printf(TEXT("%s: expecting the requests to load"),
+            *Name), NumberOfLoaded, BatchSize);
+
+        AddInfo(FString::Printf(TEXT("%s: %.2f ms, %.1f requests/s, "
+            "%.1f MB/s"), *Name, ElapsedTime * 1000.0,
+            BatchSize / ElapsedTime, NumberOfMegabytes / ElapsedTime));
+    }
+}
+
+/**
+ * Hands requests out one by one with a simulated extraction after each of
+ * them, first loading each request only when it's needed and then through
+ * the prefetch queue. The load time the caller no longer waits for is the
+ * latency the queue hides
+ */
+void MeasurePrefetch()
+{
+    TArray<uint8> Contents = FRequestSpecHelpers::ToUtf8(
+        FRequestSpecHelpers::MakeRequest(PrefetchRequestSize));
+
+    TArray<FString> Paths;
+    for (int32 i = 0; i < PrefetchSize; i++)
+    {
+        FString& Path = Paths.Add_GetRef(FPaths::Combine(Directory,
+            FString::Printf(TEXT("Prefetch%d.json"), i)));
+        FFileHelper::SaveArrayToFile(Contents, *Path);
+    }
+
+    auto LoaderFactory = [&Paths](int32 Index)
+    {
+        return MakeUnique<FRequestLoader>(
+            TUniquePtr<IRequestViewProvider>(
+                MakeUnique<FMappedFileRequestProvider>(Paths[Index])),
+            TUniquePtr<IRequestViewDeserializer>(
+                MakeUnique<FJsonRequestDeserializer>()));
+    };
+
+    AddInfo(FString::Printf(TEXT("%d requests of %d bytes, %.0f ms of "
+        "extraction each"), PrefetchSize, Contents.Num(),
+        ExtractionSeconds * 1000.0f));
+
+    double WaitTime = 0.0;
+    double StartTime = FPlatformTime::Seconds();
+    for (int32 i = 0; i < PrefetchSize; i++)
+    {
+        double LoadStartTime = FPlatformTime::Seconds();
+        LoaderFactory(i)->LoadRequest();
+        WaitTime += FPlatformTime::Seconds() - LoadStartTime;
+
+        FPlatformProcess::Sleep(ExtractionSeconds);
+    }
+    double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+    AddInfo(FString::Printf(TEXT("Without prefetching: %.2f ms, %.2f ms "
+        "waiting for loads"), ElapsedTime * 1000.0, WaitTime * 1000.0));
+    double LoadTime = WaitTime;
+
+    for (int32 Depth : PrefetchDepths)
+    {
+        WaitTime = 0.0;
+        StartTime = FPlatformTime::Seconds();
+        {
+            FRequestPrefetchQueue Queue(PrefetchSize, LoaderFactory, Depth);
+            while (Queue.HasNext())
+            {
+                double NextStartTime = FPlatformTime::Seconds();
+                FRequestLoadResult Result = Queue.Next();
+                WaitTime += FPlatformTime::Seconds() - NextStartTime;
+
+                TestTrue(TEXT("Expecting the prefetched request to load"),
+                    Result.Status == ERequestLoadStatus::Loaded);
+
+                FPlatformProcess::Sleep(ExtractionSeconds);
+            }
+        }
+        ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+        AddInfo(FString::Printf(TEXT("Prefetching %d ahead: %.2f ms, "
+            "%.2f ms waiting for loads, %.2f ms of the loads hidden"), Depth,
+            ElapsedTime * 1000.0, WaitTime * 1000.0,
+            (LoadTime - WaitTime) * 1000.0));
+    }
+}
+
+END_DEFINE_SPEC(FRequestLoaderBenchmarkSpec)
+
+void FRequestLoaderBenchmarkSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        AllocationCounter = MakeUnique<FAllocationCounter>();
+        FRequestLoaderAllocationHook::Set(
+            &FAllocationCounter::GetNumberOfThreadAllocations);
+
+        Directory = FPaths::Combine(FPaths::AutomationTransientDir(),
+            TEXT("RequestLoader"));
+        IFileManager::Get().MakeDirectory(*Directory, true);
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+        FRequestLoaderAllocationHook::Set(nullptr);
+        AllocationCounter.Reset();
+    });
+
+    for (int32 Size : RequestSizes)
+    {
+        It(FString::Printf(TEXT("%d bytes"), Size), [this, Size]()
+        {
+            MeasureSize(Size);
+        });
+    }
+
+    It("Batch throughput against concurrency", [this]()
+    {
+        MeasureBatch();
+    });
+
+    It("Latency hidden by prefetching", [this]()
+    {
+        MeasurePrefetch();
+    });
+}
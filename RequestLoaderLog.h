@@ -0,0 +1,12 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Log category shared by `FRequestLoader` and the request providers and
+//deserializers, is defined in RequestLoader.cpp
+DECLARE_LOG_CATEGORY_EXTERN(LogXYZProductRequestLoader, All, All)
@@ -0,0 +1,294 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "version.h"
+#include "ExtractionRequest.h"
+#include "RequestLoader.h"
+#include "JsonRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+
+namespace
+{
+    //Version the plugin doesn't support yet
+    FString GetNewerVersionString()
+    {
+        return FString::Printf(TEXT("%d.0.0"), VERSION_MAJOR + 1);
+    }
+
+    TUniquePtr<FRequestLoader> MakeLoader(const FString& Contents)
+    {
+        return MakeUnique<FRequestLoader>(
+            TUniquePtr<IRequestViewProvider>(
+                MakeUnique<FMemoryRequestProvider>(
+                    FRequestSpecHelpers::ToUtf8(Contents))),
+            TUniquePtr<IRequestViewDeserializer>(
+                MakeUnique<FJsonRequestDeserializer>()));
+    }
+}
+
+BEGIN_DEFINE_SPEC(FRequestLoaderSpec,
+                  "XYZProduct.Loading.RequestLoader",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+FExtractionRequest Request;
+
+FString Json;
+
+void CheckPeekedVersion(const FString& What, const FString& Head,
+    bool bShouldBePeeked)
+{
+    FVersion Version{};
+    bool bIsPeeked = FJsonRequestDeserializer().PeekVersion(
+        FRequestSpecHelpers::ToUtf8(Head), Version);
+
+    TestTrue(What, bIsPeeked == bShouldBePeeked && (!bIsPeeked ||
+        FRequestSpecHelpers::AreEqual(Version,
+            FRequestSpecHelpers::MakeVersion(1, 2, 3))));
+}
+
+END_DEFINE_SPEC(FRequestLoaderSpec)
+
+void FRequestLoaderSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Request = FExtractionRequest();
+        FRequestSpecHelpers::ResizeArrays(Request, 3);
+        Json = FRequestSpecHelpers::ToJson(Request);
+    });
+
+    Describe("Version peek",
+        [this]()
+        {
+            It("Reads the version from the head",
+                [this]()
+                {
+                    CheckPeekedVersion(TEXT("Expecting the leading version"),
+                        TEXT("{\"version\": \"1.2.3\", \"assets\": [{\"pa"),
+                        true);
+                    CheckPeekedVersion(TEXT("Expecting the version after "
+                        "other fields"), TEXT("{\"name\": \"{\\\"version\\\""
+                        "\", \"version\": \"1.2.3\", \"assets\": ["), true);
+                    CheckPeekedVersion(TEXT("Expecting the last version of "
+                        "duplicates, like the DOM"), TEXT("{\"version\": "
+                        "\"9.0.0\", \"Version\": \"1.2.3\", \"assets\": ["),
+                        true);
+                }
+            );
+
+            It("Gives up without a whole version in the head",
+                [this]()
+                {
+                    CheckPeekedVersion(TEXT("Expecting no version in a head "
+                        "cut off in the version"),
+                        TEXT("{\"version\": \"1.2"), false);
+                    CheckPeekedVersion(TEXT("Expecting no version in a head "
+                        "cut off before it"),
+                        TEXT("{\"assets\": [{\"path\": \"/Game/A\"}"), false);
+                    CheckPeekedVersion(TEXT("Expecting no malformed version"),
+                        TEXT("{\"version\": \"1.x.3\"}"), false);
+                }
+            );
+
+            It("Rejects an incompatible request before parsing it",
+                [this]()
+                {
+                    AddExpectedError(TEXT("the plugin version mismatch"),
+                        EAutomationExpectedErrorFlags::Contains, 1);
+
+                    //The body is malformed, parsing it would fail the load
+                    //instead of reporting the mismatch
+                    TUniquePtr<FRequestLoader> Loader =
+                        MakeLoader(FString::Printf(
+                            TEXT("{\"version\": \"%s\", \"assets\": [{]"),
+                            *GetNewerVersionString()));
+
+                    ERequestLoadStatus Status;
+                    TestFalse(TEXT("Expecting no request"),
+                        Loader->LoadRequest(Status).IsValid());
+                    TestTrue(TEXT("Expecting a version mismatch"),
+                        Status == ERequestLoadStatus::VersionMismatch);
+                    TestTrue(TEXT("Expecting the body not to be parsed"),
+                        Loader->GetStats().DeserializeCycles == 0);
+                }
+            );
+
+            It("Checks a version beyond the head after parsing",
+                [this]()
+                {
+                    AddExpectedError(TEXT("the plugin version mismatch"),
+                        EAutomationExpectedErrorFlags::Contains, 1);
+
+                    TUniquePtr<FRequestLoader> Loader =
+                        MakeLoader(FString::Printf(
+                            TEXT("{\"padding\": \"%s\", \"version\": "
+                                 "\"%s\"}"),
+                            *FString::ChrN(8192, TEXT('x')),
+                            *GetNewerVersionString()));
+
+                    ERequestLoadStatus Status;
+                    TestFalse(TEXT("Expecting no request"),
+                        Loader->LoadRequest(Status).IsValid());
+                    TestTrue(TEXT("Expecting a version mismatch"),
+                        Status == ERequestLoadStatus::VersionMismatch);
+                }
+            );
+
+            It("Loads a compatible request",
+                [this]()
+                {
+                    ERequestLoadStatus Status;
+                    TUniquePtr<FExtractionRequest> Result =
+                        MakeLoader(Json)->LoadRequest(Status);
+
+                    TestTrue(TEXT("Expecting the request to load"),
+                        Status == ERequestLoadStatus::Loaded &&
+                        Result.IsValid());
+                }
+            );
+        }
+    );
+
+    Describe("Lazy sections",
+        [this]()
+        {
+            It("Lists a section per property",
+                [this]()
+                {
+                    //The sections refer to the contents the loader holds
+                    TUniquePtr<FRequestLoader> Loader = MakeLoader(Json);
+                    TUniquePtr<IRequestSections> Sections =
+                        Loader->LoadRequestSections();
+                    if (!TestTrue(TEXT("Expecting the sections"),
+                        Sections.IsValid()))
+                    {
+                        return;
+                    }
+
+                    TArray<FName> Names = Sections->GetSectionNames();
+                    for (TFieldIterator<FProperty> It(
+                        FExtractionRequest::StaticStruct()); It; ++It)
+                    {
+                        TestTrue(FString::Printf(TEXT("Expecting the `%s` "
+                            "section"), *It->GetName()),
+                            Names.Contains(It->GetFName()));
+                    }
+                }
+            );
+
+            It("Loads the whole request section by section",
+                [this]()
+                {
+                    TUniquePtr<FRequestLoader> Loader = MakeLoader(Json);
+                    TUniquePtr<IRequestSections> Sections =
+                        Loader->LoadRequestSections();
+                    if (!TestTrue(TEXT("Expecting the sections"),
+                        Sections.IsValid()))
+                    {
+                        return;
+                    }
+
+                    FVersion Version{};
+                    TestTrue(TEXT("Expecting the version"),
+                        Sections->ExtractVersion(Version) &&
+                        FRequestSpecHelpers::AreEqual(Version,
+                            FRequestSpecHelpers::MakeVersion(VERSION_MAJOR,
+                                VERSION_MINOR, VERSION_INDEX)));
+
+                    FExtractionRequest Lazy;
+                    for (FName Name : Sections->GetSectionNames())
+                    {
+                        TestTrue(FString::Printf(TEXT("Expecting the `%s` "
+                            "section to load"), *Name.ToString()),
+                            Sections->LoadSection(Name, Lazy));
+                    }
+
+                    TestEqual(TEXT("Expecting the same request"),
+                        FRequestSpecHelpers::Export(Lazy),
+                        FRequestSpecHelpers::Export(Request));
+                }
+            );
+
+            It("Unloads a section and loads it again",
+                [this]()
+                {
+                    TUniquePtr<FRequestLoader> Loader = MakeLoader(Json);
+                    TUniquePtr<IRequestSections> Sections =
+                        Loader->LoadRequestSections();
+                    TFieldIterator<FArrayProperty> It(
+                        FExtractionRequest::StaticStruct());
+                    if (!TestTrue(TEXT("Expecting the sections"),
+                        Sections.IsValid()) || !It)
+                    {
+                        return;
+                    }
+
+                    FExtractionRequest Lazy;
+                    FName Name = It->GetFName();
+                    TestTrue(TEXT("Expecting the section to load"),
+                        Sections->LoadSection(Name, Lazy));
+                    TestTrue(TEXT("Expecting the section to be set"),
+                        It->Identical_InContainer(&Lazy, &Request));
+
+                    FExtractionRequest Default;
+                    Sections->UnloadSection(Name, Lazy);
+                    TestTrue(TEXT("Expecting the section to be reset"),
+                        It->Identical_InContainer(&Lazy, &Default));
+
+                    TestTrue(TEXT("Expecting the section to load again"),
+                        Sections->LoadSection(Name, Lazy));
+                    TestTrue(TEXT("Expecting the section to be set again"),
+                        It->Identical_InContainer(&Lazy, &Request));
+                }
+            );
+
+            It("Fails to load a missing section",
+                [this]()
+                {
+                    AddExpectedError(TEXT("has no `Missing` section"),
+                        EAutomationExpectedErrorFlags::Contains, 1);
+
+                    TUniquePtr<FRequestLoader> Loader = MakeLoader(Json);
+                    TUniquePtr<IRequestSections> Sections =
+                        Loader->LoadRequestSections();
+                    FExtractionRequest Lazy;
+
+                    TestTrue(TEXT("Expecting the missing section to fail"),
+                        Sections.IsValid() &&
+                        !Sections->LoadSection(TEXT("Missing"), Lazy));
+                }
+            );
+
+            It("Rejects an incompatible request",
+                [this]()
+                {
+                    AddExpectedError(TEXT("the plugin version mismatch"),
+                        EAutomationExpectedErrorFlags::Contains, 1);
+
+                    TestFalse(TEXT("Expecting no sections"), MakeLoader(
+                        FString::Printf(TEXT("{\"version\": \"%s\"}"),
+                            *GetNewerVersionString()))
+                        ->LoadRequestSections().IsValid());
+                }
+            );
+
+            It("Rejects a request without a version",
+                [this]()
+                {
+                    AddExpectedError(TEXT("has no valid `version` field"),
+                        EAutomationExpectedErrorFlags::Contains, 1);
+
+                    TestFalse(TEXT("Expecting no sections"),
+                        MakeLoader(TEXT("{\"assets\": []}"))
+                            ->LoadRequestSections().IsValid());
+                }
+            );
+        }
+    );
+}
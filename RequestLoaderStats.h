@@ -0,0 +1,85 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+#include "Trace/Trace.h"
+
+//Trace channel the loading phases are reported through, is off by default.
+//Enable it with `-trace=cpu,RequestLoader` to see where the start-up of an
+//extraction goes. Each load also reports a `RequestLoader.Load` event with
+//the bytes retrieved and the allocations made
+UE_TRACE_CHANNEL_EXTERN(RequestLoaderChannel)
+
+/**
+ * Counters of the work done by `FRequestLoader`
+ *
+ * Times are measured in CPU cycles, use `FPlatformTime::ToSeconds64()` to
+ * convert them. Allocations are counted only while
+ * `FRequestLoaderAllocationHook` is set, and only the ones made by the
+ * loading thread
+ *
+ * @see FRequestLoader::GetStats()
+ */
+struct FRequestLoaderStats
+{
+    //Count of `LoadRequest()` calls
+    uint64 NumberOfLoads = 0;
+
+    //Total size of the retrieved contents, in bytes for views and in
+    //characters times `sizeof(TCHAR)` for strings
+    uint64 NumberOfBytesRetrieved = 0;
+
+    //Total time spent retrieving the contents from the provider
+    uint64 RetrieveContentsCycles = 0;
+
+    //Total time spent deserializing the contents
+    uint64 DeserializeCycles = 0;
+
+    //Total time spent peeking and extracting the version and checking it
+    uint64 ExtractVersionCycles = 0;
+
+    //Total time spent in `ExtractRequest()`
+    uint64 ExtractRequestCycles = 0;
+
+    uint64 RetrieveContentsAllocations = 0;
+
+    uint64 DeserializeAllocations = 0;
+
+    uint64 ExtractVersionAllocations = 0;
+
+    uint64 ExtractRequestAllocations = 0;
+};
+
+/**
+ * Source of the allocation counters of `FRequestLoaderStats`
+ *
+ * The loader doesn't count allocations itself. Whoever wants the numbers,
+ * e.g. a benchmark running a counting allocator, sets a function which
+ * returns the running count of allocations of the calling thread. Without
+ * one the allocation counters stay at zero
+ */
+class FRequestLoaderAllocationHook
+{
+public:
+    using FGetNumberOfAllocations = uint64 (*)();
+
+    /**
+     * @param Function The function or `nullptr` to stop counting, has to
+     * be callable from any thread
+     */
+    static void Set(FGetNumberOfAllocations Function);
+
+    /**
+     * @return Count of allocations of the calling thread, only differences
+     * between two calls are meaningful
+     */
+    static uint64 GetNumberOfAllocations();
+
+private:
+    static TAtomic<FGetNumberOfAllocations> Function;
+};
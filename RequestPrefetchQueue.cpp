@@ -0,0 +1,68 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "RequestPrefetchQueue.h"
+#include "RequestLoader.h"
+
+FRequestPrefetchQueue::FRequestPrefetchQueue(int32 NumberOfRequests,
+    LoaderFactoryType LoaderFactory, int32 Depth)
+        : NumberOfRequests(NumberOfRequests),
+          LoaderFactory(MoveTemp(LoaderFactory)),
+          Depth(FMath::Max(Depth, 1))
+{
+    Prefetch();
+}
+
+FRequestPrefetchQueue::~FRequestPrefetchQueue()
+{
+    //The loaders are in use by the background loads
+    for (FPrefetch& Prefetch : Prefetches)
+    {
+        Prefetch.Result.Wait();
+    }
+}
+
+bool FRequestPrefetchQueue::HasNext() const
+{
+    return NextHandedOutIndex < NumberOfRequests;
+}
+
+FRequestLoadResult FRequestPrefetchQueue::Next()
+{
+    check(HasNext());
+
+    //The following request starts loading before this one is waited for,
+    //so the background is never idle while the caller waits
+    NextHandedOutIndex++;
+    Prefetch();
+
+    FPrefetch Current = MoveTemp(Prefetches[0]);
+    Prefetches.RemoveAt(0);
+
+    return Current.Result.Consume();
+}
+
+void FRequestPrefetchQueue::Prefetch()
+{
+    //The request handed out last is being extracted by the caller, the
+    //`Depth` ones which follow it are loaded
+    while (NextIndex < NumberOfRequests &&
+        NextIndex - NextHandedOutIndex < Depth)
+    {
+        FPrefetch& Prefetch = Prefetches.AddDefaulted_GetRef();
+        Prefetch.Loader = LoaderFactory(NextIndex++);
+
+        if (Prefetch.Loader.IsValid())
+        {
+            Prefetch.Result = Prefetch.Loader->LoadRequestAsync();
+        }
+        else
+        {
+            TPromise<FRequestLoadResult> Promise;
+            Promise.SetValue(FRequestLoadResult());
+            Prefetch.Result = Promise.GetFuture();
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "RequestLoadStatus.h"
+
+class FRequestLoader;
+
+/**
+ * Hands out requests one by one in order, loading the following ones in
+ * the background while the current one is being extracted
+ *
+ * Is meant to be used by one thread
+ */
+class FRequestPrefetchQueue
+{
+public:
+    //Creates a loader for the request of the given index, is called on
+    //the thread which uses the queue
+    using LoaderFactoryType =
+        TFunction<TUniquePtr<FRequestLoader>(int32 Index)>;
+
+    /**
+     * Starts loading the first requests
+     *
+     * @param NumberOfRequests How many requests are to be handed out
+     * @param LoaderFactory Factory of the loaders
+     * @param Depth How many requests are loaded ahead of the one which has
+     * been handed out last, each of them takes memory until it's handed out
+     */
+    FRequestPrefetchQueue(int32 NumberOfRequests,
+        LoaderFactoryType LoaderFactory, int32 Depth = 1);
+
+    //Waits for the requests which are being loaded
+    ~FRequestPrefetchQueue();
+
+    /**
+     * @return `true` if there are requests which haven't been handed out
+     */
+    bool HasNext() const;
+
+    /**
+     * Hands out the next request, waits for it if it's still being loaded
+     *
+     * @return The request and the outcome of loading it
+     */
+    FRequestLoadResult Next();
+
+private:
+    /**
+     * Request which is being loaded
+     */
+    struct FPrefetch
+    {
+        //Is kept alive until the request is loaded
+        TUniquePtr<FRequestLoader> Loader;
+
+        TFuture<FRequestLoadResult> Result;
+    };
+
+    //Starts loading requests until `Depth` of them are being loaded
+    void Prefetch();
+
+    const int32 NumberOfRequests;
+
+    const LoaderFactoryType LoaderFactory;
+
+    const int32 Depth;
+
+    //Index of the next request to be started
+    int32 NextIndex = 0;
+
+    //Index of the next request to be handed out
+    int32 NextHandedOutIndex = 0;
+
+    //Requests which are being loaded, in order
+    TArray<FPrefetch> Prefetches;
+};
@@ -0,0 +1,213 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformProcess.h"
+#include "Templates/Atomic.h"
+#include "ExtractionRequest.h"
+#include "RequestLoader.h"
+#include "RequestPrefetchQueue.h"
+#include "JsonRequestDeserializer.h"
+#include "RequestSpecHelpers.h"
+
+namespace
+{
+    //Takes a while to hand the contents over and counts the handovers, so
+    //that the loads are still in flight when the queue is destroyed
+    class FSlowRequestProvider : public FMemoryRequestProvider
+    {
+    public:
+        FSlowRequestProvider(TArray<uint8> Contents,
+            TSharedRef<TAtomic<int32>> NumberOfRetrievals)
+                : FMemoryRequestProvider(MoveTemp(Contents)),
+                  NumberOfRetrievals(MoveTemp(NumberOfRetrievals)) {}
+
+        virtual TArrayView<const uint8> RetrieveView() override
+        {
+            FPlatformProcess::Sleep(0.05f);
+            (*NumberOfRetrievals)++;
+
+            return FMemoryRequestProvider::RetrieveView();
+        }
+
+    private:
+        TSharedRef<TAtomic<int32>> NumberOfRetrievals;
+    };
+}
+
+BEGIN_DEFINE_SPEC(FRequestPrefetchQueueSpec,
+                  "XYZProduct.Loading.RequestPrefetchQueue",
+                  EAutomationTestFlags::ProductFilter |
+                  EAutomationTestFlags::ApplicationContextMask)
+
+//Requests of growing sizes, the one of index `i` has `i + 1` elements
+TArray<FExtractionRequest> Requests;
+
+TArray<TArray<uint8>> Contents;
+
+//Indices the factory has been called with, in order
+TArray<int32> CreatedIndices;
+
+FRequestPrefetchQueue::LoaderFactoryType MakeFactory()
+{
+    return [this](int32 Index)
+    {
+        CreatedIndices.Add(Index);
+
+        return MakeUnique<FRequestLoader>(
+            TUniquePtr<IRequestViewProvider>(
+                MakeUnique<FMemoryRequestProvider>(Contents[Index])),
+            TUniquePtr<IRequestViewDeserializer>(
+                MakeUnique<FJsonRequestDeserializer>()));
+    };
+}
+
+/**
+ * Hands all the requests out and checks that each of them is the request
+ * of its index and that no more than `Depth` ones are loaded ahead
+ */
+void CheckHandedOut(const FString& What, int32 Depth)
+{
+    CreatedIndices.Reset();
+    FRequestPrefetchQueue Queue(Requests.Num(), MakeFactory(), Depth);
+    TestEqual(What + TEXT(": expecting the first requests to be loaded"),
+        CreatedIndices.Num(), FMath::Min(Depth, Requests.Num()));
+
+    int32 i = 0;
+    for (; Queue.HasNext() && i < Requests.Num(); i++)
+    {
+        FRequestLoadResult Result = Queue.Next();
+        FString Name = FString::Printf(TEXT("%s: request %d"), *What, i);
+
+        //The handed out request is being extracted, `Depth` ones follow it
+        TestEqual(Name + TEXT(" expecting the loads ahead to be bounded"),
+            CreatedIndices.Num(), FMath::Min(i + 1 + Depth, Requests.Num()));
+        if (TestTrue(Name + TEXT(" expecting to load"),
+            Result.Status == ERequestLoadStatus::Loaded &&
+            Result.Request.IsValid()))
+        {
+            TestEqual(Name + TEXT(" expecting the request of its index"),
+                FRequestSpecHelpers::Export(*Result.Request),
+                FRequestSpecHelpers::Export(Requests[i]));
+        }
+    }
+
+    TestFalse(What + TEXT(": expecting no more requests"), Queue.HasNext());
+    TestEqual(What + TEXT(": expecting every request to be handed out"), i,
+        Requests.Num());
+
+    TArray<int32> ExpectedIndices;
+    for (int32 Index = 0; Index < Requests.Num(); Index++)
+    {
+        ExpectedIndices.Add(Index);
+    }
+    TestTrue(What + TEXT(": expecting the loads to start in order"),
+        CreatedIndices == ExpectedIndices);
+}
+
+END_DEFINE_SPEC(FRequestPrefetchQueueSpec)
+
+void FRequestPrefetchQueueSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Requests.Reset();
+        Contents.Reset();
+        for (int32 i = 0; i < 6; i++)
+        {
+            FExtractionRequest& Request = Requests.AddDefaulted_GetRef();
+            FRequestSpecHelpers::ResizeArrays(Request, i + 1);
+            Contents.Add(FRequestSpecHelpers::ToUtf8(
+                FRequestSpecHelpers::ToJson(Request)));
+        }
+    });
+
+    It("Hands the requests out in order",
+        [this]()
+        {
+            CheckHandedOut(TEXT("Depth of 1"), 1);
+            CheckHandedOut(TEXT("Depth of 3"), 3);
+        }
+    );
+
+    It("Bounds the depth",
+        [this]()
+        {
+            //A depth below one still loads the next request ahead
+            CreatedIndices.Reset();
+            FRequestPrefetchQueue Queue(Requests.Num(), MakeFactory(), 0);
+            TestEqual(TEXT("Expecting a depth of at least 1"),
+                CreatedIndices.Num(), 1);
+
+            CheckHandedOut(TEXT("Depth beyond the requests"),
+                Requests.Num() + 2);
+
+            CreatedIndices.Reset();
+            FRequestPrefetchQueue EmptyQueue(0, MakeFactory(), 2);
+            TestFalse(TEXT("Expecting no requests in an empty queue"),
+                EmptyQueue.HasNext());
+            TestEqual(TEXT("Expecting no loads for an empty queue"),
+                CreatedIndices.Num(), 0);
+        }
+    );
+
+    It("Fails a request without a loader",
+        [this]()
+        {
+            FRequestPrefetchQueue::LoaderFactoryType Factory = MakeFactory();
+            FRequestPrefetchQueue Queue(Requests.Num(),
+                [&Factory](int32 Index) -> TUniquePtr<FRequestLoader>
+                {
+                    return Index == 1 ? nullptr : Factory(Index);
+                }, 2);
+
+            for (int32 i = 0; Queue.HasNext(); i++)
+            {
+                FRequestLoadResult Result = Queue.Next();
+                if (i == 1)
+                {
+                    TestTrue(TEXT("Expecting the request without a loader "
+                        "to fail"), Result.Status ==
+                        ERequestLoadStatus::Failed &&
+                        !Result.Request.IsValid());
+                }
+                else
+                {
+                    TestTrue(FString::Printf(TEXT("Expecting request %d to "
+                        "load"), i), Result.Status ==
+                        ERequestLoadStatus::Loaded);
+                }
+            }
+        }
+    );
+
+    It("Waits for the loads in flight when destroyed",
+        [this]()
+        {
+            TSharedRef<TAtomic<int32>> NumberOfRetrievals =
+                MakeShared<TAtomic<int32>>(0);
+            {
+                FRequestPrefetchQueue Queue(Requests.Num(),
+                    [this, NumberOfRetrievals](int32 Index)
+                    {
+                        return MakeUnique<FRequestLoader>(
+                            TUniquePtr<IRequestViewProvider>(
+                                MakeUnique<FSlowRequestProvider>(
+                                    Contents[Index], NumberOfRetrievals)),
+                            TUniquePtr<IRequestViewDeserializer>(
+                                MakeUnique<FJsonRequestDeserializer>()));
+                    }, 3);
+                Queue.Next();
+            }
+
+            //The first request and the 3 loaded after it have finished, the
+            //loaders weren't destroyed under the background loads
+            TestEqual(TEXT("Expecting the loads in flight to finish"),
+                NumberOfRetrievals->Load(), 4);
+        }
+    );
+}
@@ -0,0 +1,116 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "RequestSpecHelpers.h"
+#include "Misc/FileHelper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "JsonObjectConverter.h"
+#include "version.h"
+#include "ExtractionRequest.h"
+#include "JsonRequestDeserializer.h"
+
+namespace
+{
+    //Count of elements the size of an element is estimated with
+    constexpr int32 SampleNumberOfElements = 16;
+}
+
+void FRequestSpecHelpers::ResizeArrays(FExtractionRequest& Request,
+    int32 NumberOfElements)
+{
+    for (TFieldIterator<FArrayProperty> It(
+        FExtractionRequest::StaticStruct()); It; ++It)
+    {
+        FScriptArrayHelper Helper(*It,
+            It->ContainerPtrToValuePtr<void>(&Request));
+        Helper.Resize(NumberOfElements);
+    }
+}
+
+FString FRequestSpecHelpers::ToJson(const FExtractionRequest& Request)
+{
+    TSharedPtr<FJsonObject> Object =
+        FJsonObjectConverter::UStructToJsonObject(Request);
+    Object->SetStringField(FJsonRequestDeserializer::kVersionField,
+        FString::Printf(TEXT("%d.%d.%d"), VERSION_MAJOR, VERSION_MINOR,
+            VERSION_INDEX));
+
+    FString Json;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+    FJsonSerializer::Serialize(Object.ToSharedRef(), Writer);
+
+    return Json;
+}
+
+FString FRequestSpecHelpers::MakeRequest(int32 Size)
+{
+    FExtractionRequest Request;
+    int32 BaseSize = ToJson(Request).Len();
+
+    ResizeArrays(Request, SampleNumberOfElements);
+    int32 ElementSize = FMath::Max(1,
+        (ToJson(Request).Len() - BaseSize) / SampleNumberOfElements);
+
+    ResizeArrays(Request, FMath::Max(0, Size - BaseSize) / ElementSize);
+
+    return ToJson(Request);
+}
+
+TArray<uint8> FRequestSpecHelpers::ToUtf8(const FString& Contents)
+{
+    FTCHARToUTF8 Utf8(*Contents);
+
+    return TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()),
+        Utf8.Length());
+}
+
+FString FRequestSpecHelpers::Export(const UStruct* Struct,
+    const void* Value)
+{
+    FString Json;
+    FJsonObjectConverter::UStructToJsonObjectString(Struct, Value, Json, 0,
+        0);
+
+    return Json;
+}
+
+FString FRequestSpecHelpers::Export(const FExtractionRequest& Request)
+{
+    return Export(FExtractionRequest::StaticStruct(), &Request);
+}
+
+FVersion FRequestSpecHelpers::MakeVersion(int32 Major, int32 Minor,
+    int32 Index)
+{
+    FVersion Version{};
+    Version.Major = Major;
+    Version.Minor = Minor;
+    Version.Index = Index;
+
+    return Version;
+}
+
+bool FRequestSpecHelpers::AreEqual(const FVersion& A, const FVersion& B)
+{
+    return A.Major == B.Major && A.Minor == B.Minor && A.Index == B.Index;
+}
+
+FMemoryRequestProvider::FMemoryRequestProvider(TArray<uint8> Contents)
+    : Contents(MoveTemp(Contents)) {}
+
+FString FMemoryRequestProvider::RetrieveContents()
+{
+    FString Result;
+    FFileHelper::BufferToString(Result, Contents.GetData(), Contents.Num());
+
+    return Result;
+}
+
+TArrayView<const uint8> FMemoryRequestProvider::RetrieveView()
+{
+    return Contents;
+}
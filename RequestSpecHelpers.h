@@ -0,0 +1,73 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRequestViewProvider.h"
+
+struct FExtractionRequest;
+struct FVersion;
+
+/**
+ * Builders of synthetic requests shared by the request loading specs and
+ * benchmarks, are meant for tests only
+ */
+class FRequestSpecHelpers
+{
+public:
+    /**
+     * Sets the size of every array of the request, that is the size of the
+     * request grows with the count of elements the way real requests grow
+     */
+    static void ResizeArrays(FExtractionRequest& Request,
+        int32 NumberOfElements);
+
+    /**
+     * Serializes the request into JSON together with the current version
+     */
+    static FString ToJson(const FExtractionRequest& Request);
+
+    /**
+     * Builds a JSON request of roughly the given size out of default
+     * elements of the arrays of `FExtractionRequest`
+     *
+     * The requests are only as big as the arrays of `FExtractionRequest`
+     * allow: a request without arrays is built at its natural size
+     */
+    static FString MakeRequest(int32 Size);
+
+    /**
+     * @return UTF-8 encoded contents without BOM, the way providers hand
+     * them over
+     */
+    static TArray<uint8> ToUtf8(const FString& Contents);
+
+    /**
+     * Exports a struct back into JSON, so that two structs are compared
+     * property by property and a difference is readable in the log
+     */
+    static FString Export(const UStruct* Struct, const void* Value);
+
+    static FString Export(const FExtractionRequest& Request);
+
+    static FVersion MakeVersion(int32 Major, int32 Minor, int32 Index);
+
+    static bool AreEqual(const FVersion& A, const FVersion& B);
+};
+
+//Hands over bytes held in memory, stands in for a mapped file
+class FMemoryRequestProvider : public IRequestViewProvider
+{
+public:
+    explicit FMemoryRequestProvider(TArray<uint8> Contents);
+
+    virtual FString RetrieveContents() override;
+
+    virtual TArrayView<const uint8> RetrieveView() override;
+
+private:
+    TArray<uint8> Contents;
+};
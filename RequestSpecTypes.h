@@ -0,0 +1,99 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RequestSpecTypes.generated.h"
+
+//Kind of an element, is written by its name or by its value
+UENUM()
+enum class ERequestSpecKind : uint8
+{
+    Texture,
+    Mesh,
+    Sound
+};
+
+//Element of the arrays of the spec document
+USTRUCT()
+struct FRequestSpecElement
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FString Path;
+
+    UPROPERTY()
+    int64 Size = 0;
+
+    UPROPERTY()
+    ERequestSpecKind Kind = ERequestSpecKind::Texture;
+
+    UPROPERTY()
+    TArray<FName> Tags;
+};
+
+//Struct holding an array of structs, makes the arrays nest
+USTRUCT()
+struct FRequestSpecGroup
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FString Name;
+
+    UPROPERTY()
+    TArray<FRequestSpecElement> Elements;
+};
+
+/**
+ * Document the JSON deserialization paths are compared on, is meant for
+ * tests only
+ *
+ * Has properties which `FArenaJsonReader` converts itself as well as ones
+ * it hands over to `FJsonObjectConverter`
+ */
+USTRUCT()
+struct FRequestSpecDocument
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FString Name;
+
+    UPROPERTY()
+    FName Category;
+
+    UPROPERTY()
+    FText Description;
+
+    UPROPERTY()
+    bool bIsEnabled = false;
+
+    UPROPERTY()
+    int32 Count = 0;
+
+    UPROPERTY()
+    double Weight = 0.0;
+
+    UPROPERTY()
+    ERequestSpecKind Kind = ERequestSpecKind::Texture;
+
+    UPROPERTY()
+    TArray<ERequestSpecKind> Kinds;
+
+    UPROPERTY()
+    FRequestSpecElement Main;
+
+    UPROPERTY()
+    TArray<FRequestSpecElement> Elements;
+
+    UPROPERTY()
+    TArray<FRequestSpecGroup> Groups;
+
+    UPROPERTY()
+    TMap<FString, int32> Limits;
+};
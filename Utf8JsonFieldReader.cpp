@@ -0,0 +1,477 @@
+//Flying Wild Hog. All rights reserved
+
+#include "Utf8JsonFieldReader.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	//Replacement character for malformed UTF-8 sequences
+	constexpr uint32 kReplacementCharacter = 0xFFFD;
+
+	bool IsWhitespace(uint8 Character)
+	{
+		return Character == ' ' || Character == '\t' || Character == '\n' ||
+			Character == '\r';
+	}
+
+	void AppendCodePoint(TArray<TCHAR>& Characters, uint32 CodePoint)
+	{
+		if (sizeof(TCHAR) == 2 && CodePoint > 0xFFFF)
+		{
+			CodePoint -= 0x10000;
+			Characters.Add(static_cast<TCHAR>(0xD800 + (CodePoint >> 10)));
+			Characters.Add(static_cast<TCHAR>(0xDC00 + (CodePoint & 0x3FF)));
+		}
+		else
+		{
+			Characters.Add(static_cast<TCHAR>(CodePoint));
+		}
+	}
+
+	/**
+	* Decodes one UTF-8 encoded code point starting at `Offset`
+	*
+	* @return Count of consumed bytes, always at least one
+	*/
+	int32 DecodeUtf8(TArrayView<const uint8> Bytes, int32 Offset,
+		int32 End, uint32& OutCodePoint)
+	{
+		uint8 Lead = Bytes[Offset];
+		int32 Length;
+		if (Lead < 0x80)
+		{
+			OutCodePoint = Lead;
+
+			return 1;
+		}
+		else if ((Lead & 0xE0) == 0xC0)
+		{
+			OutCodePoint = Lead & 0x1F;
+			Length = 2;
+		}
+		else if ((Lead & 0xF0) == 0xE0)
+		{
+			OutCodePoint = Lead & 0x0F;
+			Length = 3;
+		}
+		else if ((Lead & 0xF8) == 0xF0)
+		{
+			OutCodePoint = Lead & 0x07;
+			Length = 4;
+		}
+		else
+		{
+			OutCodePoint = kReplacementCharacter;
+
+			return 1;
+		}
+
+		if (Offset + Length > End)
+		{
+			OutCodePoint = kReplacementCharacter;
+
+			return 1;
+		}
+
+		for (int32 i = 1; i < Length; i++)
+		{
+			uint8 Continuation = Bytes[Offset + i];
+			if ((Continuation & 0xC0) != 0x80)
+			{
+				OutCodePoint = kReplacementCharacter;
+
+				return 1;
+			}
+
+			OutCodePoint = (OutCodePoint << 6) | (Continuation & 0x3F);
+		}
+
+		return Length;
+	}
+}
+
+FUtf8JsonFieldReader::FUtf8JsonFieldReader(TArrayView<const uint8> Content)
+	: Content(Content) {}
+
+bool FUtf8JsonFieldReader::TryGetStringField(const TCHAR* Key,
+	FString& OutValue) const
+{
+	int32 Offset = FindValue(Key);
+	if (Offset == INDEX_NONE || Content[Offset] != '"')
+	{
+		return false;
+	}
+
+	int32 End = SkipString(Offset);
+	if (End == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// the quotes aren't a part of the value
+	return DecodeString(Content.Slice(Offset + 1, End - Offset - 2),
+		OutValue);
+}
+
+bool FUtf8JsonFieldReader::TryGetNumberField(const TCHAR* Key,
+	int64& OutValue) const
+{
+	int32 Offset = FindValue(Key);
+	if (Offset == INDEX_NONE)
+	{
+		return false;
+	}
+
+	bool bIsNegative = Content[Offset] == '-';
+	if (bIsNegative)
+	{
+		Offset++;
+	}
+
+	int64 Value = 0;
+	int32 NumberOfDigits = 0;
+	for (; Offset < Content.Num() && FChar::IsDigit(Content[Offset]);
+		Offset++, NumberOfDigits++)
+	{
+		Value = Value * 10 + (Content[Offset] - '0');
+	}
+
+	if (NumberOfDigits == 0)
+	{
+		return false;
+	}
+
+	OutValue = bIsNegative ? -Value : Value;
+
+	return true;
+}
+
+int64 FUtf8JsonFieldReader::GetIntegerField(const TCHAR* Key) const
+{
+	int64 Value = 0;
+	TryGetNumberField(Key, Value);
+
+	return Value;
+}
+
+bool FUtf8JsonFieldReader::TryGetRawFields(TArray<FRawField>& OutFields) const
+{
+	const int32 Size = Content.Num();
+
+	TArray<FRawField> Fields;
+
+	int32 Offset = SkipWhitespace(0);
+	if (Offset >= Size || Content[Offset] != '{')
+	{
+		return false;
+	}
+
+	Offset = SkipWhitespace(Offset + 1);
+	while (Offset < Size && Content[Offset] == '"')
+	{
+		const int32 FieldOffset = Offset;
+
+		int32 KeyEnd = SkipString(Offset);
+		if (KeyEnd == INDEX_NONE)
+		{
+			return false;
+		}
+
+		FRawField& Field = Fields.AddDefaulted_GetRef();
+		TArray<TCHAR>& Characters = Field.Key.GetCharArray();
+		Characters.Reserve(KeyEnd - Offset - 1);
+		for (int32 i = Offset + 1; i < KeyEnd - 1;)
+		{
+			uint32 CodePoint;
+			i += DecodeUtf8(Content, i, KeyEnd - 1, CodePoint);
+			AppendCodePoint(Characters, CodePoint);
+		}
+		Characters.Add(TEXT('\0'));
+
+		Offset = SkipWhitespace(KeyEnd);
+		if (Offset >= Size || Content[Offset] != ':')
+		{
+			return false;
+		}
+
+		Offset = SkipWhitespace(Offset + 1);
+		if (Offset >= Size)
+		{
+			return false;
+		}
+
+		Offset = SkipValue(Offset);
+		if (Offset == INDEX_NONE)
+		{
+			return false;
+		}
+
+		Field.Field = Content.Slice(FieldOffset, Offset - FieldOffset);
+
+		Offset = SkipWhitespace(Offset);
+		if (Offset < Size && Content[Offset] == '}')
+		{
+			OutFields = MoveTemp(Fields);
+
+			return true;
+		}
+
+		if (Offset >= Size || Content[Offset] != ',')
+		{
+			return false;
+		}
+
+		Offset = SkipWhitespace(Offset + 1);
+	}
+
+	// an empty object
+	if (Fields.Num() == 0 && Offset < Size && Content[Offset] == '}')
+	{
+		OutFields.Reset();
+
+		return true;
+	}
+
+	return false;
+}
+
+bool FUtf8JsonFieldReader::DecodeString(TArrayView<const uint8> String,
+	FString& OutValue)
+{
+	const int32 End = String.Num();
+
+	// the value is decoded straight into the resulting string, UTF-8 never
+	// takes less code units than UTF-16, so one reservation is enough
+	FString Value;
+	TArray<TCHAR>& Characters = Value.GetCharArray();
+	Characters.Reserve(End + 1);
+
+	for (int32 i = 0; i < End;)
+	{
+		if (String[i] != '\\')
+		{
+			uint32 CodePoint;
+			i += DecodeUtf8(String, i, End, CodePoint);
+			AppendCodePoint(Characters, CodePoint);
+
+			continue;
+		}
+
+		if (i + 1 >= End)
+		{
+			return false;
+		}
+
+		uint8 Escaped = String[i + 1];
+		i += 2;
+		switch (Escaped)
+		{
+		case 'b': Characters.Add(TEXT('\b')); break;
+		case 'f': Characters.Add(TEXT('\f')); break;
+		case 'n': Characters.Add(TEXT('\n')); break;
+		case 'r': Characters.Add(TEXT('\r')); break;
+		case 't': Characters.Add(TEXT('\t')); break;
+		case 'u':
+		{
+			// `\uXXXX` is a UTF-16 code unit, surrogates come in pairs of
+			// escapes and are appended as they are
+			if (i + 4 > End)
+			{
+				return false;
+			}
+
+			uint32 CodeUnit = 0;
+			for (int32 j = 0; j < 4; j++)
+			{
+				TCHAR Digit = static_cast<TCHAR>(String[i + j]);
+				if (!FChar::IsHexDigit(Digit))
+				{
+					return false;
+				}
+
+				CodeUnit = (CodeUnit << 4) | FParse::HexDigit(Digit);
+			}
+			i += 4;
+
+			Characters.Add(static_cast<TCHAR>(CodeUnit));
+			break;
+		}
+		default:
+			// `"`, `\` and `/` stand for themselves
+			Characters.Add(static_cast<TCHAR>(Escaped));
+			break;
+		}
+	}
+
+	if (Characters.Num() > 0)
+	{
+		Characters.Add(TEXT('\0'));
+	}
+
+	OutValue = MoveTemp(Value);
+
+	return true;
+}
+
+TSharedPtr<FJsonObject> FUtf8JsonFieldReader::ToJsonObject() const
+{
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Content.GetData()),
+		Content.Num());
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<TCHAR>> JsonReader =
+		TJsonReaderFactory<TCHAR>::Create(
+			FString(Converter.Length(), Converter.Get()));
+	FJsonSerializer::Deserialize(JsonReader, JsonObject);
+
+	return JsonObject;
+}
+
+int32 FUtf8JsonFieldReader::FindValue(const TCHAR* Key) const
+{
+	const int32 Size = Content.Num();
+	const int32 KeyLength = FCString::Strlen(Key);
+
+	int32 Offset = SkipWhitespace(0);
+	if (Offset >= Size || Content[Offset] != '{')
+	{
+		return INDEX_NONE;
+	}
+
+	// a later field of the same name replaces the earlier one the same way
+	// it does in `FJsonObject`, so the scan goes on after a match
+	int32 Match = INDEX_NONE;
+	Offset = SkipWhitespace(Offset + 1);
+	while (Offset < Size && Content[Offset] == '"')
+	{
+		int32 KeyEnd = SkipString(Offset);
+		if (KeyEnd == INDEX_NONE)
+		{
+			return Match;
+		}
+
+		// keys with escapes never match, the requested keys are plain ASCII.
+		// The case is ignored like in the keys of `FJsonObject`
+		bool bDoesKeyMatch = KeyEnd - Offset - 2 == KeyLength;
+		for (int32 i = 0; bDoesKeyMatch && i < KeyLength; i++)
+		{
+			bDoesKeyMatch =
+				FChar::ToLower(static_cast<TCHAR>(Content[Offset + 1 + i])) ==
+				FChar::ToLower(Key[i]);
+		}
+
+		Offset = SkipWhitespace(KeyEnd);
+		if (Offset >= Size || Content[Offset] != ':')
+		{
+			return Match;
+		}
+
+		Offset = SkipWhitespace(Offset + 1);
+		if (Offset >= Size)
+		{
+			return Match;
+		}
+
+		if (bDoesKeyMatch)
+		{
+			Match = Offset;
+		}
+
+		Offset = SkipValue(Offset);
+		if (Offset == INDEX_NONE)
+		{
+			return Match;
+		}
+
+		Offset = SkipWhitespace(Offset);
+		if (Offset >= Size || Content[Offset] != ',')
+		{
+			// either the end of the object or garbage
+			return Match;
+		}
+
+		Offset = SkipWhitespace(Offset + 1);
+	}
+
+	return Match;
+}
+
+int32 FUtf8JsonFieldReader::SkipWhitespace(int32 Offset) const
+{
+	while (Offset < Content.Num() && IsWhitespace(Content[Offset]))
+	{
+		Offset++;
+	}
+
+	return Offset;
+}
+
+int32 FUtf8JsonFieldReader::SkipString(int32 Offset) const
+{
+	for (int32 i = Offset + 1; i < Content.Num(); i++)
+	{
+		if (Content[i] == '\\')
+		{
+			i++;
+		}
+		else if (Content[i] == '"')
+		{
+			return i + 1;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+int32 FUtf8JsonFieldReader::SkipValue(int32 Offset) const
+{
+	uint8 First = Content[Offset];
+	if (First == '"')
+	{
+		return SkipString(Offset);
+	}
+
+	if (First == '{' || First == '[')
+	{
+		int32 Depth = 0;
+		for (int32 i = Offset; i < Content.Num();)
+		{
+			uint8 Character = Content[i];
+			if (Character == '"')
+			{
+				i = SkipString(i);
+				if (i == INDEX_NONE)
+				{
+					return INDEX_NONE;
+				}
+
+				continue;
+			}
+
+			if (Character == '{' || Character == '[')
+			{
+				Depth++;
+			}
+			else if ((Character == '}' || Character == ']') && --Depth == 0)
+			{
+				return i + 1;
+			}
+
+			i++;
+		}
+
+		return INDEX_NONE;
+	}
+
+	// a number or a literal, ends where the next token begins
+	int32 End = Offset;
+	while (End < Content.Num() && Content[End] != ',' &&
+		Content[End] != '}' && Content[End] != ']' &&
+		!IsWhitespace(Content[End]))
+	{
+		End++;
+	}
+
+	return End > Offset ? End : INDEX_NONE;
+}
@@ -0,0 +1,142 @@
+//Flying Wild Hog. All rights reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+/**
+* Reads top-level fields of a JSON object straight from UTF-8 bytes
+*
+* No DOM is built and the bytes are neither copied nor widened: each lookup
+* scans the object once skipping the values of other fields. Only the value
+* which is asked for is converted. Is meant for small responses of which
+* only a couple of fields are read, use `ToJsonObject()` for anything else
+*
+* Fields are looked up the way `FJsonObject` does: names are compared
+* case-insensitively and of duplicate fields the last one is read
+*
+* Doesn't own the bytes, they must outlive the reader
+*/
+class FUtf8JsonFieldReader
+{
+public:
+	/**
+	* Top-level field as it's written
+	*/
+	struct FRawField
+	{
+		//Name of the field, escape sequences are kept as they are
+		FString Key;
+
+		//Bytes of the whole field: the quoted key, the colon and the value
+		TArrayView<const uint8> Field;
+	};
+
+	/**
+	* @param Content UTF-8 encoded JSON, may be malformed
+	*/
+	explicit FUtf8JsonFieldReader(TArrayView<const uint8> Content);
+
+	/**
+	* Looks for a top-level string field
+	*
+	* @param Key Name of the field, must be ASCII
+	* @param OutValue Unescaped value of the field, is set only on success
+	* @return `true` if the field is present and is a string, `false` -
+	* otherwise (including the case of malformed JSON)
+	*/
+	bool TryGetStringField(const TCHAR* Key, FString& OutValue) const;
+
+	bool TryGetStringField(const FString& Key, FString& OutValue) const
+	{
+		return TryGetStringField(*Key, OutValue);
+	}
+
+	/**
+	* Looks for a top-level numeric field. Only the integer part of the
+	* number is read
+	*
+	* @param Key Name of the field, must be ASCII
+	* @param OutValue Value of the field, is set only on success
+	* @return `true` if the field is present and is a number, `false` -
+	* otherwise (including the case of malformed JSON)
+	*/
+	bool TryGetNumberField(const TCHAR* Key, int64& OutValue) const;
+
+	bool TryGetNumberField(const FString& Key, int64& OutValue) const
+	{
+		return TryGetNumberField(*Key, OutValue);
+	}
+
+	/**
+	* Same as `TryGetNumberField()` but returns `0` if the field can't be
+	* read, the same way `FJsonObject::GetIntegerField()` does
+	*
+	* @param Key Name of the field, must be ASCII
+	* @return Value of the field or `0`
+	*/
+	int64 GetIntegerField(const TCHAR* Key) const;
+
+	int64 GetIntegerField(const FString& Key) const
+	{
+		return GetIntegerField(*Key);
+	}
+
+	/**
+	* Lists the top-level fields without converting their values, e.g. to
+	* parse them one by one later
+	*
+	* @param OutFields The fields in the order they are written, is set only
+	* on success
+	* @return `true` if the content is a well-formed object at the top
+	* level, `false` - otherwise
+	*/
+	bool TryGetRawFields(TArray<FRawField>& OutFields) const;
+
+	/**
+	* Unescapes and decodes a string value
+	*
+	* @param String UTF-8 encoded bytes between the quotes of the value
+	* @param OutValue The value, is set only on success
+	* @return `false` if an escape sequence is malformed
+	*/
+	static bool DecodeString(TArrayView<const uint8> String,
+		FString& OutValue);
+
+	/**
+	* Parses the whole content into a DOM, for the responses which have to be
+	* inspected deeper than the top level
+	*
+	* @return The parsed object or `nullptr` if the content is malformed
+	*/
+	TSharedPtr<FJsonObject> ToJsonObject() const;
+
+private:
+	/**
+	* Finds the value of a top-level field
+	*
+	* Of the fields of the same name, compared case-insensitively, the last
+	* one is used as `FJsonObject` does. Content which is cut off or
+	* malformed is read up to where it breaks, so the last match before that
+	* point is used
+	*
+	* @param Key Name of the field
+	* @return Offset of the first byte of the value or `INDEX_NONE` if the
+	* field isn't found before the end or the break of the content
+	*/
+	int32 FindValue(const TCHAR* Key) const;
+
+	int32 SkipWhitespace(int32 Offset) const;
+
+	//Returns offset of the byte following the string which starts at
+	//`Offset` or `INDEX_NONE` if the string isn't terminated
+	int32 SkipString(int32 Offset) const;
+
+	//Returns offset of the byte following the value which starts at
+	//`Offset` or `INDEX_NONE` if the value is malformed
+	int32 SkipValue(int32 Offset) const;
+
+	TArrayView<const uint8> Content;
+};
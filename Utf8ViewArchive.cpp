@@ -0,0 +1,156 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#include "Utf8ViewArchive.h"
+
+namespace
+{
+    constexpr uint32 ReplacementCharacter = 0xFFFD;
+}
+
+FUtf8ViewArchive::FUtf8ViewArchive(TArrayView<const uint8> Bytes)
+    : Bytes(Bytes)
+{
+    SetIsLoading(true);
+    SetIsPersistent(false);
+}
+
+FUtf8ViewArchive::FUtf8ViewArchive(TArrayView<const uint8> Bytes,
+    TCHAR Opening, TCHAR Closing)
+    : FUtf8ViewArchive(Bytes)
+{
+    this->Opening = Opening;
+    this->Closing = Closing;
+}
+
+void FUtf8ViewArchive::Serialize(void* Data, int64 Length)
+{
+    check(Length % sizeof(TCHAR) == 0);
+
+    TCHAR* Characters = static_cast<TCHAR*>(Data);
+    for (int64 i = 0; i < Length / static_cast<int64>(sizeof(TCHAR)); i++)
+    {
+        if (AtEnd())
+        {
+            SetError();
+            return;
+        }
+
+        Characters[i] = ReadCharacter();
+    }
+}
+
+int64 FUtf8ViewArchive::Tell()
+{
+    return Offset;
+}
+
+int64 FUtf8ViewArchive::TotalSize()
+{
+    return Bytes.Num();
+}
+
+bool FUtf8ViewArchive::AtEnd()
+{
+    return Offset >= Bytes.Num() && PendingLowSurrogate == 0 &&
+        Opening == 0 && Closing == 0;
+}
+
+FString FUtf8ViewArchive::GetArchiveName() const
+{
+    return TEXT("FUtf8ViewArchive");
+}
+
+TCHAR FUtf8ViewArchive::ReadCharacter()
+{
+    if (Opening != 0)
+    {
+        TCHAR Character = Opening;
+        Opening = 0;
+
+        return Character;
+    }
+
+    if (Offset >= Bytes.Num() && PendingLowSurrogate == 0)
+    {
+        TCHAR Character = Closing;
+        Closing = 0;
+
+        return Character;
+    }
+
+    if (PendingLowSurrogate != 0)
+    {
+        TCHAR Character = PendingLowSurrogate;
+        PendingLowSurrogate = 0;
+
+        return Character;
+    }
+
+    //ASCII makes up most of a request, so it goes first
+    uint8 Lead = Bytes[Offset];
+    if (Lead < 0x80)
+    {
+        Offset++;
+
+        return static_cast<TCHAR>(Lead);
+    }
+
+    int32 Length;
+    uint32 CodePoint;
+    if ((Lead & 0xE0) == 0xC0)
+    {
+        Length = 2;
+        CodePoint = Lead & 0x1F;
+    }
+    else if ((Lead & 0xF0) == 0xE0)
+    {
+        Length = 3;
+        CodePoint = Lead & 0x0F;
+    }
+    else if ((Lead & 0xF8) == 0xF0)
+    {
+        Length = 4;
+        CodePoint = Lead & 0x07;
+    }
+    else
+    {
+        Offset++;
+
+        return static_cast<TCHAR>(ReplacementCharacter);
+    }
+
+    if (Offset + Length > Bytes.Num())
+    {
+        Offset++;
+
+        return static_cast<TCHAR>(ReplacementCharacter);
+    }
+
+    for (int32 i = 1; i < Length; i++)
+    {
+        uint8 Continuation = Bytes[Offset + i];
+        if ((Continuation & 0xC0) != 0x80)
+        {
+            Offset++;
+
+            return static_cast<TCHAR>(ReplacementCharacter);
+        }
+
+        CodePoint = (CodePoint << 6) | (Continuation & 0x3F);
+    }
+    Offset += Length;
+
+    if (sizeof(TCHAR) == 2 && CodePoint > 0xFFFF)
+    {
+        CodePoint -= 0x10000;
+        PendingLowSurrogate =
+            static_cast<TCHAR>(0xDC00 + (CodePoint & 0x3FF));
+
+        return static_cast<TCHAR>(0xD800 + (CodePoint >> 10));
+    }
+
+    return static_cast<TCHAR>(CodePoint);
+}
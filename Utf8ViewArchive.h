@@ -0,0 +1,62 @@
+/*
+ Copyright © 2022, XYZ Sp. z o.o. All rights reserved.
+ For any additional information refer to https://XYZ.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+
+/**
+ * Loading archive which serves `TCHAR`s decoded on the fly from a view of
+ * UTF-8 bytes
+ *
+ * Lets `TJsonReader<TCHAR>` parse UTF-8 contents in place: nothing is
+ * widened or copied up front. Only whole `TCHAR`s may be serialized, which
+ * is what the JSON reader does. Malformed sequences are decoded as U+FFFD
+ *
+ * Doesn't own the bytes, they must outlive the archive
+ */
+class FUtf8ViewArchive : public FArchive
+{
+public:
+    explicit FUtf8ViewArchive(TArrayView<const uint8> Bytes);
+
+    /**
+     * Serves the bytes enclosed in two extra characters, e.g. to parse a
+     * single field cut out of an object as an object of its own
+     *
+     * @param Bytes The bytes
+     * @param Opening Character which is served before the bytes
+     * @param Closing Character which is served after the bytes
+     */
+    FUtf8ViewArchive(TArrayView<const uint8> Bytes, TCHAR Opening,
+        TCHAR Closing);
+
+    virtual void Serialize(void* Data, int64 Length) override;
+
+    virtual int64 Tell() override;
+
+    virtual int64 TotalSize() override;
+
+    virtual bool AtEnd() override;
+
+    virtual FString GetArchiveName() const override;
+
+private:
+    TCHAR ReadCharacter();
+
+    TArrayView<const uint8> Bytes;
+
+    int32 Offset = 0;
+
+    //Enclosing characters which are yet to be served, `0` if there are none
+    TCHAR Opening = 0;
+
+    TCHAR Closing = 0;
+
+    //Second half of a surrogate pair which is to be served next, `0` if
+    //there is none. Is used where `TCHAR` is UTF-16 only
+    TCHAR PendingLowSurrogate = 0;
+};